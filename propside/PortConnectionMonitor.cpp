@@ -21,60 +21,295 @@
 #include "PortConnectionMonitor.h"
 #include "qextserialenumerator.h"
 
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+/*
+ * udev creates a node and then changes its owner and mode.
+ * Wait for /dev to be quiet this long before enumerating.
+ */
+#define HOTPLUG_DEBOUNCE_MS 250
+#endif
+
 PortConnectionMonitor::PortConnectionMonitor(QObject *parent) :
     QThread(parent)
 {
     running = true;
+    wakePipe[0] = -1;
+    wakePipe[1] = -1;
+#ifdef Q_OS_LINUX
+    if(::pipe(wakePipe) < 0) {
+        wakePipe[0] = -1;
+        wakePipe[1] = -1;
+    }
+#endif
     start();
 }
 
+PortConnectionMonitor::~PortConnectionMonitor()
+{
+#ifdef Q_OS_LINUX
+    if(wakePipe[0] > -1) ::close(wakePipe[0]);
+    if(wakePipe[1] > -1) ::close(wakePipe[1]);
+#endif
+}
+
 void PortConnectionMonitor::stop()
 {
     running = false;
-    this->msleep(600); // let run finish. don't terminate it.
+#ifdef Q_OS_LINUX
+    wake(0);
+#endif
+    this->wait(600); // let run finish. don't terminate it.
+}
+
+/*
+ * Device paths the enumerator can't see, such as the pty end of a
+ * board emulator. They are reported like other ports while they exist.
+ */
+void PortConnectionMonitor::setExtraPorts(QStringList ports)
+{
+    extraLock.lock();
+    extraPorts = ports;
+    extraLock.unlock();
+#ifdef Q_OS_LINUX
+    wake(1);
+#endif
+}
+
+#ifdef Q_OS_LINUX
+/*
+ * Wake the hotplug thread. 0 to stop, 1 to reload the extra ports.
+ */
+void PortConnectionMonitor::wake(char ch)
+{
+    if(wakePipe[1] > -1) {
+        if(::write(wakePipe[1], &ch, 1) < 0)
+            qDebug() << "PortConnectionMonitor can't wake thread";
+    }
+}
+#endif
+
+/*
+ * Returns the name shown in the port combo box for a port,
+ * or an empty string if the port should not be listed.
+ */
+QString PortConnectionMonitor::portItemName(const QextPortInfo &info)
+{
+    QString name;
+#if defined(Q_OS_WIN)
+    name = info.portName;
+    if(info.friendName.contains("Bluetooth", Qt::CaseInsensitive))
+        return "";
+    if(name.lastIndexOf('\\') > -1)
+        name = name.mid(name.lastIndexOf('\\')+1);
+    if(name.contains(QString("LPT"),Qt::CaseInsensitive))
+        return "";
+#elif defined(Q_OS_MAC)
+    name = info.portName;
+    if(info.physName.contains("Bluetooth", Qt::CaseInsensitive))
+        return "";
+    if(name.indexOf("usbserial",0,Qt::CaseInsensitive) < 0)
+        return "";
+#else
+    QString ttys = "ttyS";
+    name = info.physName;
+    if(name.indexOf("ttyusb",0,Qt::CaseInsensitive) < 0 &&
+       name.indexOf("ttyacm",0,Qt::CaseInsensitive) < 0 &&
+       name.indexOf("ttyama",0,Qt::CaseInsensitive) < 0 &&
+       name.indexOf(ttys,0,Qt::CaseInsensitive) > -1) {
+        /* just allow ttyS0 - ttyS9 */
+        int ttyslen = name.mid(ttys.length()).length();
+        if (ttyslen != 6)
+            return "";
+    }
+#endif
+    return name;
 }
 
 QStringList PortConnectionMonitor::enumeratePorts()
 {
     QList<QextPortInfo> ports = QextSerialEnumerator::getPorts();
-    QStringList stringlist;
     QStringList myPortList;
     QString name;
-    stringlist << "List of ports:";
     for (int i = 0; i < ports.size(); i++) {
-        stringlist << "port name:" << ports.at(i).portName;
-        stringlist << "friendly name:" << ports.at(i).friendName;
-        stringlist << "physical name:" << ports.at(i).physName;
-        stringlist << "enumerator name:" << ports.at(i).enumName;
-        stringlist << "vendor ID:" << QString::number(ports.at(i).vendorID, 16);
-        stringlist << "product ID:" << QString::number(ports.at(i).productID, 16);
-        stringlist << "===================================";
-#if defined(Q_OS_WIN32)
-        name = ports.at(i).portName;
-        myPortList.append(name);
-#elif defined(Q_OS_MAC)
-        name = ports.at(i).portName;
-        if(name.indexOf("usbserial") > -1)
+        name = portItemName(ports.at(i));
+        if(name.length() > 0)
             myPortList.append(name);
-#else
-        name = "/"+ports.at(i).physName;
-        myPortList.append(name);
-#endif
+    }
+
+    extraLock.lock();
+    QStringList extras = extraPorts;
+    extraLock.unlock();
+    foreach(QString extra, extras) {
+        if(QFile::exists(extra) && !myPortList.contains(extra))
+            myPortList.append(extra);
     }
     return myPortList;
 }
 
+/*
+ * Compare ports with the last list and report only the differences.
+ */
+void PortConnectionMonitor::checkPorts()
+{
+    QStringList ports = enumeratePorts();
+    if(ports == portList)
+        return;
+
+    QStringList added;
+    QStringList removed;
+    foreach(QString name, ports) {
+        if(!portList.contains(name))
+            added.append(name);
+    }
+    foreach(QString name, portList) {
+        if(!ports.contains(name))
+            removed.append(name);
+    }
+    portList = ports;
+    if(added.count() || removed.count())
+        emit portsChanged(added, removed);
+}
+
+#ifdef Q_OS_LINUX
+/*
+ * Watch the directories holding the extra ports. A symlink is
+ * watched at both ends so a pty going away in /dev/pts is seen.
+ */
+void PortConnectionMonitor::watchExtraPorts(int fd)
+{
+    foreach(int wd, extraWatches)
+        ::inotify_rm_watch(fd, wd);
+    extraWatches.clear();
+    extraNames.clear();
+
+    extraLock.lock();
+    QStringList extras = extraPorts;
+    extraLock.unlock();
+
+    QStringList paths;
+    foreach(QString extra, extras) {
+        paths.append(extra);
+        QString target = QFileInfo(extra).symLinkTarget();
+        if(target.length() > 0)
+            paths.append(target);
+    }
+
+    QStringList dirs;
+    foreach(QString path, paths) {
+        QFileInfo info(path);
+        extraNames.append(info.fileName());
+        QString dir = info.absolutePath();
+        if(dir == "/dev" || dirs.contains(dir))
+            continue;
+        dirs.append(dir);
+        int wd = ::inotify_add_watch(fd, dir.toLocal8Bit().constData(),
+                    IN_CREATE | IN_DELETE | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO);
+        if(wd > -1)
+            extraWatches.append(wd);
+    }
+}
+
+/*
+ * Block on inotify events for /dev and the extra port directories.
+ * Nothing runs while the port list is idle.
+ * Returns false if inotify is not available.
+ */
+bool PortConnectionMonitor::runHotplug()
+{
+    if(wakePipe[0] < 0)
+        return false;
+
+    int fd = ::inotify_init();
+    if(fd < 0)
+        return false;
+
+    int devWatch = ::inotify_add_watch(fd, "/dev", IN_CREATE | IN_DELETE | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO);
+    if(devWatch < 0) {
+        ::close(fd);
+        return false;
+    }
+    watchExtraPorts(fd);
+
+    struct pollfd fds[2];
+    fds[0].fd = fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = wakePipe[0];
+    fds[1].events = POLLIN;
+
+    // buffer must be aligned for struct inotify_event
+    union {
+        struct inotify_event event;
+        char buff[4096];
+    } events;
+
+    bool pending = false;
+    while(running) {
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+        int rc = ::poll(fds, 2, pending ? HOTPLUG_DEBOUNCE_MS : -1);
+        if(rc < 0) {
+            if(errno == EINTR)
+                continue;
+            break;
+        }
+        if(rc == 0) {
+            // quiet period is over, now look at the ports.
+            pending = false;
+            checkPorts();
+            // a relinked extra port may point somewhere new
+            watchExtraPorts(fd);
+            continue;
+        }
+        if(fds[1].revents) {
+            char ch = 0;
+            if(::read(wakePipe[0], &ch, 1) < 1 || ch == 0 || !running)
+                break;
+            watchExtraPorts(fd);
+            pending = true;
+            continue;
+        }
+        if(fds[0].revents & POLLIN) {
+            ssize_t len = ::read(fd, events.buff, sizeof(events.buff));
+            char *ptr = events.buff;
+            while(len > 0 && ptr < events.buff + len) {
+                struct inotify_event *ev = (struct inotify_event *) ptr;
+                if(ev->mask & IN_Q_OVERFLOW) {
+                    pending = true;
+                }
+                else if(ev->len > 0 && ev->wd == devWatch) {
+                    if(!strncmp(ev->name, "tty", 3) || !strncmp(ev->name, "rfcomm", 6))
+                        pending = true;
+                    else if(extraNames.contains(QString::fromLocal8Bit(ev->name)))
+                        pending = true;
+                }
+                else if(ev->len > 0) {
+                    if(extraNames.contains(QString::fromLocal8Bit(ev->name)))
+                        pending = true;
+                }
+                ptr += sizeof(struct inotify_event) + ev->len;
+            }
+        }
+    }
+    ::close(fd);
+    return true;
+}
+#endif
+
 void PortConnectionMonitor::run()
 {
-    QStringList ports;
     portList = enumeratePorts();
+#ifdef Q_OS_LINUX
+    if(runHotplug())
+        return;
+#endif
     while(running) {
-        QApplication::processEvents();
         this->msleep(300);
-        ports = enumeratePorts();
-        if(ports != portList) {
-            portList = ports;
-            emit portChanged();
-        }
+        checkPorts();
     }
 }
@@ -22,25 +22,50 @@
 
 #include <QtCore>
 
+struct QextPortInfo;
+
+/*
+ * Watches for serial ports being added or removed.
+ * On Linux the thread sleeps on inotify events for /dev and only
+ * re-enumerates after a tty device changes. Other platforms poll.
+ * Extra device paths, such as a pty in /dev/pts, are watched too.
+ */
 class PortConnectionMonitor : public QThread
 {
     Q_OBJECT
 public:
     explicit PortConnectionMonitor(QObject *parent = 0);
+    ~PortConnectionMonitor();
+
+    static QString portItemName(const QextPortInfo &info);
 
     QStringList enumeratePorts();
+    void setExtraPorts(QStringList ports);
     void stop();
     void run();
 
 signals:
-    void portChanged();
+    void portsChanged(QStringList added, QStringList removed);
 
 public slots:
 
 private:
+    void checkPorts();
+#ifdef Q_OS_LINUX
+    bool runHotplug();
+    void watchExtraPorts(int fd);
+    void wake(char ch);
+
+    QList<int> extraWatches;
+    QStringList extraNames;
+#endif
+
     QString pathPrefix;
     QStringList portList;
-    bool running;
+    QStringList extraPorts;
+    QMutex extraLock;
+    volatile bool running;
+    int wakePipe[2];
 
 };
 
@@ -24,6 +24,12 @@
 
 #define TELNET_POLL 0
 
+/*
+ * Largest block handed to the port per transmit timer tick.
+ * 256 bytes is about 22ms at 115200 baud which keeps the GUI responsive.
+ */
+#define TX_CHUNK 256
+
 /*
  * We use Polling for the port because events are not
  * well behaved in the QextSerialPort library on windows.
@@ -32,6 +38,17 @@ PortListener::PortListener(QObject *parent, Console *term) : QThread(parent)
 {
     terminal = term;
     useSerial = false;
+    textEditor = NULL;
+
+    txSent = 0;
+    txTotal = 0;
+    txLineDelay = 0;
+    txCount = 0;
+    txDropped = 0;
+    decoder = NULL;
+    txTimer = new QTimer(this);
+    txTimer->setSingleShot(true);
+    connect(txTimer, SIGNAL(timeout()), this, SLOT(sendQueued()));
 
     /*
      * removed EVENT_DRIVEN code because it doesn't work on all platforms
@@ -92,6 +109,76 @@ BaudRateType PortListener::getBaudRate()
     return (useSerial) ? serialPort->baudRate() : (BaudRateType)wifiPort->getBaudRate();
 }
 
+/*
+ * Send received data to decoder rather than the console, or back to
+ * the console if decoder is NULL. Serial data is then read and decoded
+ * on this listener's thread; WiFi data on the socket's.
+ */
+void PortListener::setFrameDecoder(FrameDecoder *decoder)
+{
+    QMutexLocker locker(&decoderLock);
+    this->decoder = decoder;
+}
+
+/*
+ * One pass of the serial listener loop in decoder mode.
+ * @returns false if there is no decoder.
+ */
+bool PortListener::feedDecoder()
+{
+    QMutexLocker locker(&decoderLock);
+    if(decoder == NULL)
+        return false;
+    QByteArray ba = serialPort->readAll();
+    if(ba.length() > 0)
+        decoder->feed(ba.constData(), ba.length());
+    else
+        msleep(1);
+    return true;
+}
+
+qint64 PortListener::getTxBytes()
+{
+    return txCount;
+}
+
+/*
+ * Bytes thrown away because a write failed, including WiFi packets
+ * the bridge socket refused.
+ */
+qint64 PortListener::getTxDropped()
+{
+    return txDropped + wifiPort->getStats().txDropped;
+}
+
+/*
+ * Received bytes waiting in the driver or socket for the console.
+ */
+qint64 PortListener::getRxQueued()
+{
+    if(!isOpen())
+        return 0;
+    return (useSerial) ? serialPort->bytesAvailable() : wifiPort->rxQueued();
+}
+
+/*
+ * Driver overrun count, or -1 if not known (WiFi, Windows, closed port).
+ */
+qint64 PortListener::getOverruns()
+{
+    return (useSerial) ? serialPort->overruns() : -1;
+}
+
+XEspStats PortListener::getWifiStats()
+{
+    return wifiPort->getStats();
+}
+
+bool PortListener::isSerial()
+{
+    return useSerial;
+}
+
 void PortListener::setDtr(bool enable)
 {
     if (useSerial) serialPort->setDtr(enable);
@@ -110,6 +197,7 @@ bool PortListener::open()
     if(terminal == NULL)
         return false;
 
+    bool wasOpen = isOpen();
     if (useSerial) {
         if(serialPort == NULL)
             return false;
@@ -126,11 +214,17 @@ bool PortListener::open()
         connect(wifiPort, SIGNAL(updateEvent(XEsp8266port*)), this, SLOT(updateReady(XEsp8266port*)));
         wifiPort->open(QHostAddress(wifiPort->getIpAddress()), wifiPort->getBaudRate());
     }
+    if(!wasOpen && isOpen()) {
+        openName = getPortName();
+        emit portOpened(openName);
+    }
     return true;
 }
 
 void PortListener::close()
 {
+    bool wasOpen = isOpen();
+    cancelSend();
     if (useSerial) {
         if(serialPort == NULL) return;
         disconnect(this, SIGNAL(updateEvent(QextSerialPort*)), this, SLOT(updateReady(QextSerialPort*)));
@@ -141,6 +235,8 @@ void PortListener::close()
         wifiPort->close();
     }
     msleep(500); // just in case the port has not been released yet.
+    if(wasOpen)
+        emit portClosed(openName);
 }
 
 bool PortListener::isOpen()
@@ -153,13 +249,146 @@ void PortListener::setTerminalWindow(QPlainTextEdit *editor)
     textEditor = editor;
 }
 
+/*
+ * Queue data for the port. The whole buffer is written in TX_CHUNK
+ * blocks by sendQueued() rather than one byte per call.
+ */
 void PortListener::send(QByteArray &data)
 {
-    if (useSerial) {
-        serialPort->write(data.constData(),1);
+    if(data.isEmpty())
+        return;
+    if(!isSending()) {
+        txSent = 0;
+        txTotal = 0;
+        txElapsed.start();
+    }
+    txQueue.append(data);
+    txTotal += data.length();
+    if(!txTimer->isActive())
+        txTimer->start(0);
+}
+
+/*
+ * Stream a file to the port. The file is read in TX_CHUNK blocks
+ * (or one line at a time when a send line delay is set) so that
+ * large files never have to be loaded into memory.
+ */
+bool PortListener::sendFile(const QString &fileName)
+{
+    if(txFile.isOpen())
+        return false;
+    txFile.setFileName(fileName);
+    if(!txFile.open(QFile::ReadOnly))
+        return false;
+    if(txQueue.isEmpty()) {
+        txSent = 0;
+        txTotal = 0;
+        txElapsed.start();
+    }
+    txTotal += txFile.size();
+    if(!txTimer->isActive())
+        txTimer->start(0);
+    return true;
+}
+
+void PortListener::cancelSend()
+{
+    bool sending = isSending();
+    txTimer->stop();
+    txQueue.clear();
+    if(txFile.isOpen())
+        txFile.close();
+    if(sending)
+        emit sendFinished(txSent, sendRate());
+}
+
+bool PortListener::isSending()
+{
+    return txQueue.length() > 0 || txFile.isOpen();
+}
+
+/*
+ * Delay in milliseconds after each CR or NL sent.
+ * Useful for devices that don't have flow control.
+ */
+void PortListener::setSendLineDelay(int ms)
+{
+    txLineDelay = (ms > 0) ? ms : 0;
+}
+
+qint64 PortListener::sendRate()
+{
+    qint64 ms = txElapsed.isValid() ? txElapsed.elapsed() : 0;
+    if(ms < 1) ms = 1;
+    return txSent*1000/ms;
+}
+
+void PortListener::sendQueued()
+{
+    if(!isOpen()) {
+        cancelSend();
+        return;
+    }
+
+    if(txQueue.isEmpty() && txFile.isOpen()) {
+        if(txLineDelay > 0)
+            txQueue = txFile.readLine(TX_CHUNK);
+        else
+            txQueue = txFile.read(TX_CHUNK);
+    }
+
+    int len = txQueue.length();
+    if(len > TX_CHUNK)
+        len = TX_CHUNK;
+
+    bool endOfLine = false;
+    if(txLineDelay > 0) {
+        for(int n = 0; n < len; n++) {
+            char ch = txQueue.at(n);
+            if(ch == '\r' || ch == '\n') {
+                len = n+1;
+                endOfLine = true;
+                break;
+            }
+        }
+    }
+
+    if(len > 0) {
+        qint64 rc;
+        if (useSerial) {
+            rc = serialPort->write(txQueue.constData(), len);
+        }
+        else {
+            rc = wifiPort->write(txQueue.constData(), len);
+        }
+        if(rc < 1) {
+            /* drop the rest of the transfer and let the sender know */
+            txDropped += txTotal - txSent;
+            txTimer->stop();
+            txQueue.clear();
+            if(txFile.isOpen())
+                txFile.close();
+            emit sendFailed(txSent, txTotal);
+            return;
+        }
+        txCount += rc;
+        if(rc < len)
+            endOfLine = false;
+        txQueue.remove(0, rc);
+        txSent += rc;
+    }
+
+    if(txFile.isOpen()) {
+        if(txQueue.isEmpty() && txFile.atEnd())
+            txFile.close();
+        emit sendProgress(txSent, txTotal);
+    }
+
+    if(isSending()) {
+        txTimer->start(endOfLine ? txLineDelay : 0);
     }
     else {
-        wifiPort->write(data.constData(),1);
+        emit sendFinished(txSent, sendRate());
     }
 }
 
@@ -180,6 +409,19 @@ void PortListener::updateReady(QextSerialPort* port)
 
 void PortListener::updateReady(XEsp8266port* port)
 {
+    {
+        /* the decoder is swapped under this lock, so test it holding it */
+        QMutexLocker locker(&decoderLock);
+        if(decoder != NULL) {
+            for(;;) {
+                const QByteArray &ba = port->readBuffer();
+                if(ba.isEmpty())
+                    break;
+                decoder->feed(ba.constData(), ba.length());
+            }
+            return;
+        }
+    }
     if(terminal != NULL)
         if(terminal->enabled())
             terminal->updateReady(port);
@@ -201,6 +443,8 @@ void PortListener::run()
 {
     if (useSerial) {
         while(serialPort->isOpen()) {
+            if(feedDecoder())
+                continue;
             if(terminal->serialPollEnabled()) {
                 msleep(POLL_DELAY);
                 QApplication::processEvents();
@@ -22,6 +22,7 @@
 
 #include "console.h"
 #include "xesp8266port.h"
+#include "framedecoder.h"
 
 class PortListener : public QThread
 {
@@ -36,28 +37,67 @@ public:
     bool isOpen();
     void setTerminalWindow(QPlainTextEdit *editor);
     void send(QByteArray &data);
+    bool sendFile(const QString &fileName);
+    void cancelSend();
+    bool isSending();
+    void setSendLineDelay(int ms);
     int  readData(char *buff, int length);
     void run();
 
     QString getPortName();
     BaudRateType getBaudRate();
 
+    // counters for the terminal meters; totals, not rates
+    qint64 getTxBytes();
+    qint64 getTxDropped();
+    qint64 getRxQueued();
+    qint64 getOverruns();
+    XEspStats getWifiStats();
+    bool isSerial();
+
+    void setFrameDecoder(FrameDecoder *decoder);
+
 private:
+    qint64 sendRate();
+    bool   feedDecoder();
+
     bool            useSerial;
+    QString         openName;   // port named in portOpened()
     Console         *terminal;
     QextSerialPort  *serialPort;
     XEsp8266port     *wifiPort;
     QPlainTextEdit  *textEditor;
 
+    // transmit queue is drained from the GUI thread in chunks
+    QByteArray      txQueue;
+    QFile           txFile;
+    QTimer          *txTimer;
+    QElapsedTimer   txElapsed;
+    qint64          txSent;
+    qint64          txTotal;
+    int             txLineDelay;
+    qint64          txCount;
+    qint64          txDropped;
+
+    // while set, received data goes here instead of the console
+    FrameDecoder    *decoder;
+    QMutex          decoderLock;
+
 private slots:
     void onDsrChanged(bool status);
     void updateReady(QextSerialPort*);
     void updateReady(XEsp8266port *);
+    void sendQueued();
 
 signals:
     void readyRead(int length);
     void updateEvent(QextSerialPort*);
     void updateEvent(XEsp8266port*);
+    void sendProgress(qint64 sent, qint64 total);
+    void sendFinished(qint64 sent, qint64 bytesPerSecond);
+    void sendFailed(qint64 sent, qint64 total);
+    void portOpened(QString name);
+    void portClosed(QString name);
 };
 
 
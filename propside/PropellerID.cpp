@@ -36,8 +36,12 @@ PropellerID::PropellerID(QObject *parent) : QThread(parent)
 {
     port = new QextSerialPort(QextSerialPort::Polling);
     pload_verbose = 0;
+    pload_delay = 0;
     rxhead = 0;
     rxtail = 0;
+    reading = false;
+    cancelled = false;
+    version = 0;
     resetType = RESET_BY_DTR;
     LFSR = 80; // 'P'
 }
@@ -52,54 +56,63 @@ int PropellerID::isDevice(QString portName)
     return findprop(portName.toLatin1());
 }
 
+/*
+ * Receive thread. Moves port data into the ring and wakes readers.
+ * The polling port has no blocking read, so an idle port is checked
+ * every millisecond; the handshake side never spins, it waits on rxready.
+ *
+ * The ring holds at most RXSIZE bytes, one slot is always left empty
+ * so head == tail means empty:
+ * [--t--h-] used = head-tail
+ * [-h-t---] used = size-(tail-head)
+ * [b------] head == tail, empty
+ * [t-----h] full
+ */
 void PropellerID::run()
 {
-    while(port->isOpen()) {
-        msleep(25);
-        QApplication::processEvents();
-        emit portEvent();
+    char buff[RXSIZE+1];
+    for(;;) {
+        int space;
+        rxlock.lock();
+        if(!reading || cancelled) {
+            rxlock.unlock();
+            break;
+        }
+        space = RXSIZE - ((rxhead - rxtail) & RXSIZE);
+        rxlock.unlock();
+
+        int size = port->bytesAvailable();
+        if(size < 1 || space < 1) {
+            msleep(1);
+            continue;
+        }
+        if(size > space)
+            size = space;
+        size = port->read(buff, size);
+        if(size < 1)
+            continue;
+
+        rxlock.lock();
+        for(int n = 0; n < size; n++) {
+            rxqueue[rxhead] = buff[n];
+            rxhead = (rxhead + 1) & RXSIZE;
+        }
+        rxready.wakeAll();
+        rxlock.unlock();
     }
 }
 
-void PropellerID::portHandler()
+void PropellerID::cancel()
 {
-    /*
-     * TODO Queue is broken. Fix it later.
-     * For the time being the current queue buffer is big enough to hold
-     * all expected receive data + garbage from quickstart boards.
-     */
+    QMutexLocker locker(&rxlock);
+    cancelled = true;
+    rxready.wakeAll();
+}
 
-    /*
-     * [--t--h-] head >= tail, read size-(head-tail) into buffer
-     * [-h-t---] head < tail, read head amount into buffer
-     * [b------] head == tail
-     * [t-----h] full
-     * [-----ht]
-     * [------b]
-     */
-    int size = port->bytesAvailable();
-    if(size < 1) {
-        return;
-    }
-#if 1
-    if (rxhead >= rxtail) {
-        size = RXSIZE-(rxhead-rxtail);
-        size = port->read(&rxqueue[rxhead], size);
-    } else {
-        size = port->read(&rxqueue[rxhead], rxtail-rxhead-1);
-    }
-#else
-    if (rxhead > rxtail) {
-        size = RXSIZE-(rxhead-rxtail);
-        size = port->read(&rxqueue[rxhead], size);
-    } else if (rxhead < rxtail) {
-        size = port->read(&rxqueue[0], rxtail - rxhead);
-    } else {
-        size = port->read(&rxqueue[0], RXSIZE);
-    }
-#endif
-    rxhead = (rxhead + size) & RXSIZE;
-    // if (pload_verbose) qDebug() << size << " bytes read H" << rxhead << "T" << rxtail;
+bool PropellerID::isCancelled()
+{
+    QMutexLocker locker(&rxlock);
+    return cancelled;
 }
 
 /**
@@ -111,14 +124,12 @@ void PropellerID::portHandler()
 int PropellerID::rx(char* buff, int n)
 {
     int size = 0;
-    while(rxhead == rxtail)
-        ;
-    while(rxhead != rxtail) {
-        if(size >= n)
-            break;
-        buff[size] = rxqueue[rxtail];
-        size++;
-        rxtail = (rxtail + size) & RXSIZE;
+    QMutexLocker locker(&rxlock);
+    while(rxhead == rxtail && !cancelled)
+        rxready.wait(&rxlock);
+    while(size < n && rxhead != rxtail) {
+        buff[size++] = rxqueue[rxtail];
+        rxtail = (rxtail + 1) & RXSIZE;
     }
     return size;
 }
@@ -131,9 +142,7 @@ int PropellerID::rx(char* buff, int n)
  */
 int PropellerID::tx(char* buff, int n)
 {
-    int size = port->write((const char*)buff, n);
-    QApplication::processEvents();
-    return size;
+    return port->write((const char*)buff, n);
 }
 
 /**
@@ -146,18 +155,17 @@ int PropellerID::tx(char* buff, int n)
 int PropellerID::rx_timeout(char* buff, int n, int timeout)
 {
     int size = 0;
-    while(rxhead == rxtail) {
-        msleep(1);
-        QApplication::processEvents();
-        if(timeout-- < 0)
+    QElapsedTimer elapsed;
+    elapsed.start();
+    QMutexLocker locker(&rxlock);
+    while(rxhead == rxtail && !cancelled) {
+        qint64 left = timeout - elapsed.elapsed();
+        if(left <= 0 || !rxready.wait(&rxlock, left))
             break;
     }
-    while(timeout > 0 && rxhead != rxtail) {
-        if(size >= n)
-            break;
-        buff[size] = rxqueue[rxtail];
-        size++;
-        rxtail = (rxtail + size) & RXSIZE;
+    while(size < n && rxhead != rxtail) {
+        buff[size++] = rxqueue[rxtail];
+        rxtail = (rxtail + 1) & RXSIZE;
     }
     return size == 0 ? SERIAL_TIMEOUT : size;
 }
@@ -200,7 +208,7 @@ int PropellerID::iterate(void)
  */
 int PropellerID::getBit(int* status, int timeout)
 {
-    char mybuf[2];
+    char mybuf[2] = { 0, 0 };
     int rc = rx_timeout(mybuf, 1, timeout);
     if(status)
         *status = rc <= 0 ? 0 : 1;
@@ -215,7 +223,7 @@ int PropellerID::getBit(int* status, int timeout)
  */
 int PropellerID::getAck(int* status, int timeout)
 {
-    char mybuf[2];
+    char mybuf[2] = { 0, 0 };
     int rc = rx_timeout(mybuf, 1, timeout);
     if(status)
         *status = rc <= 0 ? 0 : 1;
@@ -270,7 +278,7 @@ int PropellerID::hwfind(int retry)
     /* hwfind is recursive if we get a failure on the first try.
      * retry is set by caller and should never be more than one.
      */
-    if(retry < 0)
+    if(retry < 0 || isCancelled())
         return 0;
 
     /* Do not pause after reset.
@@ -322,6 +330,9 @@ int PropellerID::hwfind(int retry)
     // wait for response so we know we have a Propeller
     for(n = 1; n < 250; n++) {
 
+        if(isCancelled())
+            return 0;
+
         jj = iterate();
         //if (pload_verbose) { printf("%d:%d %3d ", ii, jj, n); fflush(stdout); }
 
@@ -359,7 +370,6 @@ void PropellerID::flushPort()
     int size = 0;
     do {
         msleep(5);
-        QApplication::processEvents();
         size = port->bytesAvailable();
         //if (pload_verbose) qDebug("Flushing port %d", size);
         port->readAll();
@@ -375,11 +385,39 @@ void PropellerID::flushPort()
  */
 int PropellerID::findprop(const char* name)
 {
-    int version = 0;
+    version = 0;
+
+    if(isCancelled())
+        return 0;
 
     if (pload_verbose)
         qDebug("\nChecking for Propeller on port %s", name);
 
+    if(openPort(name) == false)
+        return -1;
+
+    hwreset();
+    version = hwfind(1); // retry once
+
+    if (pload_verbose) {
+        if(version) {
+            qDebug() << "Propeller Version" << version << "on" << name;
+        } else {
+            qDebug() << "Propeller not found on" << name;
+        }
+    }
+    closePort();
+
+    return version != 0 ? 1 : 0;
+}
+
+/**
+ * open port at 115200 8N1 and start the receive thread
+ * @param name - com port name
+ * @returns false if the port could not be opened
+ */
+bool PropellerID::openPort(const char* name)
+{
     port->setPortName(name);
     port->setBaudRate(BAUD115200);
     port->setFlowControl(FLOW_OFF);
@@ -388,32 +426,141 @@ int PropellerID::findprop(const char* name)
     port->setStopBits(STOP_1);
     port->setTimeout(10);
     if(port->open(QIODevice::ReadWrite) == false)
-        return -1;
+        return false;
 
     flushPort();
 
-    /*
-     * TODO Queue is broken. Fix it later.
-     * For the time being the current queue buffer is big enough to hold
-     * all expected receive data + garbage from quickstart boards.
-     */
+    rxlock.lock();
     rxhead = 0;
     rxtail = 0;
+    reading = true;
+    rxlock.unlock();
 
-    connect(this, SIGNAL(portEvent()), this, SLOT(portHandler()));
     start();
-    hwreset();
-    version = hwfind(1); // retry once
-    disconnect(this, SIGNAL(portEvent()), this, SLOT(portHandler()));
+    return true;
+}
 
-    if (pload_verbose) {
-        if(version) {
-            qDebug() << "Propeller Version" << version << "on" << name;
-        } else {
-            qDebug() << "Propeller not found on" << name;
-        }
-    }
+/**
+ * stop the receive thread and close the port
+ */
+void PropellerID::closePort()
+{
+    rxlock.lock();
+    reading = false;
+    rxlock.unlock();
+    wait();
     port->close();
+}
 
-    return version != 0 ? 1 : 0;
+/*
+ * One port of a PropellerSearch. The probe thread runs the handshake;
+ * its PropellerID runs the receive side in a thread of its own.
+ */
+class PropellerSearch::Probe : public QThread
+{
+public:
+    Probe(PropellerSearch *search, QString port, int resetType) {
+        this->search = search;
+        this->port = port;
+        status = -2;
+        reported = false;
+        if(resetType == PropellerID::RESET_BY_RTS)
+            propId.setRtsReset();
+        else
+            propId.setDtrReset();
+    }
+
+    void run() {
+        status = propId.isDevice(port);
+        search->probeDone(this);
+    }
+
+    PropellerSearch *search;
+    PropellerID propId;
+    QString port;
+    int status;
+    bool reported;
+};
+
+PropellerSearch::PropellerSearch(int resetType)
+{
+    this->resetType = resetType;
+    foundVersion = 0;
+    finished = 0;
+}
+
+PropellerSearch::~PropellerSearch()
+{
+    qDeleteAll(probes);
+}
+
+void PropellerSearch::probeDone(Probe *probe)
+{
+    QMutexLocker locker(&lock);
+    if(probe->propId.isCancelled()) {
+        return;
+    }
+    if(probe->status > 0 && foundPort.isEmpty()) {
+        foundPort = probe->port;
+        foundVersion = probe->propId.getVersion();
+    }
+    probe->reported = true;
+    finished++;
+    done.wakeAll();
+}
+
+QString PropellerSearch::find(QStringList ports, int deadline, bool stopAtFirst)
+{
+    qDeleteAll(probes);
+    probes.clear();
+    foundPort.clear();
+    foundVersion = 0;
+    finished = 0;
+
+    foreach(QString port, ports) {
+        Probe *probe = new Probe(this, port, resetType);
+        probes.append(probe);
+        probe->start();
+    }
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    lock.lock();
+    while(finished < probes.count()) {
+        if(stopAtFirst && !foundPort.isEmpty())
+            break;
+        qint64 left = deadline - elapsed.elapsed();
+        if(left <= 0 || !done.wait(&lock, left))
+            break;
+    }
+    /* Stragglers give up at their next receive wait. */
+    foreach(Probe *probe, probes) {
+        if(!probe->reported)
+            probe->propId.cancel();
+    }
+    lock.unlock();
+
+    foreach(Probe *probe, probes) {
+        probe->wait();
+    }
+    return foundPort;
+}
+
+int PropellerSearch::getStatus(QString port)
+{
+    foreach(Probe *probe, probes) {
+        if(probe->port == port)
+            return probe->reported ? probe->status : -2;
+    }
+    return -2;
+}
+
+int PropellerSearch::getVersion(QString port)
+{
+    foreach(Probe *probe, probes) {
+        if(probe->port == port && probe->reported && probe->status > 0)
+            return probe->propId.getVersion();
+    }
+    return 0;
 }
@@ -21,6 +21,8 @@
 #define PROPELLERID_H
 
 #include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
 #include "qextserialport.h"
 
 class PropellerID : public QThread
@@ -33,6 +35,20 @@ public:
     int  isDevice(QString port);
     void run();
 
+    /*
+     * Chip version found by the last isDevice() call, 0 if none.
+     */
+    int  getVersion() {
+        return version;
+    }
+
+    /*
+     * Abandon an isDevice() call in progress from another thread.
+     * Pending receive waits return immediately and hwfind gives up.
+     */
+    void cancel();
+    bool isCancelled();
+
 
     enum { RESET_BY_DTR = 1 };
     enum { RESET_BY_RTS = 2 };
@@ -47,13 +63,25 @@ public:
 private:
 
     int resetType;
+    int version;
     QextSerialPort *port;
 
     enum { RXSIZE = (1<<10)-1 };
 
+    /*
+     * Receive ring filled by run() and drained by rx/rx_timeout.
+     * rxlock guards head, tail and the flags; rxready is signalled
+     * whenever data arrives or the probe is cancelled.
+     */
+    QMutex rxlock;
+    QWaitCondition rxready;
     int rxhead;
     int rxtail;
     char rxqueue[RXSIZE+1];
+    bool reading;
+    bool cancelled;
+
+protected:
 
     /**
      * receive a buffer
@@ -87,7 +115,7 @@ private:
      */
     void hwreset(void);
 
-private:
+protected:
 
     char LFSR; // 'P'
 
@@ -165,12 +193,70 @@ private:
      */
     int findprop(const char* port);
 
-private slots:
-    void portHandler();
+    /**
+     * open port at 115200 8N1 and start the receive thread
+     * @param name - com port name
+     * @returns false if the port could not be opened
+     */
+    bool openPort(const char* name);
+
+    /**
+     * stop the receive thread and close the port
+     */
+    void closePort();
+
+};
+
+/*
+ * Runs the hwfind handshake on many ports at once.
+ * Each port gets its own PropellerID probe thread and all of them share
+ * one deadline, so a search costs about one handshake instead of one
+ * timeout per port.
+ */
+class PropellerSearch
+{
+public:
+    PropellerSearch(int resetType = PropellerID::RESET_BY_DTR);
+    virtual ~PropellerSearch();
+
+    /*
+     * Probe ports in parallel until the deadline in milliseconds.
+     * With stopAtFirst the search ends as soon as a Propeller answers.
+     * @returns first port a Propeller was found on or empty string.
+     */
+    QString find(QStringList ports, int deadline, bool stopAtFirst = true);
+
+    /*
+     * Version of the first Propeller found, 0 if none.
+     */
+    int getVersion() {
+        return foundVersion;
+    }
+
+    /*
+     * Result for port from the last find: 1 found, 0 not found,
+     * -1 port busy, -2 no answer before the deadline.
+     */
+    int getStatus(QString port);
+
+    /*
+     * Chip version found on port by the last find, 0 if none.
+     */
+    int getVersion(QString port);
+
+private:
+    class Probe;
+    friend class Probe;
 
-signals:
-    void portEvent();
+    void probeDone(Probe *probe);
 
+    int resetType;
+    QList<Probe*> probes;
+    QString foundPort;
+    int foundVersion;
+    int finished;
+    QMutex lock;
+    QWaitCondition done;
 };
 
 #endif // PROPELLERID_H
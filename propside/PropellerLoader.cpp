@@ -0,0 +1,207 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qtversion.h"
+#include "PropellerLoader.h"
+
+/* ROM loader line rate */
+#define LOADER_BAUD 115200
+
+/* longs sent between progress reports */
+#define LOADER_BLOCK_LONGS 128
+
+/* the initial Spin call frame 0xFFF9FFFF,0xFFF9FFFF sums to 0xEC */
+#define SPIN_FRAME_CHECKSUM 0xEC
+
+class PropellerLoader::Worker : public QThread
+{
+public:
+    Worker(PropellerLoader *loader) {
+        this->loader = loader;
+    }
+
+    void run() {
+        loader->result = loader->upload();
+        emit loader->loadFinished(loader->result);
+    }
+
+    PropellerLoader *loader;
+};
+
+PropellerLoader::PropellerLoader(QObject *parent) : PropellerID(parent)
+{
+    worker = new Worker(this);
+    loadCommand = LOAD_RUN_RAM;
+    result = 0;
+}
+
+PropellerLoader::~PropellerLoader()
+{
+    cancel();
+    worker->wait();
+    delete worker;
+}
+
+bool PropellerLoader::load(QString port, QString file, int command)
+{
+    if(worker->isRunning())
+        return false;
+    loadPort = port;
+    loadFile = file;
+    loadCommand = command;
+    result = -1;
+    worker->start();
+    return true;
+}
+
+bool PropellerLoader::isLoading()
+{
+    return worker->isRunning();
+}
+
+QString PropellerLoader::checkImage(QByteArray &image)
+{
+    if(image.length() < 16)
+        return tr("Image is too short.");
+
+    /* vbase marks the end of program code and data */
+    int vbase = (image[8] & 0xff) | ((image[9] & 0xff) << 8);
+    if(vbase < 16 || vbase > image.length() || vbase > 0x8000 || (vbase & 3))
+        return tr("Image header is not a Spin program.");
+    image.truncate(vbase);
+
+    int sum = SPIN_FRAME_CHECKSUM;
+    for(int n = 0; n < image.length(); n++)
+        sum += image[n] & 0xff;
+    if(sum & 0xff)
+        return tr("Image checksum is invalid.");
+    return QString();
+}
+
+int PropellerLoader::upload()
+{
+    QFile file(loadFile);
+    if(!file.open(QFile::ReadOnly)) {
+        emit message(tr("Can't open %1.").arg(loadFile));
+        return 1;
+    }
+    QByteArray image = file.readAll();
+    file.close();
+
+    QString error = checkImage(image);
+    if(error.length() > 0) {
+        emit message(error);
+        return 1;
+    }
+
+    emit progress(0);
+    if(openPort(loadPort.toLatin1()) == false) {
+        emit message(tr("Can't open port %1.").arg(loadPort));
+        return 1;
+    }
+
+    int rc = 1;
+    hwreset();
+    int ver = hwfind(1);
+    if(ver == 0) {
+        emit message(tr("Propeller not found on %1.").arg(loadPort));
+    }
+    else {
+        emit message(tr("Propeller Version %1 on %2").arg(ver).arg(loadPort));
+        emit message(tr("Loading %1 (%2 bytes)").arg(QFileInfo(loadFile).fileName()).arg(image.length()));
+        sendlong(loadCommand);
+        sendlong(image.length()/4);
+        if(sendImage(image)) {
+            /* the chip sums RAM before it answers */
+            if(waitAck(2500) != 0) {
+                emit message(tr("RAM checksum error."));
+            }
+            else if(loadCommand == LOAD_RUN_RAM) {
+                rc = 0;
+            }
+            else if(waitAck(5000) != 0) {
+                emit message(tr("EEPROM programming failed."));
+            }
+            else if(waitAck(2500) != 0) {
+                emit message(tr("EEPROM verify failed."));
+            }
+            else {
+                rc = 0;
+            }
+        }
+    }
+    if(isCancelled())
+        emit message(tr("Load cancelled."));
+    if(rc == 0) {
+        emit progress(100);
+        emit message(tr("Load complete."));
+    }
+    closePort();
+    return rc;
+}
+
+bool PropellerLoader::sendImage(QByteArray &image)
+{
+    int longs = image.length()/4;
+    const uchar *data = (const uchar*) image.constData();
+    char buff[LOADER_BLOCK_LONGS*11];
+    qint64 sent = 0;
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    for(int n = 0; n < longs; ) {
+        int len = 0;
+        for(int k = 0; k < LOADER_BLOCK_LONGS && n < longs; k++, n++) {
+            int word = data[n*4] | (data[n*4+1] << 8) | (data[n*4+2] << 16) | (data[n*4+3] << 24);
+            makelong(word, &buff[len]);
+            len += 11;
+        }
+        if(tx(buff, len) != len)
+            return false;
+        sent += len;
+
+        /* Hold back until the block is on the wire so progress is real
+         * and the acks are not clocked ahead of the image.
+         */
+        qint64 due = sent*10*1000/LOADER_BAUD;
+        if(due > elapsed.elapsed())
+            msleep(due - elapsed.elapsed());
+        if(isCancelled())
+            return false;
+        emit progress(n*100/longs);
+    }
+    return true;
+}
+
+int PropellerLoader::waitAck(int timeout)
+{
+    char mybuf[1] = { (char)0xF9 };
+    QElapsedTimer elapsed;
+    elapsed.start();
+    while(elapsed.elapsed() < timeout && !isCancelled()) {
+        int status = 0;
+        if(tx(mybuf, 1) == 0)
+            break;
+        int bit = getBit(&status, 20);
+        if(status)
+            return bit;
+    }
+    return SERIAL_TIMEOUT;
+}
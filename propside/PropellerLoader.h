@@ -0,0 +1,101 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROPELLERLOADER_H
+#define PROPELLERLOADER_H
+
+#include "PropellerID.h"
+
+/*
+ * In-process Propeller serial loader.
+ * Continues from the PropellerID handshake to send a Spin .binary or
+ * .eeprom image with the 3 bits per byte long encoding, then checks the
+ * RAM checksum and optionally programs and verifies EEPROM.
+ * The download runs on a worker thread; progress and messages are
+ * emitted from there, so connect with Qt's default connection type.
+ */
+class PropellerLoader : public PropellerID
+{
+Q_OBJECT
+public:
+    PropellerLoader(QObject *parent = 0);
+    virtual ~PropellerLoader();
+
+    enum { LOAD_RUN_RAM     = 1 };
+    enum { LOAD_EEPROM      = 2 };
+    enum { LOAD_RUN_EEPROM  = 3 };
+
+    /*
+     * Start loading image file to the Propeller on port.
+     * @param command - LOAD_RUN_RAM, LOAD_EEPROM or LOAD_RUN_EEPROM
+     * @returns false if a load is already running.
+     */
+    bool load(QString port, QString file, int command);
+
+    bool isLoading();
+
+    /*
+     * Result of the last load: 0 on success.
+     */
+    int  getResult() {
+        return result;
+    }
+
+    /*
+     * Checks a Spin image header and truncates it to the program size.
+     * @returns empty string if the image is valid, else the reason.
+     */
+    static QString checkImage(QByteArray &image);
+
+signals:
+    void progress(int percent);
+    void message(QString text);
+    void loadFinished(int result);
+
+private:
+    class Worker;
+    friend class Worker;
+
+    /**
+     * upload ... run the whole download on the calling thread
+     * @returns 0 on success
+     */
+    int upload();
+
+    /**
+     * sendImage ... transmit image longs paced to the wire rate
+     * @returns false if cancelled
+     */
+    bool sendImage(QByteArray &image);
+
+    /**
+     * waitAck ... clock out one status bit with 0xF9
+     * @param timeout - milliseconds to keep asking
+     * @returns 0 or 1 bit value, or SERIAL_TIMEOUT
+     */
+    int waitAck(int timeout);
+
+    Worker  *worker;
+    QString loadPort;
+    QString loadFile;
+    int     loadCommand;
+    int     result;
+};
+
+#endif // PROPELLERLOADER_H
@@ -27,6 +27,7 @@ const QString ASideBoard::clkmode = "clkmode";
 const QString ASideBoard::pllmode = "pllmode";
 const QString ASideBoard::clkfreq = "clkfreq";
 const QString ASideBoard::baudrate = "baudrate";
+const QString ASideBoard::termbaudrate = "terminal-baudrate";
 const QString ASideBoard::reset = "reset";
 const QString ASideBoard::rxpin = "rxpin";
 const QString ASideBoard::txpin = "txpin";
@@ -39,6 +40,7 @@ const QString ASideBoard::cachedriver = "cache-driver";
 const QString ASideBoard::cachesize = "cache-size";
 const QString ASideBoard::cacheparam1 = "cache-param1";
 const QString ASideBoard::cacheparam2 = "cache-param2";
+const QString ASideBoard::loader = "loader";
 
 ASideBoard::ASideBoard()
 {
@@ -40,6 +40,7 @@ public:
     static const QString pllmode;
     static const QString clkfreq;
     static const QString baudrate;
+    static const QString termbaudrate;
     static const QString reset;
     static const QString rxpin;
     static const QString txpin;
@@ -52,6 +53,7 @@ public:
     static const QString cachesize;
     static const QString cacheparam1;
     static const QString cacheparam2;
+    static const QString loader;
 
 private:
 
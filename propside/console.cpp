@@ -28,14 +28,12 @@
 #include "terminal.h"
 #include "console.h"
 
-Console::Console(QWidget *parent) : QPlainTextEdit(parent)
+Console::Console(QWidget *parent) : QPlainTextEdit(parent), TermView(this)
 {
     setFont(QFont("courier"));
     isEnabled = true;
     isSerialPollEnabled = true;
-    pcmd = Console::PCMD_NONE;
-    pcmdx = 0;
-    pcmdy = 0;
+    wifiUpdating = false;
     maxcol = 32;
     wrapMode = 0;
     tabsize = 8;
@@ -45,15 +43,113 @@ Console::Console(QWidget *parent) : QPlainTextEdit(parent)
     for(int n = 0; n < maxhex; n++)
         hexbyte[n] = 0;
     sbuff = NULL;
+    capture = NULL;
+    stats.rxBytes = 0;
+    stats.frames = 0;
+    stats.frameUsTotal = 0;
+    stats.frameUsMax = 0;
+    setWrap();
     // experimenting with wraps ... just turn it off.
     this->setLineWrapMode(QPlainTextEdit::NoWrap);
 }
 
+/*
+ * Copy received bytes to dev as they arrive, or stop if dev is NULL.
+ */
+void Console::setCapture(QIODevice *dev)
+{
+    capture = dev;
+}
+
+/*
+ * Everything read from the port passes through here before display.
+ */
+void Console::received(const QByteArray &ba)
+{
+    if(capture != NULL)
+        capture->write(ba);
+    history.append(ba);
+    stats.rxBytes += ba.length();
+}
+
+/*
+ * Time spent applying one batch of received characters to the document.
+ */
+void Console::frameDone(qint64 us)
+{
+    stats.frames++;
+    stats.frameUsTotal += us;
+    if(us > stats.frameUsMax)
+        stats.frameUsMax = us;
+}
+
+/*
+ * Return the receive and render counters. The frame maximum restarts
+ * with each call so that it covers one sampling period.
+ */
+Console::Stats Console::takeStats()
+{
+    Stats s = stats;
+    stats.frameUsMax = 0;
+    return s;
+}
+
+ScrollBack *Console::getScrollBack()
+{
+    return &history;
+}
+
+/*
+ * Mark every match in the visible document, or clear marks if pattern is empty.
+ */
+int Console::highlightAll(const QString &pattern, bool regex, bool caseSensitive)
+{
+    QList<QTextEdit::ExtraSelection> marks;
+    if(pattern.isEmpty()) {
+        setExtraSelections(marks);
+        return 0;
+    }
+
+    QTextDocument::FindFlags flags;
+    if(caseSensitive)
+        flags |= QTextDocument::FindCaseSensitively;
+    QRegExp rx(pattern, caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive, QRegExp::RegExp2);
+
+    QTextCursor cur(document());
+    while(marks.count() < 1000) {
+        cur = regex ? document()->find(rx, cur, flags) : document()->find(pattern, cur, flags);
+        if(cur.isNull() || !cur.hasSelection())
+            break;
+        QTextEdit::ExtraSelection sel;
+        sel.cursor = cur;
+        sel.format.setBackground(QColor(Qt::yellow));
+        marks.append(sel);
+    }
+    setExtraSelections(marks);
+    return marks.count();
+}
+
+/*
+ * Scroll to a history line without moving the output cursor.
+ * The document ends with the line being received and the terminal drops
+ * old blocks from the top, so blocks are counted back from the end.
+ * Returns false if the line is no longer in the document.
+ */
+bool Console::scrollToLine(int line)
+{
+    int block = line - (history.currentLine() - (blockCount()-1));
+    if(block < 0 || block >= blockCount())
+        return false;
+    QTextBlock found = document()->findBlockByNumber(block);
+    if(!found.isValid())
+        return false;
+    verticalScrollBar()->setValue(found.firstLineNumber());
+    return true;
+}
+
 void Console::setPortEnable(bool value)
 {
-    utfparse = false;
-    utfbytes = 0;
-    utf8 = 0;
+    termBuffer.decoder().reset();
     hexbytes = 0;
     for(int n = 0; n < maxhex; n++)
         hexbyte[n] = 0;
@@ -77,9 +173,7 @@ bool Console::serialPollEnabled()
 
 void Console::clear()
 {
-    utfparse = false;
-    utfbytes = 0;
-    utf8 = 0;
+    termBuffer.clear();
     hexbytes = 0;
     for(int n = 0; n < maxhex; n++)
         hexbyte[n] = 0;
@@ -125,8 +219,7 @@ QString Console::eventKey(QKeyEvent* event)
 void Console::keyPressEvent(QKeyEvent *event)
 {
     // qDebug() << "keyPressEvent";
-    MAINWINDOW *parentMain = (MAINWINDOW *)this->parentWidget()->parentWidget();
-
+    /* keys go to this console's own terminal session, not the main port */
     Terminal *term = (Terminal*) this->parentWidget();
     if(event->matches((QKeySequence::Copy))) {
         term->copyFromFile();
@@ -136,7 +229,7 @@ void Console::keyPressEvent(QKeyEvent *event)
         QClipboard *clip = QApplication::clipboard();
         QString s = clip->text();
         s = s.replace("\n","\r");
-        parentMain->sendPortMessage(s);
+        term->sendPortMessage(s);
     }
     else {
         QString s = eventKey(event);
@@ -145,7 +238,7 @@ void Console::keyPressEvent(QKeyEvent *event)
         if(this->enableEchoOn) {
             this->insertPlainText(s);
         }
-        parentMain->keyHandler(event);
+        term->sendPortMessage(s);
     }
 }
 
@@ -156,6 +249,7 @@ void Console::resizeEvent(QResizeEvent *e)
     if(fm.width("X") > 0) {
         maxcol = width()/fm.width("X")-3;
     }
+    setWrap();
 
     //qDebug() << maxcol << width() << fm.width("X");
     QPlainTextEdit::resizeEvent(e);
@@ -164,70 +258,87 @@ void Console::resizeEvent(QResizeEvent *e)
 void Console::setEnableClearScreen(bool value)
 {
      enableClearScreen = value;
+     termBuffer.decoder().setEnable(EN_ClearScreen, value);
 }
 void Console::setEnableHomeCursor(bool value)
 {
      enableHomeCursor = value;
+     termBuffer.decoder().setEnable(EN_HomeCursor, value);
 }
 void Console::setEnablePosXYCursor(bool value)
 {
      enablePosXYCursor = value;
+     termBuffer.decoder().setEnable(EN_PosXYCursor, value);
 }
 void Console::setEnableMoveCursorLeft(bool value)
 {
      enableMoveCursorLeft = value;
+     termBuffer.decoder().setEnable(EN_MoveCursorLeft, value);
 }
 void Console::setEnableMoveCursorRight(bool value)
 {
      enableMoveCursorRight = value;
+     termBuffer.decoder().setEnable(EN_MoveCursorRight, value);
 }
 void Console::setEnableMoveCursorUp(bool value)
 {
      enableMoveCursorUp = value;
+     termBuffer.decoder().setEnable(EN_MoveCursorUp, value);
 }
 void Console::setEnableMoveCursorDown(bool value)
 {
      enableMoveCursorDown = value;
+     termBuffer.decoder().setEnable(EN_MoveCursorDown, value);
 }
 void Console::setEnableBeepSpeaker(bool value)
 {
      enableBeepSpeaker = value;
+     termBuffer.decoder().setEnable(EN_BeepSpeaker, value);
 }
 void Console::setEnableBackspace(bool value)
 {
      enableBackspace = value;
+     termBuffer.decoder().setEnable(EN_Backspace, value);
 }
 void Console::setEnableTab(bool value)
 {
      enableTab = value;
+     termBuffer.decoder().setEnable(EN_Tab, value);
 }
 void Console::setEnableCReturn(bool value)
 {
      enableCReturn = value;
+     termBuffer.decoder().setEnable(EN_CReturn, value);
 }
 void Console::setEnableClearToEOL(bool value)
 {
      enableClearToEOL = value;
+     termBuffer.decoder().setEnable(EN_ClearToEOL, value);
 }
 void Console::setEnableClearLinesBelow(bool value)
 {
      enableClearLinesBelow = value;
+     termBuffer.decoder().setEnable(EN_ClearLinesBelow, value);
 }
 void Console::setEnableNewLine(bool value)
 {
      enableNewLine = value;
+     termBuffer.decoder().setEnable(EN_NewLine, value);
 }
 void Console::setEnablePosCursorX(bool value)
 {
      enablePosCursorX = value;
+     termBuffer.decoder().setEnable(EN_PosCursorX, value);
 }
 void Console::setEnablePosCursorY(bool value)
 {
      enablePosCursorY = value;
+     termBuffer.decoder().setEnable(EN_PosCursorY, value);
 }
 void Console::setEnableClearScreen16(bool value)
 {
      enableClearScreen16 = value;
+     termBuffer.decoder().setEnable(EN_ClearScreen2, value);
 }
 void Console::setEnableEchoOn(bool value)
 {
@@ -242,6 +353,7 @@ void Console::setEnableEnterIsNL(bool value)
 void Console::setEnableSwapNLCR(bool value)
 {
      enableSwapNLCR = value;
+     termBuffer.decoder().setSwapNLCR(value);
      if(enableSwapNLCR) {
          newline = 10;
          creturn = 13;
@@ -252,6 +364,16 @@ void Console::setEnableSwapNLCR(bool value)
      }
 }
 
+void Console::setEnableANSI(bool value)
+{
+     termBuffer.decoder().setANSI(value);
+}
+
+bool Console::getEnableANSI()
+{
+     return termBuffer.decoder().getANSI();
+}
+
 int Console::getEnter()
 {
     if(enableEnterIsNL)
@@ -262,6 +384,7 @@ int Console::getEnter()
 void Console::setWrapMode(int mode)
 {
     wrapMode = mode;
+    setWrap();
     if(mode == 0) {
         this->setWordWrapMode(QTextOption::WordWrap);
     }
@@ -273,6 +396,16 @@ void Console::setWrapMode(int mode)
 void Console::setTabSize(int size)
 {
     tabsize = size;
+    termBuffer.setTabSize(size);
+}
+
+/*
+ * Received text starts a new line at the wrap column,
+ * or at the window width if there is none.
+ */
+void Console::setWrap()
+{
+    termBuffer.setWrap(wrapMode > 0 ? wrapMode : maxcol);
 }
 
 void Console::setHexMode(bool enable)
@@ -297,17 +430,17 @@ enum { BUFFERSIZE = 64 };
 
 void Console::updateReady(QextSerialPort* port)
 {
-    char buf[BUFFERSIZE];
     if(isEnabled == false)
         return;
 
 #if 1
-    qint64 length = port->bytesAvailable();
-    if(length < 1) return;
-
+    /* readAll() drains the driver in large blocks; no bytesAvailable() probe */
     QByteArray ba = port->readAll();
-    length = ba.length();
+    qint64 length = ba.length();
+    if(length < 1) return;
+    received(ba);
 #else
+    char buf[BUFFERSIZE];
     if(port->bytesAvailable() < 1)
         return;
     int length = port->readLine(buf,BUFFERSIZE);
@@ -319,7 +452,7 @@ void Console::updateReady(QextSerialPort* port)
 
     if(hexmode != false) {
         for(int n = 0; n < length; n++)
-            dumphex((int)buf[n]);
+            dumphex((int)(uchar)ba.at(n));
     }
     else {
 #if 1
@@ -332,9 +465,10 @@ void Console::updateReady(QextSerialPort* port)
             while(jj > 0) {
                 extern bool g_ApplicationClosing;
                 if (g_ApplicationClosing) return;
-                for(int n = 0; n < jj; n++) {
-                    update(ba.at(n));
-                }
+                QElapsedTimer frame;
+                frame.start();
+                termBuffer.write(this, ba.constData(), jj);
+                frameDone(frame.nsecsElapsed()/1000);
                 QApplication::processEvents(QEventLoop::AllEvents, evlimit);
 
                 ba.remove(0,jj);
@@ -346,60 +480,64 @@ void Console::updateReady(QextSerialPort* port)
             if (port->isOpen()) {
                 ba = port->readAll();
                 length = ba.length();
+                if(length > 0)
+                    received(ba);
             }
         }
         this->setSerialPollEnable(true);
 #else
-        for(int n = 0; n < length; n++)
-            update(buf[n]);
+        termBuffer.write(this, buf, length);
 #endif
     }
     QApplication::processEvents();
 }
 
+/*
+ * The port's receive buffer is consumed in place, so don't let
+ * processEvents() below re-enter and refill it while we're using it.
+ * Anything that arrives meanwhile is picked up by the next readBuffer().
+ */
 void Console::updateReady(XEsp8266port* port)
 {
-    if(isEnabled == false)
+    if(isEnabled == false || wifiUpdating)
         return;
 
-    qint64 length = port->bytesAvailable();
-    if(length < 1) return;
+    if(port->bytesAvailable() < 1) return;
 
-    QByteArray ba = port->readAll();
-    length = ba.length();
+    wifiUpdating = true;
+    const QByteArray &ba = port->readBuffer();
+    int length = ba.length();
 
-    if(hexmode != false) {
-        for(int n = 0; n < length; n++)
-            dumphex((int)ba[n]);
-    }
-    else {
-        int jcount = 200;
-        // limit amount of time spent doing event updates
-        int evlimit= 100;
-        while (length > 0) {
-            int jj = (length > jcount) ? jcount : length;
-            while(jj > 0) {
+    while (length > 0) {
+        received(ba);
+        if(hexmode != false) {
+            for(int n = 0; n < length; n++)
+                dumphex((int)ba[n]);
+        }
+        else {
+            int jcount = 200;
+            // limit amount of time spent doing event updates
+            int evlimit= 100;
+            for(int pos = 0; pos < length; pos += jcount) {
                 extern bool g_ApplicationClosing;
-                if (g_ApplicationClosing) return;
-                for(int n = 0; n < jj; n++) {
-                    update(ba.at(n));
+                if (g_ApplicationClosing) {
+                    wifiUpdating = false;
+                    return;
                 }
+                int end = (length - pos > jcount) ? pos + jcount : length;
+                QElapsedTimer frame;
+                frame.start();
+                termBuffer.write(this, ba.constData() + pos, end - pos);
+                frameDone(frame.nsecsElapsed()/1000);
                 QApplication::processEvents(QEventLoop::AllEvents, evlimit);
-
-                ba.remove(0,jj);
-                length = ba.length();
-                jj = (length > jcount) ? jcount : length;
-
-                //QApplication::processEvents(QEventLoop::AllEvents, evlimit);
-            }
-            if (port->isOpen()) {
-                ba = port->readAll();
-                length = ba.length();
             }
         }
-        // simple but very slow way
-        // for(int n = 0; n < length; n++) update(ba[n]);
+        if (!port->isOpen())
+            break;
+        port->readBuffer();
+        length = ba.length();
     }
+    wifiUpdating = false;
     QApplication::processEvents();
 }
 
@@ -454,11 +592,13 @@ void Console::setCursorMode()
     }
 }
 
-void Console::update(char ch)
+/*
+ * TermBuffer hands over operations it can't batch at the end of the
+ * last line. Now that we have cursor positioning we can't always
+ * start at the end.
+ */
+void Console::apply(ConsoleDecoder::Op &op)
 {
-    int _x, _y;
-
-    QString text = "";
     QTextCursor cur = this->textCursor();
 
     this->setWordWrapMode(QTextOption::WrapAnywhere);
@@ -471,362 +611,214 @@ void Console::update(char ch)
         cur.insertBlock();
     }
 
-    // always start at the end just in case someone clicked the window
-    //moveCursor(QTextCursor::End);
-    // now that we have cursor positioning we can't always start at the end.
-
-    //qDebug(QString(" %1 %2").arg(ch, 2, 16, QChar('0')).arg(QChar(ch)).toLatin1());
-    //insertPlainText(QString(" %1 ").arg(ch, 2, 16, QChar('0')));
-    //insertPlainText(QChar(ch));
-
-    _x = cur.columnNumber();
-    _y = cur.blockNumber();
+    apply(cur, op);
+}
 
+/*
+ * Carry out one decoded terminal operation at the cursor.
+ */
+void Console::apply(QTextCursor &cur, ConsoleDecoder::Op &op)
+{
+    QString text;
 
-    //qDebug() << QString("%1 %2 %3 %4 %5").arg(pcmd,2,10,QChar('0')).arg(pcmdx,2,10,QChar('0')).arg(pcmdy,2,10,QChar('0')).arg(ch,2,10,QChar('0')).arg(ch,1,QChar('0'));
-    //qDebug() << QString("P %1,%2 X,Y %3,%4 %5").arg(pcmdx,2,10,QChar('0')).arg(pcmdy,2,10,QChar('0')).arg(cur.columnNumber(),2,10,QChar('0')).arg(cur.blockNumber(),2,10,QChar('0')).arg(ch,2,10,QChar('0'));
-    switch(pcmd)
+    switch(op.op)
     {
-        case PCMD_CURPOS_X: {
-                pcmdx = ch;
-                qDebug() << "CURPOS_X " << pcmdx;
-#if 0
-                cur.movePosition(QTextCursor::Start,QTextCursor::MoveAnchor);
-                cur.movePosition(QTextCursor::Down,QTextCursor::MoveAnchor,pcmdy);
-                setTextCursor(cur);
-#endif
-#if 1
+        case ConsoleDecoder::OP_POSX: {
                 int j = cur.block().length();
-                for(; j <= pcmdx; j++) {
+                for(; j <= op.x; j++) {
                     cur.movePosition(QTextCursor::EndOfLine,QTextCursor::MoveAnchor);
                     cur.insertText(" ");
                 }
-#endif
                 cur.movePosition(QTextCursor::StartOfLine,QTextCursor::MoveAnchor);
-                if(pcmdx > 0) cur.movePosition(QTextCursor::Right,QTextCursor::MoveAnchor,pcmdx);
+                if(op.x > 0) cur.movePosition(QTextCursor::Right,QTextCursor::MoveAnchor,op.x);
                 setTextCursor(cur);
-                pcmd = PCMD_NONE;
-                qDebug() << "CURPOS_X Column" << cur.columnNumber();
             }
             break;
 
-        case PCMD_CURPOS_Y: {
-                pcmdy = ch;
-                qDebug() << "CURPOS_Y " << pcmdy;
+        case ConsoleDecoder::OP_POSY: {
                 int j = this->blockCount();
-                for(; j <= pcmdy; j++) {
+                for(; j <= op.y; j++) {
                     cur.movePosition(QTextCursor::End);
                     cur.insertBlock(cur.blockFormat(),cur.charFormat());
                 }
                 cur.movePosition(QTextCursor::Start,QTextCursor::MoveAnchor);
-                if(pcmdy > 0) cur.movePosition(QTextCursor::Down,QTextCursor::MoveAnchor,pcmdy);
+                if(op.y > 0) cur.movePosition(QTextCursor::Down,QTextCursor::MoveAnchor,op.y);
                 setTextCursor(cur);
-#if 0
-                cur.movePosition(QTextCursor::StartOfLine,QTextCursor::MoveAnchor);
-                cur.movePosition(QTextCursor::Right,QTextCursor::MoveAnchor,pcmdx);
-                setTextCursor(cur);
-#endif
-                pcmd = PCMD_NONE;
-                qDebug() << "CURPOS_Y Column" << cur.columnNumber();
             }
             break;
 
-        case PCMD_CURPOS_XY: {
-#if 1
-            if(pcmdlen == 2) {
-                pcmdx = ch;
-            }
-            else if(pcmdlen == 1) {
-                pcmdy = ch;
+        case ConsoleDecoder::OP_POSXY: {
                 int j = this->blockCount();
-                for(; j <= pcmdy; j++) {
+                for(; j <= op.y; j++) {
                     cur.movePosition(QTextCursor::End);
                     cur.insertBlock();
                 }
                 cur.movePosition(QTextCursor::Start,QTextCursor::MoveAnchor);
-                if(pcmdy > 0)
-                    cur.movePosition(QTextCursor::Down, QTextCursor::MoveAnchor, pcmdy);
+                if(op.y > 0)
+                    cur.movePosition(QTextCursor::Down, QTextCursor::MoveAnchor, op.y);
 
                 j = cur.block().length();
-                for(; j <= pcmdx; j++) {
+                for(; j <= op.x; j++) {
                     cur.movePosition(QTextCursor::EndOfLine,QTextCursor::MoveAnchor);
                     cur.insertText(" ");
                 }
                 cur.movePosition(QTextCursor::StartOfLine,QTextCursor::MoveAnchor);
-                if(pcmdx > 0)
-                    cur.movePosition(QTextCursor::Right,QTextCursor::MoveAnchor,pcmdx);
+                if(op.x > 0)
+                    cur.movePosition(QTextCursor::Right,QTextCursor::MoveAnchor,op.x);
                 setTextCursor(cur);
             }
-            pcmdlen--;
-            if(pcmdlen < 1) {
-                pcmd = PCMD_NONE;
-            }
-#endif
-        }
-        break;
-
-        default: {
-
-
-            if (ch & 0x80) {    //UTF-8 parsing and handling
-                if (utfparse == true) {
-
-                    utf8 <<= 6;
-                    utf8 |= (ch & 0x3F);
-
-                    utfbytes--;
-
-                    if (utfbytes == 0) {
-                        utfparse = false;
-                        cur.insertText(QChar(utf8));
-                    }
-                } else {
-                    utfparse = true;
-                    utf8 = 0;
+            break;
 
-                    while (ch & 0x80) {
-                        ch <<= 1;
-                        utfbytes++;
-                    }
+        case ConsoleDecoder::OP_CLEAR: {
+                setPlainText("");
+            }
+            break;
 
-                    ch >>= utfbytes;
+        case ConsoleDecoder::OP_HOME: {
+                cur.movePosition(QTextCursor::Start,QTextCursor::MoveAnchor);
+                setTextCursor(cur);
+            }
+            break;
 
-                    utf8 = (int)ch;
+        case ConsoleDecoder::OP_LEFT: {
+                for(int n = 0; n < op.count && cur.columnNumber() > 0; n++)
+                    cur.movePosition(QTextCursor::Left,QTextCursor::MoveAnchor);
+                setTextCursor(cur);
+            }
+            break;
 
-                    utfbytes--;
+        case ConsoleDecoder::OP_RIGHT: {
+                for(int n = 0; n < op.count; n++) {
+                    if(cur.columnNumber() >= cur.block().length()-1)
+                        cur.insertText(" ");
+                    cur.movePosition(QTextCursor::Right,QTextCursor::MoveAnchor);
                 }
-                return;
+                setTextCursor(cur);
             }
+            break;
 
-            switch(ch)
-            {
-            case EN_ClearScreen: {
-                    if(this->enableClearScreen) {
-                        setPlainText("");
+        case ConsoleDecoder::OP_UP: {
+                for(int n = 0; n < op.count && cur.blockNumber() > 0; n++) {
+                    int col = cur.columnNumber();
+                    cur.movePosition(QTextCursor::Up,QTextCursor::MoveAnchor);
+                    int end = cur.block().length();
+                    for(int k = end; k <= col; k++) {
+                        cur.insertText(" ");
                     }
+                    cur.movePosition(QTextCursor::StartOfLine,QTextCursor::MoveAnchor);
+                    cur.movePosition(QTextCursor::Right,QTextCursor::MoveAnchor,col);
                 }
-                break;
-            case EN_ClearScreen2: {
-                    if(this->enableClearScreen16) {
-                        setPlainText("");
-                    }
-                }
-                break;
+                setTextCursor(cur);
+            }
+            break;
 
-            case EN_HomeCursor: {
-                    if(this->enableHomeCursor) {
-                        cur.movePosition(QTextCursor::Start,QTextCursor::MoveAnchor);
-                        setTextCursor(cur);
+        case ConsoleDecoder::OP_DOWN: {
+                for(int n = 0; n < op.count; n++) {
+                    int col = cur.columnNumber();
+                    int row = cur.blockNumber();
+                    int cnt = this->blockCount();
+                    if(row+1 < cnt) {
+                        cur.movePosition(QTextCursor::Down,QTextCursor::MoveAnchor);
+                        int end = cur.block().length();
+                        for(int k = end; k <= col; k++) {
+                            cur.insertText(" ");
+                            cur.movePosition(QTextCursor::EndOfLine,QTextCursor::MoveAnchor);
+                        }
+                        cur.movePosition(QTextCursor::StartOfLine,QTextCursor::MoveAnchor);
+                        cur.movePosition(QTextCursor::Right,QTextCursor::MoveAnchor, col);
+                    } else {
+                        cur.insertBlock();
+                        for(int k = 1; k < col; k++) {
+                            cur.insertText(" ");
+                        }
                     }
                 }
-                break;
+                setTextCursor(cur);
+            }
+            break;
 
-            case EN_PosCursorX: {
-                    if(this->enablePosCursorX) {
-                        pcmd = PCMD_CURPOS_X;
-                        pcmdlen  = 1;
-                    }
-                }
-                break;
+        case ConsoleDecoder::OP_BEEP: {
+                QApplication::beep();
+            }
+            break;
 
-            case EN_PosCursorY: {
-                    if(this->enablePosCursorY) {
-                        pcmd = PCMD_CURPOS_Y;
-                        pcmdlen  = 1;
-                    }
-                }
-                break;
+        case ConsoleDecoder::OP_BACKSPACE: {
+                /* removes the last character received, wherever the cursor is */
+                cur.movePosition(QTextCursor::End);
+                cur.deletePreviousChar();
+                setTextCursor(cur);
+            }
+            break;
 
-            case EN_PosXYCursor: {
-                    if(this->enablePosXYCursor) {
-                        pcmd = PCMD_CURPOS_XY;
-                        pcmdlen  = 2;
-                    }
+        case ConsoleDecoder::OP_TAB: {
+                int column = cur.columnNumber() % tabsize;
+                while(column++ < tabsize) {
+                    moveCursor(QTextCursor::Right,QTextCursor::MoveAnchor);
+                    cur.insertText(" ");
                 }
-                break;
-
-                case EN_MoveCursorLeft: {
-                        if(this->enableMoveCursorLeft) {
-                            if(cur.columnNumber() > 0) {
-                                cur.movePosition(QTextCursor::Left,QTextCursor::MoveAnchor);
-                                setTextCursor(cur);
-                            }
-                        }
-                    }
-                    break;
-
-                case EN_MoveCursorRight: {
-                        if(this->enableMoveCursorRight) {
-                            if(cur.columnNumber() >= cur.block().length()-1)
-                                cur.insertText(" ");
-                            cur.movePosition(QTextCursor::Right,QTextCursor::MoveAnchor);
-                            setTextCursor(cur);
-                        }
-                    }
-                    break;
-
-                case EN_MoveCursorUp: {
-                        if(this->enableMoveCursorUp) {
-                            if(cur.blockNumber() > 0) {
-                                int col = cur.columnNumber();
-                                qDebug() << "MU Column" << col;
-                                cur.movePosition(QTextCursor::Up,QTextCursor::MoveAnchor);
-                                int end = cur.block().length();
-                                for(int n = end; n <= col; n++) {
-                                    cur.insertText(" ");
-                                }
-                                cur.movePosition(QTextCursor::StartOfLine,QTextCursor::MoveAnchor);
-                                cur.movePosition(QTextCursor::Right,QTextCursor::MoveAnchor,col);
-                                setTextCursor(cur);
-                            }
-                        }
-                    }
-                    break;
-
-                case EN_MoveCursorDown: {
-                        if(this->enableMoveCursorDown) {
-                            int col = cur.columnNumber();
-                            int row = cur.blockNumber();
-                            int cnt = this->blockCount();
-                            int end = cur.block().length();
-                            qDebug() << "MD Column" << col;
-                            if(row+1 < cnt) {
-                                cur.movePosition(QTextCursor::Down,QTextCursor::MoveAnchor);
-                                end = cur.block().length();
-                                for(int n = end; n <= col; n++) {
-                                    cur.insertText(" ");
-                                    cur.movePosition(QTextCursor::EndOfLine,QTextCursor::MoveAnchor);
-                                }
-                                end = cur.block().length();
-                                cur.movePosition(QTextCursor::StartOfLine,QTextCursor::MoveAnchor);
-                                cur.movePosition(QTextCursor::Right,QTextCursor::MoveAnchor, col);
-                            } else {
-                                cur.insertBlock();
-                                for(int n = 1; n < col; n++) {
-                                    cur.insertText(" ");
-                                }
-                            }
-                            setTextCursor(cur);
-                        }
-                    }
-                    break;
+                setTextCursor(cur);
+            }
+            break;
 
-            case EN_BeepSpeaker: {
-                    if(this->enableBeepSpeaker) {
-                        QApplication::beep();
-                    }
+        case ConsoleDecoder::OP_NEWLINE: {
+                int row = cur.blockNumber();
+                int max = this->blockCount()-1;
+                if(row < max) {
+                    // insert a newline
+                    cur.movePosition(QTextCursor::EndOfLine,QTextCursor::KeepAnchor);
+                    text = cur.selectedText();
+                    cur.removeSelectedText();
+                    cur.movePosition(QTextCursor::Down,QTextCursor::MoveAnchor);
+                    cur.movePosition(QTextCursor::StartOfLine,QTextCursor::MoveAnchor);
+                    cur.insertText(text);
                 }
-                break;
-
-            case EN_Backspace: {
-                    if(this->enableBackspace) {
-                        text = toPlainText();
-                        setPlainText(text.mid(0,text.length()-1));
-                        moveCursor(QTextCursor::End);
-                    }
+                else {
+                    cur.insertBlock();
                 }
-                break;
+                setTextCursor(cur);
+            }
+            break;
 
-            case EN_Tab: {
-                    if(this->enableTab) {
-                        int column = cur.columnNumber() % tabsize;
-                        while(column++ < tabsize) {
-                            moveCursor(QTextCursor::Right,QTextCursor::MoveAnchor);
-                            cur.insertText(" ");
-                        }
+        case ConsoleDecoder::OP_CRETURN: {
+                cur.movePosition(QTextCursor::StartOfLine,QTextCursor::MoveAnchor);
+                setTextCursor(cur);
+            }
+            break;
+
+        case ConsoleDecoder::OP_CLEAR_EOL: {
+                int end = cur.block().length();
+                int col = cur.columnNumber();
+                if(end > col) {
+                    cur.clearSelection();
+                    cur.movePosition(QTextCursor::Right,QTextCursor::KeepAnchor,end-col-1);
+                    if(cur.hasSelection()) {
+                        cur.removeSelectedText();
                         setTextCursor(cur);
                     }
                 }
-                break;
-
-            /* fall through case because newline and creturn can change roles
-             * the switch is just to speed things up
-             */
-            case EN_NewLine: // fall through
-            case EN_CReturn: {
-                    if(ch == newline) {
-                        if(enableNewLine) {
-                            int row = cur.blockNumber();
-                            int max = this->blockCount()-1;
-                            if(row < max) {
-                                // insert a newline
-                                cur.movePosition(QTextCursor::EndOfLine,QTextCursor::KeepAnchor);
-                                text = cur.selectedText();
-                                cur.removeSelectedText();
-                                cur.movePosition(QTextCursor::Down,QTextCursor::MoveAnchor);
-                                cur.movePosition(QTextCursor::StartOfLine,QTextCursor::MoveAnchor);
-                                cur.insertText(text);
-                            }
-                            else {
-                                cur.insertBlock();
-                            }
-#if 0
-                            if(this->enableAddCRtoNL == false) {
-                                while(col-- > -1) {
-                                    cur.insertText(" ");
-                                    cur.movePosition(QTextCursor::Right,QTextCursor::MoveAnchor, 1);
-                                }
-                            }
-#endif
-                            setTextCursor(cur);
-                        }
-                    }
-                    else if(ch == creturn) {
-                        if(enableCReturn) {
-                            text = toPlainText();
-                            cur.movePosition(QTextCursor::StartOfLine,QTextCursor::MoveAnchor);
-                            setTextCursor(cur);
-                        }
-                    }
-                }
-                break;
+            }
+            break;
 
-            case EN_ClearToEOL: {
-                    if(this->enableClearToEOL) {
-                        int end = cur.block().length();
-                        int col = cur.columnNumber();
-                        if(end > col) {
-                            cur.clearSelection();
-                            cur.movePosition(QTextCursor::Right,QTextCursor::KeepAnchor,end-col-1);
-                            text = cur.selectedText();
-                            col = cur.columnNumber();
-                            if(text.length()) {
-                                cur.removeSelectedText();
-                                col = cur.columnNumber();
-                                text = cur.selectedText();
-                                col = cur.columnNumber();
-                                setTextCursor(cur);
-                                col = cur.columnNumber();
-                            }
-                        }
-                    }
-                }
-                break;
-
-            case EN_ClearLinesBelow: {
-                    if(this->enableClearLinesBelow) {
-                        int row = cur.blockNumber();
-                        int col = cur.columnNumber();
-                        cur.movePosition(QTextCursor::Start,QTextCursor::MoveAnchor);
-                        cur.movePosition(QTextCursor::Down,QTextCursor::KeepAnchor,row);
-                        cur.movePosition(QTextCursor::Right,QTextCursor::KeepAnchor,col);
-                        QString s = cur.selectedText();
-                        this->setPlainText(s);
-                    }
-                }
-                break;
+        case ConsoleDecoder::OP_CLEAR_BELOW: {
+                int row = cur.blockNumber();
+                int col = cur.columnNumber();
+                cur.movePosition(QTextCursor::Start,QTextCursor::MoveAnchor);
+                cur.movePosition(QTextCursor::Down,QTextCursor::KeepAnchor,row);
+                cur.movePosition(QTextCursor::Right,QTextCursor::KeepAnchor,col);
+                QString s = cur.selectedText();
+                this->setPlainText(s);
+            }
+            break;
 
-            default: {
-                    if(cur.block().length()-1 > cur.columnNumber())
-                        cur.movePosition(QTextCursor::Right,QTextCursor::KeepAnchor);
-                    cur.insertText(QString(ch));
-                    setTextCursor(cur);
-                }
-                break;
+        case ConsoleDecoder::OP_PRINT: {
+                if(cur.block().length()-1 > cur.columnNumber())
+                    cur.movePosition(QTextCursor::Right,QTextCursor::KeepAnchor);
+                cur.insertText(QString(QChar(op.ch)));
+                setTextCursor(cur);
             }
             break;
 
-        } // end pcmd default
-    } // end pcmd switch
-    return;
+        default:
+            break;
+    }
 }
@@ -23,8 +23,10 @@
 #include "qtversion.h"
 #include "qextserialport.h"
 #include "xesp8266port.h"
+#include "termview.h"
+#include "scrollback.h"
 
-class Console : public QPlainTextEdit
+class Console : public QPlainTextEdit, public TermView
 {
     Q_OBJECT
 public:
@@ -58,12 +60,28 @@ public:
     void setEnableEchoOn(bool value);
     void setEnableEnterIsNL(bool value);
     void setEnableSwapNLCR(bool value);
+    void setEnableANSI(bool value);
+    bool getEnableANSI();
 
     int  getEnter();
     void setWrapMode(int mode);
     void setTabSize(int size);
     void setHexMode(bool enable);
     void setHexDump(bool enable);
+    void setCapture(QIODevice *dev);
+
+    ScrollBack *getScrollBack();
+
+    /* receive and render counters for the terminal meters */
+    typedef struct {
+        qint64 rxBytes;
+        qint64 frames;          // batches drawn
+        qint64 frameUsTotal;
+        qint64 frameUsMax;
+    } Stats;
+    Stats takeStats();
+    int  highlightAll(const QString &pattern, bool regex, bool caseSensitive);
+    bool scrollToLine(int line);
 
 public:
 
@@ -91,19 +109,14 @@ public:
         EN_LAST
     } EnableEn;
 
+    void apply(ConsoleDecoder::Op &op);
+
 private:
 
-    typedef enum {
-        PCMD_NONE = 0,
-        PCMD_CURPOS_XY = 2,
-        PCMD_CURPOS_X = 14,
-        PCMD_CURPOS_Y = 15
-    } PCmdEn;
+    TermBuffer termBuffer;
 
-    PCmdEn  pcmd;
-    int     pcmdlen;
-    int     pcmdx;
-    int     pcmdy;
+    void apply(QTextCursor &cur, ConsoleDecoder::Op &op);
+    void setWrap();
 
     bool enableClearScreen;
     bool enableHomeCursor;
@@ -127,17 +140,13 @@ private:
 
     bool enableSwapNLCR;
 
-    bool enableANSI;
-
     char newline;
     char creturn;
     char lastchar;
 
     bool isSerialPollEnabled;
     bool isEnabled;
-    bool utfparse;
-    int  utfbytes;
-    int  utf8;
+    bool wifiUpdating;
 
     int  maxcol;
     int  maxrow;
@@ -154,6 +163,16 @@ private:
     // screen buffer
     char *sbuff;
 
+    // received bytes are copied here when capturing
+    QIODevice *capture;
+
+    // full history; the document only keeps the last few hundred lines
+    ScrollBack history;
+
+    void received(const QByteArray &ba);
+    void frameDone(qint64 us);
+    Stats stats;
+
 protected:
     void keyPressEvent(QKeyEvent* event);
     void resizeEvent(QResizeEvent *e);
@@ -162,7 +181,6 @@ public slots:
     void updateReady(QextSerialPort*);
     void updateReady(XEsp8266port *);
     void dumphex(int ch);
-    void update(char ch);
 
 };
 
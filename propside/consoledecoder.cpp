@@ -0,0 +1,287 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "consoledecoder.h"
+
+ConsoleDecoder::ConsoleDecoder()
+{
+    for(int n = 0; n < CODE_LAST; n++)
+        enabled[n] = true;
+    swapNLCR = false;
+    ansi = false;
+    reset();
+    rebuild();
+}
+
+void ConsoleDecoder::setEnable(int code, bool value)
+{
+    if(code < 0 || code >= CODE_LAST || enabled[code] == value)
+        return;
+    enabled[code] = value;
+    rebuild();
+}
+
+void ConsoleDecoder::setSwapNLCR(bool value)
+{
+    swapNLCR = value;
+    rebuild();
+}
+
+void ConsoleDecoder::setANSI(bool value)
+{
+    ansi = value;
+    rebuild();
+}
+
+bool ConsoleDecoder::getANSI()
+{
+    return ansi;
+}
+
+void ConsoleDecoder::reset()
+{
+    state = STATE_NORMAL;
+    pending = OP_NONE;
+    args = 0;
+    argx = 0;
+    utfbytes = 0;
+    utf8 = 0;
+    nparams = 0;
+}
+
+/*
+ * Map every byte to what it does with the current options.
+ * Disabled control codes are swallowed, as PST does.
+ */
+void ConsoleDecoder::rebuild()
+{
+    static const unsigned char pst[CODE_LAST] = {
+        OP_CLEAR,       // 0
+        OP_HOME,        // 1
+        OP_POSXY,       // 2
+        OP_LEFT,        // 3
+        OP_RIGHT,       // 4
+        OP_UP,          // 5
+        OP_DOWN,        // 6
+        OP_BEEP,        // 7
+        OP_BACKSPACE,   // 8
+        OP_TAB,         // 9
+        OP_CRETURN,     // 10 role, placed below
+        OP_CLEAR_EOL,   // 11
+        OP_CLEAR_BELOW, // 12
+        OP_NEWLINE,     // 13 role, placed below
+        OP_POSX,        // 14
+        OP_POSY,        // 15
+        OP_CLEAR        // 16
+    };
+
+    for(int n = 0; n < 0x80; n++)
+        table[n] = OP_PRINT;
+    for(int n = 0x80; n < 0x100; n++)
+        table[n] = OP_UTF8;
+
+    for(int n = 0; n < CODE_LAST; n++)
+        table[n] = enabled[n] ? pst[n] : (unsigned char) OP_NONE;
+
+    int newline = swapNLCR ? 10 : 13;
+    int creturn = swapNLCR ? 13 : 10;
+    table[newline] = enabled[CODE_NEWLINE] ? OP_NEWLINE : OP_NONE;
+    table[creturn] = enabled[CODE_CRETURN] ? OP_CRETURN : OP_NONE;
+
+    if(ansi)
+        table[0x1b] = OP_ESCAPE;
+}
+
+bool ConsoleDecoder::decode(unsigned char ch, Op *op)
+{
+    op->x = 0;
+    op->y = 0;
+    op->count = 1;
+    op->ch = ch;
+
+    switch(state)
+    {
+        case STATE_ARG:
+            if(--args > 0) {
+                argx = ch;
+                return false;
+            }
+            state = STATE_NORMAL;
+            op->op = pending;
+            if(pending == OP_POSXY) {
+                op->x = argx;
+                op->y = ch;
+            }
+            else if(pending == OP_POSX) {
+                op->x = ch;
+            }
+            else {
+                op->y = ch;
+            }
+            return true;
+
+        case STATE_UTF8:
+            if((ch & 0xc0) == 0x80) {
+                utf8 = (utf8 << 6) | (ch & 0x3f);
+                if(--utfbytes > 0)
+                    return false;
+                state = STATE_NORMAL;
+                op->op = OP_PRINT;
+                op->ch = utf8;
+                return true;
+            }
+            /* broken sequence, start over with this byte */
+            state = STATE_NORMAL;
+            break;
+
+        case STATE_ESC:
+        case STATE_CSI:
+            return decodeEscape(ch, op);
+
+        default:
+            break;
+    }
+
+    op->op = (OpEn) table[ch];
+    switch(op->op)
+    {
+        case OP_NONE:
+            return false;
+
+        case OP_POSXY:
+            pending = op->op;
+            args = 2;
+            state = STATE_ARG;
+            return false;
+
+        case OP_POSX:
+        case OP_POSY:
+            pending = op->op;
+            args = 1;
+            state = STATE_ARG;
+            return false;
+
+        case OP_UTF8:
+            if((ch & 0xe0) == 0xc0) {
+                utfbytes = 1;
+                utf8 = ch & 0x1f;
+            }
+            else if((ch & 0xf0) == 0xe0) {
+                utfbytes = 2;
+                utf8 = ch & 0x0f;
+            }
+            else if((ch & 0xf8) == 0xf0) {
+                utfbytes = 3;
+                utf8 = ch & 0x07;
+            }
+            else {
+                return false; // stray continuation byte
+            }
+            state = STATE_UTF8;
+            return false;
+
+        case OP_ESCAPE:
+            nparams = 0;
+            params[0] = 0;
+            state = STATE_ESC;
+            return false;
+
+        default:
+            return true;
+    }
+}
+
+/*
+ * ANSI subset: ESC [ row ; col H or f, ESC [ n A/B/C/D, ESC [ n J, ESC [ n K.
+ * Anything else, including SGR attributes, is consumed and ignored.
+ */
+bool ConsoleDecoder::decodeEscape(unsigned char ch, Op *op)
+{
+    if(state == STATE_ESC) {
+        state = (ch == '[') ? STATE_CSI : STATE_NORMAL;
+        return false;
+    }
+
+    if(ch >= '0' && ch <= '9') {
+        if(nparams == 0)
+            nparams = 1;
+        params[nparams-1] = params[nparams-1]*10 + (ch - '0');
+        return false;
+    }
+    if(ch == ';') {
+        if(nparams == 0)
+            nparams = 1;
+        if(nparams < MAX_PARAMS)
+            params[nparams++] = 0;
+        return false;
+    }
+    if(ch < 0x40 || ch > 0x7e) {
+        /* intermediate bytes like '?' don't end the sequence */
+        return false;
+    }
+
+    state = STATE_NORMAL;
+    int p0 = nparams > 0 ? params[0] : 0;
+    int p1 = nparams > 1 ? params[1] : 0;
+    int n  = p0 > 0 ? p0 : 1;
+
+    switch(ch)
+    {
+        case 'H':
+        case 'f':
+            op->op = OP_POSXY;
+            op->y = p0 > 0 ? p0-1 : 0;
+            op->x = p1 > 0 ? p1-1 : 0;
+            return true;
+        case 'A':
+            op->op = OP_UP;
+            op->count = n;
+            return true;
+        case 'B':
+            op->op = OP_DOWN;
+            op->count = n;
+            return true;
+        case 'C':
+            op->op = OP_RIGHT;
+            op->count = n;
+            return true;
+        case 'D':
+            op->op = OP_LEFT;
+            op->count = n;
+            return true;
+        case 'J':
+            if(p0 == 0) {
+                op->op = OP_CLEAR_BELOW;
+                return true;
+            }
+            if(p0 == 2) {
+                op->op = OP_CLEAR;
+                return true;
+            }
+            return false;
+        case 'K':
+            if(p0 == 0) {
+                op->op = OP_CLEAR_EOL;
+                return true;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,123 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CONSOLEDECODER_H
+#define CONSOLEDECODER_H
+
+/*
+ * Byte stream decoder for the Parallax Serial Terminal control set,
+ * with an optional ANSI/VT100 subset.
+ *
+ * Each received byte is one table lookup. The table is rebuilt only
+ * when an enable option changes, so disabled codes cost nothing per byte.
+ * The decoder knows nothing about the widget: decode() hands back an
+ * operation for the caller to apply to its text cursor.
+ */
+class ConsoleDecoder
+{
+public:
+    ConsoleDecoder();
+
+    typedef enum {
+        OP_NONE = 0,
+        OP_PRINT,
+        OP_CLEAR,
+        OP_HOME,
+        OP_POSXY,
+        OP_POSX,
+        OP_POSY,
+        OP_LEFT,
+        OP_RIGHT,
+        OP_UP,
+        OP_DOWN,
+        OP_BEEP,
+        OP_BACKSPACE,
+        OP_TAB,
+        OP_NEWLINE,
+        OP_CRETURN,
+        OP_CLEAR_EOL,
+        OP_CLEAR_BELOW,
+        // decoder internal, never returned
+        OP_ARG,
+        OP_UTF8,
+        OP_ESCAPE
+    } OpEn;
+
+    typedef struct {
+        OpEn op;
+        int  x;         // OP_POSXY, OP_POSX column
+        int  y;         // OP_POSXY, OP_POSY row
+        int  count;     // repeat count for cursor moves
+        unsigned int ch; // OP_PRINT character
+    } Op;
+
+    /*
+     * Enable or disable a PST control code. code is the control byte
+     * (0 to 16); 10 and 13 name the CR and NL roles, see setSwapNLCR.
+     */
+    void setEnable(int code, bool value);
+    void setSwapNLCR(bool value);
+    void setANSI(bool value);
+    bool getANSI();
+
+    /*
+     * Drop any partly received command or UTF-8 sequence.
+     */
+    void reset();
+
+    /*
+     * Feed one byte.
+     * @returns true when op holds an operation to apply.
+     */
+    bool decode(unsigned char ch, Op *op);
+
+    enum { CODE_LAST = 17 };
+    enum { CODE_CRETURN = 10 };
+    enum { CODE_NEWLINE = 13 };
+
+private:
+    void rebuild();
+    bool decodeEscape(unsigned char ch, Op *op);
+
+    typedef enum {
+        STATE_NORMAL = 0,
+        STATE_ARG,
+        STATE_UTF8,
+        STATE_ESC,
+        STATE_CSI
+    } StateEn;
+
+    enum { MAX_PARAMS = 4 };
+
+    unsigned char table[256];
+    bool enabled[CODE_LAST];
+    bool swapNLCR;
+    bool ansi;
+
+    StateEn state;
+    OpEn pending;   // command waiting for argument bytes
+    int  args;      // argument bytes still expected
+    int  argx;
+    int  utfbytes;
+    unsigned int utf8;
+    int  params[MAX_PARAMS];
+    int  nparams;
+};
+
+#endif // CONSOLEDECODER_H
@@ -40,6 +40,8 @@ Editor::Editor(GDB *gdebug, SpinParser *parser, QWidget *parent) : QPlainTextEdi
     gdb = gdebug;
     spinParser = parser;
     isSpin = false;
+    savedLength = 0;
+    savedHash = 0;
 
     lineNumberArea = new LineNumberArea(this);
     connect(this, SIGNAL(blockCountChanged(int)), this, SLOT(updateLineNumberAreaWidth(int)));
@@ -51,6 +53,8 @@ Editor::Editor(GDB *gdebug, SpinParser *parser, QWidget *parent) : QPlainTextEdi
     highlighter = NULL;
     setHighlights();
     setCenterOnScroll(true);
+
+    cbAuto.view()->installEventFilter(this);
 }
 
 Editor::~Editor()
@@ -79,6 +83,64 @@ void Editor::setHighlights(QString filename)
     }
 }
 
+Highlighter *Editor::getHighlighter()
+{
+    return highlighter;
+}
+
+/*
+ * Remember the text as it is on disk now.
+ */
+void Editor::setSaved()
+{
+    document()->setModified(false);
+    savedLength = document()->characterCount();
+    savedHash = qHash(toPlainText());
+}
+
+/*
+ * The document clears its modified flag when edits are undone back to
+ * the saved state. Text typed back to what was saved is caught by the
+ * length and hash; the hash is only taken when the lengths agree.
+ */
+bool Editor::isDirty()
+{
+    if(!document()->isModified())
+        return false;
+    if(document()->characterCount() != savedLength)
+        return true;
+    return qHash(toPlainText()) != savedHash;
+}
+
+/*
+ * Replace the text with a new copy of the file, changing only the span
+ * between the common start and end so the view, undo history and
+ * highlighting of the rest are kept.
+ */
+void Editor::reloadText(QString text)
+{
+    text.replace("\r\n","\n");
+    text.replace('\r','\n');
+    QString old = toPlainText();
+
+    int len = qMin(old.length(), text.length());
+    int head = 0;
+    while(head < len && old.at(head) == text.at(head))
+        head++;
+    int tail = 0;
+    while(tail < len-head && old.at(old.length()-1-tail) == text.at(text.length()-1-tail))
+        tail++;
+    if(head == old.length() && head == text.length())
+        return;
+
+    QTextCursor cur(document());
+    cur.beginEditBlock();
+    cur.setPosition(head);
+    cur.setPosition(old.length()-tail, QTextCursor::KeepAnchor);
+    cur.insertText(text.mid(head, text.length()-head-tail));
+    cur.endEditBlock();
+}
+
 void Editor::setLineNumber(int num)
 {
     QTextCursor cur = textCursor();
@@ -349,37 +411,14 @@ int Editor::autoEnterColumnSpin()
 }
 
 
+/*
+ * The highlighter keeps the block comment state of each line,
+ * so this is O(1) instead of rescanning the document.
+ */
 bool Editor::isCommentOpen(int line)
 {
-    // find out if there is a brace mismatch
-    QString s = this->toPlainText();
-    QStringList sl = s.split("\n",QString::SkipEmptyParts);
-    int length = sl.length();
-
-    int como = 0;
-    int comc = 0;
-
-    int lpos = -1;
-    int cpos = -1;
-
-    for(int n = 0; n < length; n++) {
-        s = sl.at(n);
-        if(s.contains("/*")) {
-            como++;
-        }
-        if(s.contains("*/")) {
-            comc++;
-        }
-        cpos = s.lastIndexOf("*");
-        if(line == n && como > comc) {
-            if(lpos > -1 && cpos == lpos) {
-                return true;
-            }
-        }
-        lpos = cpos;
-
-    }
-    return !(como == comc);
+    QTextBlock block = document()->findBlockByNumber(line);
+    return block.isValid() && block.userState() == 1;
 }
 
 int Editor::braceMatchColumn()
@@ -401,50 +440,12 @@ int Editor::braceMatchColumn()
     if(text.contains("{"))
         return 0;
 
-    // find out if there is a brace mismatch
-    QString s = this->toPlainText();
-
-    //QStringList sl = this->toPlainText().split(QRegExp("/\\*.*\\*/"));
-    //qDebug() << s;
-    //s = sl.join("\n");
-    //qDebug() << s;
-    QStringList sl = s.split("\n",QString::SkipEmptyParts);
-    int length = sl.length();
-
-    int braceo = 0;
-    int bracec = 0;
-
-    bool blockComment = false;
-
-    for(int n = 0; n < length; n++) {
-        QString s = sl.at(n);
-        if(s.contains("/*") && s.contains("*/")) {
-            QString t = s.mid(s.indexOf("*/")+2);
-            s = s.mid(0, s.indexOf("/*"));
-            s += t;
-        }
-        if(blockComment && s.contains("*/")) {
-            s = s.mid(s.indexOf("*/")+2);
-            blockComment = false;
-        }
-        if(blockComment)
-            continue;
-        if(s.contains("/*") && !s.contains("*/")) {
-            s = s.mid(0, s.indexOf("/*"));
-            blockComment = true;
-        }
-        //qDebug() << "BMATCH" << s;
-
-        if(s.contains("{")) {
-            braceo++;
-        }
-        if(s.contains("}")) {
-            bracec++;
-        }
-    }
+    // find out if there is a brace mismatch; the highlighter keeps count
+    if(highlighter == NULL)
+        return 0;
 
     // if all braces match exit
-    if(braceo == bracec) {
+    if(highlighter->braceBalance() == 0) {
         return 0;
     }
     qDebug() << "Brace Mismatch";
@@ -632,96 +633,26 @@ int Editor::spinAutoComplete()
     QString text = selectAutoComplete();
     // if(text.compare("#") == 0) // would like to autocomplete on previous object
 
+    disconnect(&cbAuto,SIGNAL(activated(int)),this,SLOT(cbAutoSelected(int)));
+    disconnect(&cbAuto,SIGNAL(activated(int)),this,SLOT(cbAutoSelected0insert(int)));
     /*
      * we have an object name. get object info
      */
     if(text.length() > 0) {
-        disconnect(&cbAuto,SIGNAL(activated(int)),this,SLOT(cbAutoSelected(int)));
-        disconnect(&cbAuto,SIGNAL(activated(int)),this,SLOT(cbAutoSelected0insert(int)));
         connect(&cbAuto, SIGNAL(activated(int)), this, SLOT(cbAutoSelected0insert(int)));
         qDebug() << "keyPressEvent object dot pressed" << text;
-        QStringList list = spinParser->spinSymbols(fileName,text);
-        if(list.count() == 0)
-            return 0;
-        cbAuto.clear();
-        // we depend on index item 0 to be the auto-start key
-        cbAuto.addItem(".");
-        if(list.count() > 0) {
-            int width = 0;
-            list.sort();
-            for(int j = 0; j < list.count(); j++) {
-                QString s = list[j];
-                QString type = s;
-
-#ifdef AUTOCON
-                if(type.at(0) == 'c') // don't show con for object. - # shows con
-                    continue;
-                if(type.at(0) == 'e') // don't show enum for object. - # shows enums
-                    continue;
-#endif
-                if(type.at(0) == 'o') // don't show obj for object.
-                    continue;
-                if(type.at(0) == 'p') // don't show pri for object.
-                    continue;
-                if(type.at(0) == 'v') // don't show var for object.
-                    continue;
-                if(type.at(0) == 'x') // don't show dat for object.
-                    continue;
-
-                s = spinPrune(s);
-                if(s.length() > width)
-                    width = s.length();
-                addAutoItem(type, s);
-            }
-            spinAutoShow(width);
-        }
-        return 1;
     }
     /*
      * no object name. get local info
      */
     else {
-        disconnect(&cbAuto,SIGNAL(activated(int)),this,SLOT(cbAutoSelected(int)));
-        disconnect(&cbAuto,SIGNAL(activated(int)),this,SLOT(cbAutoSelected0insert(int)));
         connect(&cbAuto, SIGNAL(activated(int)), this, SLOT(cbAutoSelected(int)));
         qDebug() << "keyPressEvent local dot pressed";
-        QStringList list = spinParser->spinSymbols(fileName,"");
-        if(list.count() == 0)
-            return 0;
-        cbAuto.clear();
-        cbAuto.addItem(".");
-        if(list.count() > 0) {
-            int width = 0;
-            list.sort();
-            // always put objects on top
-            for(int j = 0; j < list.count(); j++) {
-                QString s = list[j];
-                QString type = s;
-                if(type.at(0) == 'o') {
-                    list.removeAt(j);
-                    list.insert(0,s);
-                }
-            }
-            // add all elements
-            for(int j = 0; j < list.count(); j++) {
-                QString s = list[j];
-                QString type = s;
-#ifdef AUTOCON
-                if(type.at(0) == 'c')
-                    continue;
-                if(type.at(0) == 'e')
-                    continue;
-#endif
-                s = spinPrune(s);
-                if(s.length() > width)
-                    width = s.length();
-                addAutoItem(type, s);
-            }
-            spinAutoShow(width);
-        }
-        return 1;
     }
-    return 0;
+    autoKey = ".";
+    autoObject = text;
+    autoPrefix.clear();
+    return spinAutoFill();
 }
 
 int  Editor::spinAutoCompleteCON()
@@ -729,62 +660,116 @@ int  Editor::spinAutoCompleteCON()
 #ifdef AUTOCON
     QString text = selectAutoComplete();
 
+    disconnect(&cbAuto,SIGNAL(activated(int)),this,SLOT(cbAutoSelected(int)));
+    disconnect(&cbAuto,SIGNAL(activated(int)),this,SLOT(cbAutoSelected0insert(int)));
     if(text.length() > 0) {
-        disconnect(&cbAuto,SIGNAL(activated(int)),this,SLOT(cbAutoSelected(int)));
-        disconnect(&cbAuto,SIGNAL(activated(int)),this,SLOT(cbAutoSelected0insert(int)));
         connect(&cbAuto, SIGNAL(activated(int)), this, SLOT(cbAutoSelected0insert(int)));
         qDebug() << "keyPressEvent # pressed" << text;
-        QStringList list = spinParser->spinConstants(fileName,text);
-        if(list.count() == 0)
-            return 0;
-        cbAuto.clear();
-        // we depend on index item 0 to be the auto-start key
-        cbAuto.addItem(QString("#"));
-        if(list.count() > 0) {
-            int width = 0;
-            list.sort();
-            for(int j = 0; j < list.count(); j++) {
-                QString s = list[j];
-                QString type = s;
-                s = spinPrune(s);
-                if(s.length() > width)
-                    width = s.length();
-                addAutoItem(type, s);
-            }
-            spinAutoShow(width);
-        }
-        return 1;
     }
     /*
      * no object name. get local info
      */
     else {
-        disconnect(&cbAuto,SIGNAL(activated(int)),this,SLOT(cbAutoSelected(int)));
-        disconnect(&cbAuto,SIGNAL(activated(int)),this,SLOT(cbAutoSelected0insert(int)));
         connect(&cbAuto, SIGNAL(activated(int)), this, SLOT(cbAutoSelected(int)));
         qDebug() << "keyPressEvent local # pressed";
-        QStringList list = spinParser->spinConstants(fileName,"");
-        if(list.count() == 0)
-            return 0;
-        cbAuto.clear();
-        cbAuto.addItem(QString("#"));
-        if(list.count() > 0) {
-            int width = 0;
-            list.sort();
-            for(int j = 0; j < list.count(); j++) {
-                QString s = list[j];
-                QString type = s;
-                s = spinPrune(s);
-                if(s.length() > width)
-                    width = s.length();
-                addAutoItem(type, s);
+    }
+    autoKey = "#";
+    autoObject = text;
+    autoPrefix.clear();
+    return spinAutoFill();
+#endif
+    return 0;
+}
+
+/*
+ * Fill the autocomplete list with the names starting with the text typed
+ * since it opened. Item 0 is the auto-start key and that text, inserted
+ * as is if picked.
+ * Returns 0 if there is nothing to show.
+ */
+int Editor::spinAutoFill()
+{
+    QStringList list;
+    if(autoKey == "#")
+        list = spinParser->spinConstants(fileName, autoObject, autoPrefix);
+    else
+        list = spinParser->spinSymbols(fileName, autoObject, autoPrefix);
+    if(list.count() == 0 && autoPrefix.isEmpty())
+        return 0;
+
+    cbAuto.clear();
+    // we depend on index item 0 to be the auto-start key
+    cbAuto.addItem(autoKey+autoPrefix);
+    int width = cbAuto.itemText(0).length();
+
+    // list comes ranked by recent use, kind and name
+    if(autoKey == "." && autoObject.isEmpty()) {
+        // always put objects on top
+        for(int j = 0; j < list.count(); j++) {
+            QString s = list[j];
+            QString type = s;
+            if(type.at(0) == 'o') {
+                list.removeAt(j);
+                list.insert(0,s);
             }
-            spinAutoShow(width);
         }
-        return 1;
     }
+    for(int j = 0; j < list.count(); j++) {
+        QString s = list[j];
+        QString type = s;
+        if(autoKey == ".") {
+#ifdef AUTOCON
+            if(type.at(0) == 'c') // # shows con
+                continue;
+            if(type.at(0) == 'e') // # shows enums
+                continue;
 #endif
-    return 0;
+            if(autoObject.length() > 0) {
+                if(type.at(0) == 'o') // don't show obj for object.
+                    continue;
+                if(type.at(0) == 'p') // don't show pri for object.
+                    continue;
+                if(type.at(0) == 'v') // don't show var for object.
+                    continue;
+                if(type.at(0) == 'x') // don't show dat for object.
+                    continue;
+            }
+        }
+        s = spinPrune(s);
+        if(s.length() > width)
+            width = s.length();
+        addAutoItem(type, s);
+    }
+    // with text typed, the best match is picked by enter
+    if(autoPrefix.length() > 0 && cbAuto.count() > 1)
+        cbAuto.setCurrentIndex(1);
+    spinAutoShow(width);
+    return 1;
+}
+
+/*
+ * Typing while the autocomplete list is up narrows it to the names
+ * starting with the typed text; backspace widens it again.
+ */
+bool Editor::eventFilter(QObject *obj, QEvent *event)
+{
+    if(obj == cbAuto.view() && event->type() == QEvent::KeyPress) {
+        QKeyEvent *e = static_cast<QKeyEvent*>(event);
+        QString t = e->text();
+        if(e->key() == Qt::Key_Backspace) {
+            if(autoPrefix.length() > 0) {
+                autoPrefix.chop(1);
+                spinAutoFill();
+            }
+            return true;
+        }
+        if(t.length() == 1 && (t.at(0).isLetterOrNumber() || t.at(0) == '_')) {
+            autoPrefix += t;
+            spinAutoFill();
+            return true;
+        }
+    }
+    return QPlainTextEdit::eventFilter(obj, event);
 }
 
 void Editor::cbAutoSelected0insert(int index)
@@ -792,9 +777,11 @@ void Editor::cbAutoSelected0insert(int index)
     QString s = cbAuto.itemText(index);
     QTextCursor cur = this->textCursor();
     s = deletePrefix(s);
-    if(index != 0)
+    if(index != 0) {
         // we depend on index item 0 to be the auto-start key
-        cur.insertText(cbAuto.itemText(0)+s.trimmed());
+        cur.insertText(autoKey+s.trimmed());
+        spinAutoUsed(s);
+    }
     else
         cur.insertText(cbAuto.itemText(0));
     cbAuto.hide();
@@ -806,10 +793,25 @@ void Editor::cbAutoSelected(int index)
     QTextCursor cur = this->textCursor();
     s = deletePrefix(s);
     cur.insertText(s.trimmed());
+    if(index != 0)
+        spinAutoUsed(s);
 
     cbAuto.hide();
 }
 
+/*
+ * Tell the parser the name picked so it is listed first next time.
+ */
+void Editor::spinAutoUsed(QString s)
+{
+    s = s.trimmed();
+    int len = 0;
+    while(len < s.length() && (s.at(len).isLetterOrNumber() || s.at(len) == '_'))
+        len++;
+    if(len > 0)
+        spinParser->useSymbol(s.left(len));
+}
+
 int Editor::contextHelp()
 {
     QTextCursor cur = this->cursorForPosition(mousepos);
@@ -999,6 +1001,13 @@ void Editor::updateLineNumberArea(const QRect &rect, int dy)
 
     if (rect.contains(viewport()->rect()))
         updateLineNumberAreaWidth(0);
+
+    /* let a background highlight do the visible lines first */
+    if(highlighter != NULL && highlighter->isFilling()) {
+        int first = firstVisibleBlock().blockNumber();
+        int rows = viewport()->height()/fontMetrics().height() + 1;
+        highlighter->setVisibleBlocks(first, first+rows);
+    }
 }
 
 //![slotUpdateRequest]
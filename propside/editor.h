@@ -37,6 +37,11 @@ public:
     void setLineNumber(int num);
 
     void clearCtrlPressed();
+    Highlighter *getHighlighter();
+
+    void setSaved();
+    bool isDirty();
+    void reloadText(QString text);
 
 private:
     int  autoEnterColumn();
@@ -49,6 +54,8 @@ private:
     void spinAutoShow(int width);
     int  spinAutoComplete();
     int  spinAutoCompleteCON();
+    int  spinAutoFill();
+    void spinAutoUsed(QString s);
     int  contextHelp();
     int  tabBlockShift();
     bool isNotAutoComplete();
@@ -56,6 +63,7 @@ private:
     QString deletePrefix(QString s);
 
 protected:
+    bool eventFilter(QObject *obj, QEvent *event);
     void keyPressEvent(QKeyEvent* e);
     void keyReleaseEvent(QKeyEvent* e);
     void mousePressEvent(QMouseEvent* e);
@@ -71,7 +79,14 @@ private:
     bool    isSpin;
     Highlighter *highlighter;
 
+    /* document as last loaded or saved */
+    int     savedLength;
+    uint    savedHash;
+
     QComboBox cbAuto;
+    QString autoKey;        // "." or "#" that opened the list
+    QString autoObject;     // object name before the key, if any
+    QString autoPrefix;     // typed since the list opened
 
 private slots:
     void cbAutoSelected(int index);
@@ -0,0 +1,491 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fileviewer.h"
+
+/* lines found between index updates */
+#define INDEX_BATCH         65536
+/* bytes read at a time while indexing or finding */
+#define READ_CHUNK          (1024*1024)
+/* quiet time after a change before the file is reopened */
+#define RELOAD_DELAY        500
+/* characters decoded for one line; the rest is not shown */
+#define MAX_LINE_CHARS      4096
+#define TAB_WIDTH           8
+
+/*
+ * Finds line starts in the file and hands them to the viewer in
+ * batches. It reads with its own handle so the viewer can read
+ * lines at the same time. A file cut short while indexing just
+ * ends the index early.
+ */
+class FileLineIndex : public QThread
+{
+public:
+    FileLineIndex(FileViewer *viewer) : viewer(viewer)
+    {
+    }
+
+    void stop()
+    {
+        stopping.fetchAndStoreRelaxed(1);
+        wait();
+    }
+
+protected:
+    void run()
+    {
+        qint64 size = viewer->size;
+        QVector<qint64> list;
+        int longest = 0;
+        qint64 start = 0;
+        qint64 pos = 0;
+
+        QFile in(viewer->fileName);
+        if(in.open(QFile::ReadOnly)) {
+            while(pos < size && stopping.fetchAndAddRelaxed(0) == 0) {
+                QByteArray buf = in.read(qMin((qint64) READ_CHUNK, size-pos));
+                if(buf.isEmpty())
+                    break;
+                const char *data = buf.constData();
+                int n = buf.size();
+                const char *nl = data;
+                while((nl = (const char *) memchr(nl, '\n', (size_t) (data+n-nl))) != NULL) {
+                    qint64 end = pos + (nl-data);
+                    if(end-start > longest)
+                        longest = (int) qMin(end-start, (qint64) MAX_LINE_CHARS);
+                    start = end+1;
+                    if(start < size)
+                        list.append(start);
+                    nl++;
+                }
+                pos += n;
+                if(list.count() >= INDEX_BATCH)
+                    publish(list, longest, false);
+            }
+            in.close();
+        }
+        if(pos-start > longest)
+            longest = (int) qMin(pos-start, (qint64) MAX_LINE_CHARS);
+        if(stopping.fetchAndAddRelaxed(0) == 0)
+            publish(list, longest, true);
+    }
+
+private:
+    void publish(QVector<qint64> &list, int longest, bool done)
+    {
+        viewer->mutex.lock();
+        viewer->offsets += list;
+        viewer->longest = qMax(viewer->longest, longest);
+        if(done)
+            viewer->indexed = true;
+        viewer->mutex.unlock();
+        list.clear();
+        QMetaObject::invokeMethod(viewer, "indexProgress", Qt::QueuedConnection);
+    }
+
+    FileViewer  *viewer;
+    QAtomicInt  stopping;
+};
+
+FileViewer::FileViewer(QWidget *parent) :
+    QAbstractScrollArea(parent)
+{
+    size = 0;
+    indexer = NULL;
+    longest = 0;
+    indexed = false;
+    current = -1;
+    reloadTop = -1;
+    setFocusPolicy(Qt::StrongFocus);
+    viewport()->setCursor(Qt::IBeamCursor);
+
+    reloadTimer.setSingleShot(true);
+    reloadTimer.setInterval(RELOAD_DELAY);
+    connect(&reloadTimer,SIGNAL(timeout()),this,SLOT(reloadFile()));
+    connect(&watcher,SIGNAL(fileChanged(QString)),this,SLOT(fileChanged()));
+}
+
+FileViewer::~FileViewer()
+{
+    closeFile();
+}
+
+/**
+ * Open the file, start indexing it and watch it for changes.
+ * @returns false if the file can't be opened.
+ */
+bool FileViewer::openFile(const QString &name)
+{
+    closeFile();
+    file.setFileName(name);
+    if(!file.open(QFile::ReadOnly))
+        return false;
+    size = file.size();
+    fileName = name;
+    if(!watcher.files().contains(name))
+        watcher.addPath(name);
+    offsets.append(0);
+    indexer = new FileLineIndex(this);
+    indexer->start(QThread::LowPriority);
+    updateTitle();
+    updateScrollBars();
+    return true;
+}
+
+void FileViewer::closeFile()
+{
+    reloadTimer.stop();
+    if(!watcher.files().isEmpty())
+        watcher.removePaths(watcher.files());
+    if(indexer != NULL) {
+        indexer->stop();
+        delete indexer;
+        indexer = NULL;
+    }
+    if(file.isOpen())
+        file.close();
+    size = 0;
+    offsets.clear();
+    longest = 0;
+    indexed = false;
+    current = -1;
+}
+
+/**
+ * @returns name of the file being viewed.
+ */
+QString FileViewer::path()
+{
+    return fileName;
+}
+
+/**
+ * @returns number of lines indexed so far.
+ */
+int FileViewer::lineCount()
+{
+    QMutexLocker lock(&mutex);
+    /* the last start found has no known end until indexing is done */
+    return indexed ? offsets.count() : qMax(offsets.count()-1, 0);
+}
+
+bool FileViewer::isIndexing()
+{
+    QMutexLocker lock(&mutex);
+    return file.isOpen() && !indexed;
+}
+
+/**
+ * Select a line and scroll it into the middle of the view.
+ * @param line line number starting from 1.
+ */
+void FileViewer::gotoLine(int line)
+{
+    int count = lineCount();
+    if(count < 1)
+        return;
+    current = qBound(0, line-1, count-1);
+    verticalScrollBar()->setValue(current-visibleLines()/2);
+    viewport()->update();
+}
+
+/**
+ * Find text after the selected line, wrapping at the end of the file.
+ * The search is case sensitive and works on the UTF-8 bytes.
+ * @returns false if the text is not in the indexed part of the file.
+ */
+bool FileViewer::find(const QString &text)
+{
+    findText = text;
+    if(text.isEmpty() || !file.isOpen())
+        return false;
+
+    QByteArray key = text.toUtf8();
+    qint64 from = 0;
+    if(current >= 0 && current+1 < lineCount()) {
+        mutex.lock();
+        from = offsets[current+1];
+        mutex.unlock();
+    }
+    qint64 pos = findBytes(key, from);
+    if(pos < 0 && from > 0)
+        pos = findBytes(key, 0);
+    if(pos < 0)
+        return false;
+
+    int line = lineAt(pos);
+    if(line >= lineCount())
+        return false;
+    gotoLine(line+1);
+    return true;
+}
+
+void FileViewer::gotoLineDialog()
+{
+    bool ok = false;
+    int count = lineCount();
+    int line = QInputDialog::getInt(this, tr("Go to Line"),
+                tr("Line (1 - %1):").arg(count), current+1, 1, qMax(count, 1), 1, &ok);
+    if(ok)
+        gotoLine(line);
+}
+
+void FileViewer::findDialog()
+{
+    bool ok = false;
+    QString text = QInputDialog::getText(this, tr("Find"), tr("Find text:"),
+                QLineEdit::Normal, findText, &ok);
+    if(ok && text.length() > 0 && !find(text)) {
+        QMessageBox::information(this, tr("Find"),
+                isIndexing() ? tr("\"%1\" was not found yet. The file is still being indexed.").arg(text)
+                             : tr("\"%1\" was not found.").arg(text));
+    }
+}
+
+void FileViewer::findNext()
+{
+    if(findText.isEmpty())
+        findDialog();
+    else if(!find(findText))
+        QMessageBox::information(this, tr("Find"), tr("\"%1\" was not found.").arg(findText));
+}
+
+void FileViewer::indexProgress()
+{
+    updateScrollBars();
+    if(reloadTop >= 0 && (reloadTop <= verticalScrollBar()->maximum() || !isIndexing())) {
+        verticalScrollBar()->setValue(reloadTop);
+        reloadTop = -1;
+    }
+    updateTitle();
+    viewport()->update();
+}
+
+/*
+ * The build rewrites map files and listings while they are open.
+ * Each write sends a change, so wait until they stop.
+ */
+void FileViewer::fileChanged()
+{
+    reloadTimer.start();
+}
+
+/*
+ * Reopen the file after it changed. The selected line and scroll
+ * position come back once enough of the new file is indexed.
+ */
+void FileViewer::reloadFile()
+{
+    int line = current;
+    int top = verticalScrollBar()->value();
+    reloadTop = -1;
+    if(!openFile(fileName)) {
+        /* removed; keep watching in case it is written again */
+        if(QFile::exists(fileName) && !watcher.files().contains(fileName))
+            watcher.addPath(fileName);
+        updateTitle();
+        updateScrollBars();
+        viewport()->update();
+        return;
+    }
+    current = line;
+    reloadTop = top;
+    viewport()->update();
+}
+
+/*
+ * Decode one line with tabs expanded.
+ */
+QString FileViewer::lineText(int line)
+{
+    mutex.lock();
+    if(line < 0 || line >= offsets.count()) {
+        mutex.unlock();
+        return QString();
+    }
+    qint64 start = offsets[line];
+    qint64 end = line+1 < offsets.count() ? offsets[line+1] : size;
+    mutex.unlock();
+
+    /* a file cut short reads fewer bytes, never past the end */
+    QByteArray bytes;
+    if(file.isOpen() && file.seek(start))
+        bytes = file.read(qMin(end-start, (qint64) MAX_LINE_CHARS));
+    while(bytes.endsWith('\n') || bytes.endsWith('\r'))
+        bytes.chop(1);
+    QString text = QString::fromUtf8(bytes.constData(), bytes.size());
+    if(!text.contains('\t'))
+        return text;
+
+    QString out;
+    foreach(QChar c, text) {
+        if(c == '\t')
+            out += QString(TAB_WIDTH - out.length() % TAB_WIDTH, ' ');
+        else
+            out += c;
+    }
+    return out;
+}
+
+/*
+ * Find bytes from an offset to the end of the file. Reads overlap by
+ * the key length so a match across two reads is still found.
+ * Returns the offset of the match or -1.
+ */
+qint64 FileViewer::findBytes(const QByteArray &key, qint64 from)
+{
+    qint64 pos = from;
+    while(pos < size && file.seek(pos)) {
+        QByteArray buf = file.read(qMin((qint64) READ_CHUNK+key.size()-1, size-pos));
+        if(buf.size() < key.size())
+            break;
+        int at = buf.indexOf(key);
+        if(at >= 0)
+            return pos+at;
+        pos += buf.size()-key.size()+1;
+    }
+    return -1;
+}
+
+int FileViewer::lineAt(qint64 offset)
+{
+    QMutexLocker lock(&mutex);
+    QVector<qint64>::const_iterator it = qUpperBound(offsets.constBegin(), offsets.constEnd(), offset);
+    return (int) (it - offsets.constBegin()) - 1;
+}
+
+int FileViewer::visibleLines()
+{
+    return qMax(viewport()->height() / fontMetrics().height(), 1);
+}
+
+void FileViewer::updateScrollBars()
+{
+    int count = lineCount();
+    verticalScrollBar()->setRange(0, qMax(count-visibleLines(), 0));
+    verticalScrollBar()->setPageStep(visibleLines());
+
+    int cw = fontMetrics().width(QLatin1Char('0'));
+    mutex.lock();
+    int width = longest;
+    mutex.unlock();
+    int columns = qMax(viewport()->width()/qMax(cw, 1) - 8, 1);
+    horizontalScrollBar()->setRange(0, qMax(width+TAB_WIDTH-columns, 0));
+    horizontalScrollBar()->setPageStep(columns);
+}
+
+void FileViewer::updateTitle()
+{
+    QString name = QDir::toNativeSeparators(fileName);
+    if(isIndexing())
+        setWindowTitle(tr("%1 (%2 lines so far)").arg(name).arg(lineCount()));
+    else
+        setWindowTitle(tr("%1 (%2 lines)").arg(name).arg(lineCount()));
+}
+
+void FileViewer::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(viewport());
+    painter.fillRect(event->rect(), palette().base());
+    if(!file.isOpen())
+        return;
+
+    QFontMetrics fm = fontMetrics();
+    int height = fm.height();
+    int cw = fm.width(QLatin1Char('0'));
+    int count = lineCount();
+    int first = verticalScrollBar()->value();
+    int last = qMin(first+visibleLines()+1, count);
+    int gutter = fm.width(QString::number(qMax(count, 1)))+cw;
+    int left = gutter+cw/2 - horizontalScrollBar()->value()*cw;
+
+    painter.setPen(palette().text().color());
+    for(int line = first; line < last; line++) {
+        int y = (line-first)*height;
+        if(line == current)
+            painter.fillRect(0, y, viewport()->width(), height, QColor(Qt::yellow).lighter(160));
+        painter.drawText(left, y+fm.ascent(), lineText(line));
+    }
+
+    /* line numbers over any text scrolled to the left */
+    painter.fillRect(0, 0, gutter, viewport()->height(), QColor(Qt::lightGray));
+    painter.setPen(Qt::black);
+    for(int line = first; line < last; line++) {
+        int y = (line-first)*height;
+        painter.drawText(0, y, gutter-cw/2, height, Qt::AlignRight, QString::number(line+1));
+    }
+}
+
+void FileViewer::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void FileViewer::keyPressEvent(QKeyEvent *event)
+{
+    int key = event->key();
+    bool ctrl = (event->modifiers() & Qt::ControlModifier) != 0;
+
+    if(ctrl && (key == Qt::Key_G || key == Qt::Key_L)) {
+        gotoLineDialog();
+    }
+    else if(ctrl && key == Qt::Key_F) {
+        findDialog();
+    }
+    else if(key == Qt::Key_F3) {
+        findNext();
+    }
+    else if(ctrl && key == Qt::Key_C) {
+        if(current >= 0)
+            QApplication::clipboard()->setText(lineText(current));
+    }
+    else if(ctrl && key == Qt::Key_Home) {
+        gotoLine(1);
+    }
+    else if(ctrl && key == Qt::Key_End) {
+        gotoLine(lineCount());
+    }
+    else if(key == Qt::Key_Up && current > 0) {
+        current--;
+        if(current < verticalScrollBar()->value())
+            verticalScrollBar()->setValue(current);
+        viewport()->update();
+    }
+    else if(key == Qt::Key_Down && current+1 < lineCount()) {
+        current++;
+        if(current >= verticalScrollBar()->value()+visibleLines())
+            verticalScrollBar()->setValue(current-visibleLines()+1);
+        viewport()->update();
+    }
+    else {
+        QAbstractScrollArea::keyPressEvent(event);
+    }
+}
+
+void FileViewer::mousePressEvent(QMouseEvent *event)
+{
+    int line = verticalScrollBar()->value() + event->pos().y()/fontMetrics().height();
+    if(line < lineCount()) {
+        current = line;
+        viewport()->update();
+    }
+    QAbstractScrollArea::mousePressEvent(event);
+}
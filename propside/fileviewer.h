@@ -0,0 +1,94 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FILEVIEWER_H
+#define FILEVIEWER_H
+
+#include "qtversion.h"
+
+class FileLineIndex;
+
+/*
+ * Read-only view of a file too large for an editor.
+ * The start of each line is found on a thread, so lines can be shown
+ * while the rest is still being indexed. Only the visible lines are
+ * read, decoded and drawn. The file is read rather than mapped because
+ * the build rewrites map files and listings in place; the view reloads
+ * when that happens.
+ * Ctrl+G goes to a line, Ctrl+F finds text and F3 finds the next match.
+ */
+class FileViewer : public QAbstractScrollArea
+{
+    Q_OBJECT
+public:
+    explicit FileViewer(QWidget *parent = 0);
+    ~FileViewer();
+
+    bool openFile(const QString &fileName);
+    void closeFile();
+    QString path();
+    int  lineCount();
+    bool isIndexing();
+    void gotoLine(int line);
+    bool find(const QString &text);
+
+public slots:
+    void gotoLineDialog();
+    void findDialog();
+    void findNext();
+
+private slots:
+    void indexProgress();
+    void fileChanged();
+    void reloadFile();
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    void resizeEvent(QResizeEvent *event);
+    void keyPressEvent(QKeyEvent *event);
+    void mousePressEvent(QMouseEvent *event);
+
+private:
+    friend class FileLineIndex;
+
+    QString lineText(int line);
+    qint64  findBytes(const QByteArray &key, qint64 from);
+    int     lineAt(qint64 offset);
+    int     visibleLines();
+    void    updateScrollBars();
+    void    updateTitle();
+
+    QFile           file;
+    QString         fileName;
+    qint64          size;
+    FileLineIndex   *indexer;
+    QFileSystemWatcher watcher;
+    QTimer          reloadTimer;    // waits for a rewrite to finish
+
+    QMutex          mutex;          // guards offsets and longest
+    QVector<qint64> offsets;        // start of each line
+    int             longest;        // longest line in bytes
+    bool            indexed;
+
+    int             current;        // selected line or -1
+    int             reloadTop;      // scroll back here after a reload or -1
+    QString         findText;
+};
+
+#endif // FILEVIEWER_H
@@ -0,0 +1,265 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "framedecoder.h"
+#include <QtEndian>
+#include <string.h>
+
+FrameDecoder::FrameDecoder()
+{
+    size = 0;
+    bigEndian = false;
+    frames = 0;
+    errors = 0;
+}
+
+/*
+ * Set the frame layout.
+ * @param sync is the sync bytes in hex, such as "A5 5A". It may be empty.
+ * @param fields lists the field types in order, u8 i8 u16 i16 u32 i32 f32
+ *        or f64, each optionally named as in "x:i16 y:i16".
+ * @param bigEndian selects the byte order of multi-byte fields.
+ * @param error is set to a message if the layout is rejected.
+ * @returns true if the layout was accepted.
+ */
+bool FrameDecoder::setLayout(const QString &sync, const QString &fields, bool bigEndian, QString *error)
+{
+    QByteArray newSync;
+    foreach(QString tok, sync.split(QRegExp("[\\s,]+"), QString::SkipEmptyParts)) {
+        bool ok;
+        uint b = tok.toUInt(&ok, 16);
+        if(!ok || b > 0xff) {
+            if(error) *error = QString("Bad sync byte \"%1\".").arg(tok);
+            return false;
+        }
+        newSync.append((char) b);
+    }
+
+    static const char *typeNames[] = { "u8", "i8", "u16", "i16", "u32", "i32", "f32", "f64" };
+    static const int typeSizes[] = { 1, 1, 2, 2, 4, 4, 4, 8 };
+
+    QList<FieldType> newTypes;
+    QStringList newNames;
+    QList<int> newOffsets;
+    int offset = newSync.length();
+    foreach(QString tok, fields.split(QRegExp("[\\s,]+"), QString::SkipEmptyParts)) {
+        QString name = QString("field%1").arg(newTypes.count()+1);
+        QString type = tok;
+        if(tok.contains(':')) {
+            name = tok.section(':', 0, 0);
+            type = tok.section(':', 1);
+        }
+        int t;
+        for(t = 0; t <= F64; t++) {
+            if(type.compare(typeNames[t], Qt::CaseInsensitive) == 0)
+                break;
+        }
+        if(t > F64) {
+            if(error) *error = QString("Unknown field type \"%1\".").arg(type);
+            return false;
+        }
+        newTypes.append((FieldType) t);
+        newNames.append(name);
+        newOffsets.append(offset);
+        offset += typeSizes[t];
+    }
+    if(newTypes.isEmpty()) {
+        if(error) *error = QString("A frame needs at least one field.");
+        return false;
+    }
+
+    QMutexLocker locker(&lock);
+    this->sync = newSync;
+    this->types = newTypes;
+    this->names = newNames;
+    this->offsets = newOffsets;
+    this->size = offset;
+    this->bigEndian = bigEndian;
+    rings.clear();
+    rings.resize(types.count());
+    for(int n = 0; n < rings.count(); n++)
+        rings[n].resize(RING_SIZE);
+    partial.clear();
+    frames = 0;
+    errors = 0;
+    return true;
+}
+
+int FrameDecoder::frameSize()
+{
+    return size;
+}
+
+int FrameDecoder::channelCount()
+{
+    return types.count();
+}
+
+QString FrameDecoder::channelName(int channel)
+{
+    return names.value(channel);
+}
+
+void FrameDecoder::clear()
+{
+    QMutexLocker locker(&lock);
+    partial.clear();
+    frames = 0;
+    errors = 0;
+}
+
+/*
+ * Add received bytes. Bytes that don't fit the sync pattern are
+ * skipped and counted as one sync error per lost frame.
+ */
+void FrameDecoder::feed(const char *data, int length)
+{
+    QMutexLocker locker(&lock);
+    if(size < 1)
+        return;
+
+    int slen = sync.length();
+    int n = 0;
+    while(n < length) {
+        int have = partial.length();
+        if(have < slen) {
+            char c = data[n++];
+            if(c == sync.at(have)) {
+                partial.append(c);
+            }
+            else {
+                if(have > 0)
+                    errors++;
+                partial.clear();
+                if(c == sync.at(0))
+                    partial.append(c);
+            }
+            continue;
+        }
+        /* copy as much of the frame body as we have */
+        int take = qMin(size - have, length - n);
+        partial.append(data+n, take);
+        n += take;
+        if(partial.length() == size) {
+            decode((const uchar *) partial.constData());
+            partial.clear();
+        }
+    }
+}
+
+void FrameDecoder::decode(const uchar *frame)
+{
+    int slot = int(frames % RING_SIZE);
+    for(int c = 0; c < types.count(); c++) {
+        const uchar *p = frame + offsets[c];
+        double v = 0;
+        switch(types[c]) {
+        case U8:  v = *p; break;
+        case I8:  v = (qint8) *p; break;
+        case U16: v = bigEndian ? qFromBigEndian<quint16>(p) : qFromLittleEndian<quint16>(p); break;
+        case I16: v = bigEndian ? qFromBigEndian<qint16>(p) : qFromLittleEndian<qint16>(p); break;
+        case U32: v = bigEndian ? qFromBigEndian<quint32>(p) : qFromLittleEndian<quint32>(p); break;
+        case I32: v = bigEndian ? qFromBigEndian<qint32>(p) : qFromLittleEndian<qint32>(p); break;
+        case F32: {
+            quint32 bits = bigEndian ? qFromBigEndian<quint32>(p) : qFromLittleEndian<quint32>(p);
+            float f;
+            memcpy(&f, &bits, sizeof(f));
+            v = f;
+            break;
+        }
+        case F64: {
+            quint64 bits = bigEndian ? qFromBigEndian<quint64>(p) : qFromLittleEndian<quint64>(p);
+            double d;
+            memcpy(&d, &bits, sizeof(d));
+            v = d;
+            break;
+        }
+        }
+        rings[c][slot] = v;
+    }
+    frames++;
+}
+
+qint64 FrameDecoder::frameCount()
+{
+    QMutexLocker locker(&lock);
+    return frames;
+}
+
+qint64 FrameDecoder::syncErrors()
+{
+    QMutexLocker locker(&lock);
+    return errors;
+}
+
+/*
+ * Smallest and largest value of any field over the last window frames.
+ */
+bool FrameDecoder::range(int window, double *lo, double *hi)
+{
+    QMutexLocker locker(&lock);
+    qint64 count = qMin(qMin((qint64) window, frames), (qint64) RING_SIZE);
+    if(count < 1)
+        return false;
+    *lo = *hi = rings[0][int((frames-1) % RING_SIZE)];
+    for(int c = 0; c < rings.count(); c++) {
+        const double *ring = rings[c].constData();
+        for(qint64 i = frames - count; i < frames; i++) {
+            double v = ring[i % RING_SIZE];
+            if(v < *lo) *lo = v;
+            if(v > *hi) *hi = v;
+        }
+    }
+    return true;
+}
+
+/*
+ * Reduce the last window frames of a field to at most columns min/max
+ * pairs, newest on the right.
+ * @returns the number of columns filled.
+ */
+int FrameDecoder::decimate(int channel, int window, int columns, QVector<double> &mins, QVector<double> &maxs)
+{
+    QMutexLocker locker(&lock);
+    if(channel < 0 || channel >= rings.count() || columns < 1)
+        return 0;
+    qint64 count = qMin(qMin((qint64) window, frames), (qint64) RING_SIZE);
+    if(count < 1)
+        return 0;
+    int cols = (int) qMin((qint64) columns, count);
+    mins.resize(cols);
+    maxs.resize(cols);
+
+    const double *ring = rings[channel].constData();
+    qint64 first = frames - count;
+    for(int col = 0; col < cols; col++) {
+        qint64 a = first + count * col / cols;
+        qint64 b = first + count * (col+1) / cols;
+        double lo = ring[a % RING_SIZE];
+        double hi = lo;
+        for(qint64 i = a+1; i < b; i++) {
+            double v = ring[i % RING_SIZE];
+            if(v < lo) lo = v;
+            if(v > hi) hi = v;
+        }
+        mins[col] = lo;
+        maxs[col] = hi;
+    }
+    return cols;
+}
@@ -0,0 +1,72 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAMEDECODER_H
+#define FRAMEDECODER_H
+
+#include "qtversion.h"
+
+/*
+ * Decoder for fixed-layout binary telemetry frames.
+ * A frame is the sync bytes followed by the fields in order. feed() may
+ * be called from the port's receive thread; decoded values go into a
+ * ring per field that the plot reads back already reduced to one
+ * min/max pair per pixel column, so the display cost doesn't grow with
+ * the sample rate.
+ */
+class FrameDecoder
+{
+public:
+    enum FieldType { U8 = 0, I8, U16, I16, U32, I32, F32, F64 };
+
+    FrameDecoder();
+
+    bool setLayout(const QString &sync, const QString &fields, bool bigEndian, QString *error = 0);
+    int  frameSize();
+    int  channelCount();
+    QString channelName(int channel);
+
+    void feed(const char *data, int length);
+    void clear();
+
+    qint64 frameCount();
+    qint64 syncErrors();
+    bool range(int window, double *lo, double *hi);
+    int  decimate(int channel, int window, int columns, QVector<double> &mins, QVector<double> &maxs);
+
+private:
+    enum { RING_SIZE = 1 << 18 };   // samples kept per field
+
+    void decode(const uchar *frame);
+
+    QByteArray       sync;
+    QList<FieldType> types;
+    QStringList      names;
+    QList<int>       offsets;
+    int     size;
+    bool    bigEndian;
+
+    QByteArray  partial;        // frame being assembled
+    QMutex      lock;           // guards everything below
+    QVector< QVector<double> > rings;
+    qint64  frames;
+    qint64  errors;
+};
+
+#endif // FRAMEDECODER_H
@@ -0,0 +1,275 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gangloaddialog.h"
+#include "PropellerLoader.h"
+
+GangLoadDialog::GangLoadDialog(QWidget *parent) :
+    QDialog(parent)
+{
+    setWindowTitle(tr("Load to Selected Ports"));
+    resetType = PropellerID::RESET_BY_DTR;
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    table = new QTableWidget(0, COL_LAST, this);
+    table->setHorizontalHeaderLabels(QStringList() << tr("Port") << tr("Status") << tr("Time"));
+    table->setSelectionMode(QAbstractItemView::NoSelection);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->verticalHeader()->hide();
+    table->horizontalHeader()->setStretchLastSection(false);
+    table->setColumnWidth(COL_PORT, 160);
+    table->setColumnWidth(COL_STATUS, 300);
+    table->setColumnWidth(COL_TIME, 70);
+    layout->addWidget(table);
+
+    eepromBox = new QCheckBox(tr("Program EEPROM"), this);
+    layout->addWidget(eepromBox);
+
+    summary = new QLabel(this);
+    layout->addWidget(summary);
+
+    QHBoxLayout *buttons = new QHBoxLayout();
+    loadBtn = new QPushButton(tr("Load"), this);
+    retryBtn = new QPushButton(tr("Retry Failed"), this);
+    closeBtn = new QPushButton(tr("Close"), this);
+    connect(loadBtn, SIGNAL(clicked()), this, SLOT(loadSelected()));
+    connect(retryBtn, SIGNAL(clicked()), this, SLOT(retryFailed()));
+    connect(closeBtn, SIGNAL(clicked()), this, SLOT(reject()));
+    buttons->addWidget(loadBtn);
+    buttons->addWidget(retryBtn);
+    buttons->addStretch(100);
+    buttons->addWidget(closeBtn);
+    layout->addLayout(buttons);
+
+    setLayout(layout);
+    resize(580,400);
+    updateSummary();
+}
+
+void GangLoadDialog::clearPorts()
+{
+    if(isLoading())
+        return;
+    jobs.clear();
+    table->setRowCount(0);
+    updateSummary();
+}
+
+void GangLoadDialog::addPort(QString port, QStringList ramArgs, QStringList eepromArgs, QString image)
+{
+    GangJob job;
+    job.port = port;
+    job.ramArgs = ramArgs;
+    job.eepromArgs = eepromArgs;
+    job.image = image;
+    job.worker = NULL;
+    job.state = JOB_IDLE;
+    jobs.append(job);
+
+    int row = table->rowCount();
+    table->insertRow(row);
+    QTableWidgetItem *item = new QTableWidgetItem(port);
+    item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsUserCheckable);
+    item->setCheckState(Qt::Checked);
+    table->setItem(row, COL_PORT, item);
+    table->setItem(row, COL_STATUS, new QTableWidgetItem(""));
+    table->setItem(row, COL_TIME, new QTableWidgetItem(""));
+    updateSummary();
+}
+
+void GangLoadDialog::setLoader(QString program, QString workPath, int resetType)
+{
+    this->program = program;
+    this->workPath = workPath;
+    this->resetType = resetType;
+}
+
+bool GangLoadDialog::isLoading()
+{
+    foreach(GangJob job, jobs) {
+        if(job.state == JOB_LOADING)
+            return true;
+    }
+    return false;
+}
+
+void GangLoadDialog::reject()
+{
+    /* workers report back to this dialog; keep it until they finish */
+    if(isLoading())
+        return;
+    QDialog::reject();
+}
+
+void GangLoadDialog::loadSelected()
+{
+    for(int row = 0; row < jobs.count(); row++) {
+        if(table->item(row, COL_PORT)->checkState() == Qt::Checked)
+            startJob(row);
+    }
+    updateSummary();
+}
+
+void GangLoadDialog::retryFailed()
+{
+    for(int row = 0; row < jobs.count(); row++) {
+        if(jobs[row].state == JOB_FAILED)
+            startJob(row);
+    }
+    updateSummary();
+}
+
+void GangLoadDialog::startJob(int row)
+{
+    GangJob &job = jobs[row];
+    if(job.state == JOB_LOADING)
+        return;
+
+    bool eeprom = eepromBox->isChecked();
+    job.state = JOB_LOADING;
+    job.lastMessage.clear();
+    job.timer.start();
+    table->item(row, COL_TIME)->setText("");
+    setStatus(row, tr("Loading"));
+    emit portBusy(job.port);
+
+    if(job.image.length() > 0) {
+        PropellerLoader *loader = new PropellerLoader(this);
+        if(resetType == PropellerID::RESET_BY_RTS)
+            loader->setRtsReset();
+        else
+            loader->setDtrReset();
+        connect(loader, SIGNAL(progress(int)), this, SLOT(nativeProgress(int)));
+        connect(loader, SIGNAL(message(QString)), this, SLOT(nativeMessage(QString)));
+        connect(loader, SIGNAL(loadFinished(int)), this, SLOT(nativeFinished(int)));
+        job.worker = loader;
+        loader->load(job.port, job.image, eeprom ? PropellerLoader::LOAD_RUN_EEPROM : PropellerLoader::LOAD_RUN_RAM);
+    }
+    else {
+        QProcess *proc = new QProcess(this);
+        proc->setProcessChannelMode(QProcess::MergedChannels);
+        proc->setWorkingDirectory(workPath);
+        connect(proc, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(procFinished(int,QProcess::ExitStatus)));
+        connect(proc, SIGNAL(error(QProcess::ProcessError)), this, SLOT(procError(QProcess::ProcessError)));
+        job.worker = proc;
+        proc->start(program, eeprom ? job.eepromArgs : job.ramArgs);
+    }
+}
+
+void GangLoadDialog::finishJob(int row, bool ok, QString detail)
+{
+    GangJob &job = jobs[row];
+    job.state = ok ? JOB_DONE : JOB_FAILED;
+    job.worker->deleteLater();
+    job.worker = NULL;
+
+    double secs = job.timer.elapsed() / 1000.0;
+    table->item(row, COL_TIME)->setText(QString::number(secs, 'f', 1)+" s");
+
+    if(ok)
+        setStatus(row, tr("Done"));
+    else if(detail.length() > 0)
+        setStatus(row, tr("Failed: ")+detail);
+    else
+        setStatus(row, tr("Failed"));
+    table->item(row, COL_STATUS)->setForeground(ok ? QBrush(Qt::darkGreen) : QBrush(Qt::red));
+    updateSummary();
+    emit portFree(job.port);
+}
+
+void GangLoadDialog::setStatus(int row, QString text)
+{
+    table->item(row, COL_STATUS)->setText(text);
+    table->item(row, COL_STATUS)->setForeground(palette().text());
+}
+
+int GangLoadDialog::rowOf(QObject *worker)
+{
+    for(int row = 0; row < jobs.count(); row++) {
+        if(jobs[row].worker == worker)
+            return row;
+    }
+    return -1;
+}
+
+void GangLoadDialog::updateSummary()
+{
+    int loading = 0, done = 0, failed = 0;
+    foreach(GangJob job, jobs) {
+        if(job.state == JOB_LOADING) loading++;
+        if(job.state == JOB_DONE) done++;
+        if(job.state == JOB_FAILED) failed++;
+    }
+    summary->setText(tr("%1 loading, %2 done, %3 failed").arg(loading).arg(done).arg(failed));
+    loadBtn->setEnabled(loading == 0 && jobs.count() > 0);
+    retryBtn->setEnabled(loading == 0 && failed > 0);
+    closeBtn->setEnabled(loading == 0);
+    eepromBox->setEnabled(loading == 0);
+}
+
+void GangLoadDialog::procFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    QProcess *proc = static_cast<QProcess*>(sender());
+    int row = rowOf(proc);
+    if(row < 0)
+        return;
+
+    /* the loader's last line says why it failed */
+    QString detail;
+    QStringList lines = QString(proc->readAll()).split(QRegExp("[\r\n]"), QString::SkipEmptyParts);
+    if(lines.count() > 0)
+        detail = lines.last().trimmed();
+    finishJob(row, exitStatus == QProcess::NormalExit && exitCode == 0, detail);
+}
+
+void GangLoadDialog::procError(QProcess::ProcessError error)
+{
+    /* finished() never comes for a loader that didn't start */
+    if(error != QProcess::FailedToStart)
+        return;
+    int row = rowOf(sender());
+    if(row < 0)
+        return;
+    finishJob(row, false, tr("Can't start %1").arg(program));
+}
+
+void GangLoadDialog::nativeProgress(int percent)
+{
+    int row = rowOf(sender());
+    if(row < 0)
+        return;
+    setStatus(row, tr("Loading %1%").arg(percent));
+}
+
+void GangLoadDialog::nativeMessage(QString text)
+{
+    int row = rowOf(sender());
+    if(row < 0)
+        return;
+    jobs[row].lastMessage = text;
+}
+
+void GangLoadDialog::nativeFinished(int result)
+{
+    int row = rowOf(sender());
+    if(row < 0)
+        return;
+    finishJob(row, result == 0, jobs[row].lastMessage);
+}
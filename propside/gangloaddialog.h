@@ -0,0 +1,92 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GANGLOADDIALOG_H
+#define GANGLOADDIALOG_H
+
+#include "qtversion.h"
+
+/*
+ * Loads one built image onto many boards at once.
+ * Every selected port gets its own worker: a PropellerLoader when the
+ * board uses the native loader, otherwise a loader process. Results are
+ * shown per port, and failed ports can be retried on their own.
+ */
+class GangLoadDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit GangLoadDialog(QWidget *parent = 0);
+
+    void clearPorts();
+    void addPort(QString port, QStringList ramArgs, QStringList eepromArgs, QString image = QString());
+    void setLoader(QString program, QString workPath, int resetType);
+    bool isLoading();
+
+signals:
+    void portBusy(QString port);
+    void portFree(QString port);
+
+public slots:
+    void loadSelected();
+    void retryFailed();
+    void reject();
+
+private slots:
+    void procFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void procError(QProcess::ProcessError error);
+    void nativeProgress(int percent);
+    void nativeMessage(QString text);
+    void nativeFinished(int result);
+
+private:
+    enum { COL_PORT = 0, COL_STATUS, COL_TIME, COL_LAST };
+    enum { JOB_IDLE = 0, JOB_LOADING, JOB_DONE, JOB_FAILED };
+
+    typedef struct {
+        QString     port;
+        QStringList ramArgs;
+        QStringList eepromArgs;
+        QString     image;
+        QString     lastMessage;
+        QElapsedTimer timer;
+        QObject     *worker;
+        int         state;
+    } GangJob;
+
+    void startJob(int row);
+    void finishJob(int row, bool ok, QString detail);
+    void setStatus(int row, QString text);
+    int  rowOf(QObject *worker);
+    void updateSummary();
+
+    QList<GangJob> jobs;
+    QString     program;
+    QString     workPath;
+    int         resetType;
+
+    QTableWidget *table;
+    QCheckBox   *eepromBox;
+    QPushButton *loadBtn;
+    QPushButton *retryBtn;
+    QPushButton *closeBtn;
+    QLabel      *summary;
+};
+
+#endif // GANGLOADDIALOG_H
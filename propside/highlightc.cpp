@@ -19,10 +19,24 @@
 
 #include "highlightc.h"
 
+/* lexer layers in the order the rules above are applied */
+enum {
+    LayerNone = 0,
+    LayerNumber,
+    LayerFunction,
+    LayerKeyword,
+    LayerPreProc,
+    LayerQuote,
+    LayerLineComment,
+    LayerBlockComment,
+    LayerCount
+};
+
 HighlightC::HighlightC(QTextDocument *parent, Properties *prop)
     : Highlighter(parent, prop)
 {
     highlight();
+    startFill();
 }
 
 void HighlightC::highlight()
@@ -53,40 +67,45 @@ void HighlightC::highlight()
     keywordFormat.setForeground(hlKeyWordColor);
     keywordFormat.setFontWeight(hlKeyWordWeight);
     keywordFormat.setFontItalic(hlKeyWordStyle);
+    QStringList keywords;
+    keywords
+            << "auto"
+            << "break"
+            << "case"
+            << "char"
+            << "const"
+            << "continue"
+            << "default"
+            << "do"
+            << "double"
+            << "else"
+            << "enum"
+            << "extern"
+            << "float"
+            << "for"
+            << "goto"
+            << "if"
+            << "int"
+            << "long"
+            << "struct"
+            << "switch"
+            << "register"
+            << "return"
+            << "short"
+            << "signed"
+            << "sizeof"
+            << "static"
+            << "typedef"
+            << "union"
+            << "unsigned"
+            << "void"
+            << "volatile"
+            << "while"
+            ;
     QStringList keywordPatterns;
+    foreach (const QString &keyword, keywords)
+        keywordPatterns << "\\b"+keyword+"\\b";
     keywordPatterns
-            << "\\bauto\\b"
-            << "\\bbreak\\b"
-            << "\\bcase\\b"
-            << "\\bchar\\b"
-            << "\\bconst\\b"
-            << "\\bcontinue\\b"
-            << "\\bdefault\\b"
-            << "\\bdo\\b"
-            << "\\bdouble\\b"
-            << "\\belse\\b"
-            << "\\benum\\b"
-            << "\\bextern\\b"
-            << "\\bfloat\\b"
-            << "\\bfor\\b"
-            << "\\bgoto\\b"
-            << "\\bif\\b"
-            << "\\bint\\b"
-            << "\\blong\\b"
-            << "\\bstruct\\b"
-            << "\\bswitch\\b"
-            << "\\bregister\\b"
-            << "\\breturn\\b"
-            << "\\bshort\\b"
-            << "\\bsigned\\b"
-            << "\\bsizeof\\b"
-            << "\\bstatic\\b"
-            << "\\btypedef\\b"
-            << "\\bunion\\b"
-            << "\\bunsigned\\b"
-            << "\\bvoid\\b"
-            << "\\bvolatile\\b"
-            << "\\bwhile\\b"
             << "={2,}" << "+{2,}" << "-{2,}" << "_{2,}" << "\\{2,}"
             ;
     foreach (const QString &pattern, keywordPatterns) {
@@ -98,30 +117,35 @@ void HighlightC::highlight()
     preprocessorFormat.setFontItalic(hlPreProcStyle);
     preprocessorFormat.setForeground(hlPreProcColor);
     preprocessorFormat.setFontWeight(hlPreProcWeight);
+    QStringList preprocessor;
+    preprocessor
+            << "assert"
+            << "class"
+            << "define"
+            << "defined"
+            << "error"
+            << "ident"
+            << "import"
+            << "include"
+            << "include_next"
+            << "line"
+            << "pragma"
+            << "public"
+            << "private"
+            << "unassert"
+            << "undef"
+            << "warning"
+            << "elif"
+            << "ifdef"
+            << "ifndef"
+            << "endif"
+            ;
     QStringList preprocessorPatterns;
+    foreach (const QString &word, preprocessor)
+        preprocessorPatterns << "\\b"+word+"\\b";
     preprocessorPatterns
-            << "\\bassert\\b"
-            << "\\bclass\\b"
-            << "\\bdefine\\b"
-            << "\\bdefined\\b"
-            << "\\berror\\b"
-            << "\\bident\\b"
-            << "\\bimport\\b"
-            << "\\binclude\\b"
-            << "\\binclude_next\\b"
-            << "\\bline\\b"
-            << "\\bpragma\\b"
-            << "\\bpublic\\b"
-            << "\\bprivate\\b"
-            << "\\bunassert\\b"
-            << "\\bundef\\b"
-            << "\\bwarning\\b"
             << "\\bint\\d+_t"
             << "\\buint\\d+_t"
-            << "\\belif\\b"
-            << "\\bifdef\\b"
-            << "\\bifndef\\b"
-            << "\\bendif\\b"
             ;
     foreach (const QString &pattern, preprocessorPatterns) {
         rule.pattern = QRegExp(pattern);
@@ -154,4 +178,192 @@ void HighlightC::highlight()
     multiLineCommentFormat.setFontWeight(hlBlockComWeight);
     commentStartExpression = QRegExp("/\\*");
     commentEndExpression = QRegExp("\\*/");
+
+    // compile the same rules for lexBlock
+    layerFormats.fill(QTextCharFormat(), LayerCount);
+    layerFormats[LayerNumber] = numberFormat;
+    layerFormats[LayerFunction] = functionFormat;
+    layerFormats[LayerKeyword] = keywordFormat;
+    layerFormats[LayerPreProc] = preprocessorFormat;
+    layerFormats[LayerQuote] = quotationFormat;
+    layerFormats[LayerLineComment] = singleLineCommentFormat;
+    layerFormats[LayerBlockComment] = multiLineCommentFormat;
+    words.clear();
+    addWords(keywords, LayerKeyword, false);
+    addWords(preprocessor, LayerPreProc, false);
+}
+
+static inline bool isCallChar(ushort c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static inline bool isHexChar(ushort c)
+{
+    return (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F') || (c >= '0' && c <= '9') || c == ',';
+}
+
+/**
+ * Single pass equivalent of the rules built in highlight().
+ * Note "+{2,}" is not a valid QRegExp so it never matched; it is not lexed.
+ */
+bool HighlightC::lexBlock(const QString &text)
+{
+    const QChar *s = text.constData();
+    int len = text.length();
+    clearLayers(len);
+
+    int wordStart = -1;
+    int callStart = -1;
+    int firstQuote = -1;
+    int lastQuote = -1;
+    int angleOpen = -1;
+    int angleClose = -1;
+    int lineComment = -1;
+
+    for(int n = 0; n <= len; n++) {
+        ushort c = n < len ? s[n].unicode() : 0;
+        bool w = n < len && isWord(s[n]);
+
+        if(w && wordStart < 0) {
+            wordStart = n;
+        }
+        else if(!w && wordStart >= 0) {
+            int length = n - wordStart;
+            const QChar *ws = s + wordStart;
+            if(ws[0].isDigit()) {
+                int end = 1;
+                while(end < length && ws[end].isDigit())
+                    end++;
+                mark(wordStart, end, LayerNumber);
+                if(ws[0] == QLatin1Char('0') && length > 1 && ws[1] == QLatin1Char('x')) {
+                    end = wordStart+2;
+                    while(end < len && isHexChar(s[end].unicode()))
+                        end++;
+                    mark(wordStart, end-wordStart, LayerNumber);
+                }
+            }
+            else {
+                int value = wordValue(ws, length, false);
+                if(value) {
+                    mark(wordStart, length, value);
+                }
+                else if(ws[0] == QLatin1Char('i') || ws[0] == QLatin1Char('u')) {
+                    // int\d+_t and uint\d+_t
+                    int end = ws[0] == QLatin1Char('u') ? 1 : 0;
+                    if(end + 3 < length && ws[end] == QLatin1Char('i') &&
+                            ws[end+1] == QLatin1Char('n') && ws[end+2] == QLatin1Char('t') &&
+                            ws[end+3].isDigit()) {
+                        end += 4;
+                        while(end < length && ws[end].isDigit())
+                            end++;
+                        if(end + 1 < length && ws[end] == QLatin1Char('_') && ws[end+1] == QLatin1Char('t'))
+                            mark(wordStart, end+2, LayerPreProc);
+                    }
+                }
+            }
+            wordStart = -1;
+        }
+
+        if(isCallChar(c)) {
+            if(callStart < 0)
+                callStart = n;
+            if(c != '_')
+                continue;
+        }
+        else {
+            if(c == '(' && callStart >= 0)
+                markCall(s, callStart, n, LayerFunction);
+            callStart = -1;
+        }
+
+        switch(c) {
+        case '"':
+            if(firstQuote < 0)
+                firstQuote = n;
+            lastQuote = n;
+            break;
+        case '<':
+            if(angleOpen < 0 && n+1 < len) {
+                ushort next = s[n+1].unicode();
+                if((next >= 'a' && next <= 'z') || (next >= 'A' && next <= 'Z') || next == ',')
+                    angleOpen = n;
+            }
+            break;
+        case '>':
+            if(n > 0 && s[n-1] != QLatin1Char('-'))
+                angleClose = n;
+            break;
+        case '/':
+            if(lineComment < 0 && n+1 < len && s[n+1] == QLatin1Char('/'))
+                lineComment = n;
+            break;
+        case '{':
+            if(n+3 < len && s[n+1] == QLatin1Char('2') && s[n+2] == QLatin1Char(',') && s[n+3] == QLatin1Char('}'))
+                mark(n, 4, LayerKeyword);
+            break;
+        case '=':
+        case '-':
+        case '_':
+            if(n == 0 || s[n-1].unicode() != c) {
+                int end = n+1;
+                while(end < len && s[end].unicode() == c)
+                    end++;
+                if(end - n > 1)
+                    mark(n, end-n, LayerKeyword);
+            }
+            break;
+        }
+    }
+
+    if(lastQuote > firstQuote)
+        mark(firstQuote, lastQuote-firstQuote+1, LayerQuote);
+    if(angleOpen >= 0 && angleOpen+3 <= angleClose)
+        mark(angleOpen, angleClose-angleOpen+1, LayerQuote);
+    if(lineComment >= 0)
+        mark(lineComment, len-lineComment, LayerLineComment);
+
+    lexComments(text, true);
+    paintLayers();
+    return true;
+}
+
+bool HighlightC::lexState(const QString &text)
+{
+    lexComments(text, false);
+    return true;
+}
+
+/**
+ * Find block comments and set the block state and brace counts.
+ * @param paint marks the comments when true.
+ */
+void HighlightC::lexComments(const QString &text, bool paint)
+{
+    int len = text.length();
+    int open = 0;
+    int close = 0;
+    int from = 0;
+    setCurrentBlockState(0);
+    int start = 0;
+    if(previousBlockState() != 1)
+        start = text.indexOf(QLatin1String("/*"));
+    while(start >= 0) {
+        countBraces(text, from, start, &open, &close);
+        int end = text.indexOf(QLatin1String("*/"), start);
+        int length;
+        if(end == -1) {
+            setCurrentBlockState(1);
+            length = len - start;
+        }
+        else {
+            length = end - start + 2;
+        }
+        if(paint)
+            mark(start, length, LayerBlockComment);
+        from = start + length;
+        start = text.indexOf(QLatin1String("/*"), start + length);
+    }
+    countBraces(text, from, len, &open, &close);
+    setBraces(open, close);
 }
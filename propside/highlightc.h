@@ -28,6 +28,13 @@ class HighlightC : public Highlighter
 public:
     HighlightC(QTextDocument *parent, Properties *prop);
     void highlight();
+
+protected:
+    bool lexBlock(const QString &text);
+    bool lexState(const QString &text);
+
+private:
+    void lexComments(const QString &text, bool paint);
 };
 
 #endif // HIGHLIGHTC_H
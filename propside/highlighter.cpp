@@ -49,11 +49,37 @@
 
 #include "highlighter.h"
 
+#include <QTextBlock>
+#include <QTextLayout>
+
+BlockData::BlockData(QSharedPointer<BraceCount> count, int opens, int closes)
+    : total(count), open(opens), close(closes)
+{
+    total->open += open;
+    total->close += close;
+}
+
+/* blocks removed from the document take their counts with them */
+BlockData::~BlockData()
+{
+    total->open -= open;
+    total->close -= close;
+}
+
 //! [0]
 Highlighter::Highlighter(QTextDocument *parent, Properties *prop)
     : QSyntaxHighlighter(parent)
 {
     properties = prop;
+    wordMax = 0;
+    useRules = false;
+    filling = false;
+    fillLine = 0;
+    viewFirst = 0;
+    viewLast = 0;
+    viewPainted = true;
+    braces = QSharedPointer<BraceCount>(new BraceCount());
+    connect(&fillTimer, SIGNAL(timeout()), this, SLOT(fillSlice()));
     highlight();
 }
 
@@ -158,9 +184,284 @@ void Highlighter::highlight()
 
 }
 
+/**
+ * Highlight the whole document with the regex rules and then with the
+ * lexer, and compare the formats each produced block by block.
+ * @returns a one line summary of lines/second for both passes.
+ */
+QString Highlighter::benchmark()
+{
+    QTextDocument *doc = document();
+    if(doc == NULL)
+        return QString();
+
+    int lines = doc->blockCount();
+    QElapsedTimer timer;
+
+    filling = false;
+    fillTimer.stop();
+
+    useRules = true;
+    timer.start();
+    rehighlight();
+    qint64 rulesNs = timer.nsecsElapsed();
+
+    QList<QList<QTextLayout::FormatRange> > ruled;
+    for(QTextBlock block = doc->begin(); block.isValid(); block = block.next())
+        ruled.append(block.layout()->additionalFormats());
+
+    useRules = false;
+    timer.restart();
+    rehighlight();
+    qint64 lexNs = timer.nsecsElapsed();
+
+    int diffs = 0;
+    int n = 0;
+    for(QTextBlock block = doc->begin(); block.isValid(); block = block.next(), n++) {
+        QList<QTextLayout::FormatRange> lexed = block.layout()->additionalFormats();
+        const QList<QTextLayout::FormatRange> &rule = ruled.at(n);
+        bool same = lexed.count() == rule.count();
+        for(int r = 0; same && r < rule.count(); r++) {
+            same = lexed[r].start == rule[r].start &&
+                   lexed[r].length == rule[r].length &&
+                   lexed[r].format == rule[r].format;
+        }
+        if(!same)
+            diffs++;
+    }
+
+    QString s = QString("Highlight %1 lines: rules %2 lines/s, lexer %3 lines/s, %4 blocks differ")
+            .arg(lines)
+            .arg(rulesNs > 0 ? lines*1000000000.0/rulesNs : 0, 0, 'f', 0)
+            .arg(lexNs > 0 ? lines*1000000000.0/lexNs : 0, 0, 'f', 0)
+            .arg(diffs);
+    return s;
+}
+
+bool Highlighter::lexBlock(const QString &text)
+{
+    Q_UNUSED(text);
+    return false;
+}
+
+bool Highlighter::lexState(const QString &text)
+{
+    Q_UNUSED(text);
+    return false;
+}
+
+/*
+ * How long a background fill slice may run and how many
+ * blocks are assumed visible until the editor tells us.
+ */
+#define FILL_SLICE_MS   15
+#define FILL_VIEW_LINES 100
+
+/**
+ * Start highlighting the document in the background.
+ * Blocks from the top of the document are highlighted first.
+ */
+void Highlighter::startFill()
+{
+    if(document() == NULL)
+        return;
+    filling = true;
+    fillLine = 0;
+    viewFirst = 0;
+    viewLast = FILL_VIEW_LINES;
+    viewPainted = false;
+    fillTimer.start(0);
+}
+
+bool Highlighter::isFilling()
+{
+    return filling;
+}
+
+/**
+ * The editor reports the visible blocks. While filling they are
+ * highlighted ahead of the rest of the document.
+ */
+void Highlighter::setVisibleBlocks(int first, int last)
+{
+    if(!filling)
+        return;
+    if(first == viewFirst && last == viewLast)
+        return;
+    viewFirst = first;
+    viewLast = last;
+    viewPainted = false;
+}
+
+/**
+ * @returns document open braces minus close braces outside block comments.
+ */
+int Highlighter::braceBalance()
+{
+    return braces->open - braces->close;
+}
+
+void Highlighter::countBraces(const QString &text, int from, int to, int *open, int *close)
+{
+    const QChar *s = text.constData();
+    for(int n = from; n < to; n++) {
+        if(s[n] == QLatin1Char('{'))
+            (*open)++;
+        else if(s[n] == QLatin1Char('}'))
+            (*close)++;
+    }
+}
+
+/**
+ * Store brace counts in the current block's user data.
+ * Unchanged counts keep the existing data.
+ */
+void Highlighter::setBraces(int open, int close)
+{
+    BlockData *data = static_cast<BlockData*>(currentBlockUserData());
+    if(data != NULL && data->total == braces && data->open == open && data->close == close)
+        return;
+    setCurrentBlockUserData(new BlockData(braces, open, close));
+}
+
+/**
+ * @returns true if the current block should only get its state.
+ */
+bool Highlighter::deferBlock()
+{
+    if(!filling)
+        return false;
+    int n = currentBlock().blockNumber();
+    return n >= fillLine && (n < viewFirst || n > viewLast);
+}
+
+void Highlighter::fillSlice()
+{
+    QTextDocument *doc = document();
+    if(doc == NULL) {
+        filling = false;
+        fillTimer.stop();
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if(!viewPainted) {
+        viewPainted = true;
+        QTextBlock block = doc->findBlockByNumber(qMax(viewFirst, fillLine));
+        while(block.isValid() && block.blockNumber() <= viewLast) {
+            rehighlightBlock(block);
+            block = block.next();
+        }
+    }
+
+    QTextBlock block = doc->findBlockByNumber(fillLine);
+    while(block.isValid() && timer.elapsed() < FILL_SLICE_MS) {
+        fillLine = block.blockNumber()+1;
+        rehighlightBlock(block);
+        block = block.next();
+    }
+    if(!block.isValid()) {
+        filling = false;
+        fillTimer.stop();
+    }
+}
+
+void Highlighter::clearLayers(int length)
+{
+    layers.fill(0, length);
+}
+
+/**
+ * Mark a span on a layer. Higher layers are not overwritten.
+ */
+void Highlighter::mark(int start, int length, int layer)
+{
+    int end = start + length;
+    if(end > layers.count())
+        end = layers.count();
+    uchar *p = layers.data();
+    for(int n = start; n < end; n++) {
+        if(p[n] < layer)
+            p[n] = layer;
+    }
+}
+
+/**
+ * A run of call name characters from start to end is followed by '('.
+ * Like \b[chars]+(?=\() the name starts at the first word boundary
+ * in the run.
+ */
+void Highlighter::markCall(const QChar *s, int start, int end, int layer)
+{
+    for(int n = start; n < end; n++) {
+        bool prev = n > 0 && isWord(s[n-1]);
+        if(prev != isWord(s[n])) {
+            mark(n, end-n, layer);
+            return;
+        }
+    }
+}
+
+/**
+ * Apply layer formats to the block in as few setFormat calls as possible.
+ */
+void Highlighter::paintLayers()
+{
+    const uchar *p = layers.constData();
+    int len = layers.count();
+    int n = 0;
+    while(n < len) {
+        int layer = p[n];
+        int start = n;
+        while(n < len && p[n] == layer)
+            n++;
+        if(layer > 0 && layer < layerFormats.count())
+            setFormat(start, n-start, layerFormats.at(layer));
+    }
+}
+
+/**
+ * Add lexer words. Folded words are stored lower case for
+ * case insensitive lookup.
+ */
+void Highlighter::addWords(const QStringList &list, int value, bool fold)
+{
+    foreach (const QString &s, list) {
+        QString key = fold ? s.toLower() : s;
+        words.insert(key, value);
+        if(key.length() > wordMax)
+            wordMax = key.length();
+    }
+}
+
+/**
+ * @returns the value added for the word or 0. Does not allocate.
+ */
+int Highlighter::wordValue(const QChar *s, int length, bool fold)
+{
+    if(length > wordMax)
+        return 0;
+    word.setUnicode(s, length);
+    if(fold) {
+        QChar *d = word.data();
+        for(int n = 0; n < length; n++)
+            d[n] = d[n].toLower();
+    }
+    return words.value(word, 0);
+}
+
 //! [7]
 void Highlighter::highlightBlock(const QString &text)
 {
+    if(!useRules) {
+        if(deferBlock() && lexState(text))
+            return;
+        if(lexBlock(text))
+            return;
+    }
+
     int rules = 0;
     foreach (const HighlightingRule &rule, highlightingRules) {
         rules++;
@@ -52,6 +52,9 @@
 
 #include <QHash>
 #include <QTextCharFormat>
+#include <QTextBlockUserData>
+#include <QSharedPointer>
+#include <QTimer>
 
 #include "properties.h"
 
@@ -59,6 +62,27 @@ QT_BEGIN_NAMESPACE
 class QTextDocument;
 QT_END_NAMESPACE
 
+/* Brace totals for a document, kept up to date by BlockData */
+class BraceCount
+{
+public:
+    BraceCount() : open(0), close(0) {}
+    int open;
+    int close;
+};
+
+/* Per block brace counts outside of block comments */
+class BlockData : public QTextBlockUserData
+{
+public:
+    BlockData(QSharedPointer<BraceCount> total, int open, int close);
+    ~BlockData();
+
+    QSharedPointer<BraceCount> total;
+    int open;
+    int close;
+};
+
 class Highlighter : public QSyntaxHighlighter
 {
     Q_OBJECT
@@ -74,9 +98,62 @@ public:
 
     virtual void highlight();
 
+    QString benchmark();
+
+    bool isFilling();
+    void setVisibleBlocks(int first, int last);
+
+    int  braceBalance();
+
 protected:
     void highlightBlock(const QString &text);
 
+    /* Languages with a compiled lexer override lexBlock and return true.
+     * The lexer marks spans on layers in one left to right pass; where
+     * spans overlap the highest layer wins, just as the last matching
+     * rule of highlightingRules does. The rules stay as the reference
+     * for benchmark() and for highlighters without a lexer.
+     */
+    virtual bool lexBlock(const QString &text);
+
+    /* Large documents are filled in the background after the visible
+     * blocks. Blocks not filled yet only run lexState, which must set
+     * the same block state as lexBlock without formatting anything.
+     */
+    virtual bool lexState(const QString &text);
+    void startFill();
+    bool deferBlock();
+
+    /* lexState and lexBlock set the block's brace counts */
+    static void countBraces(const QString &text, int from, int to, int *open, int *close);
+    void setBraces(int open, int close);
+    QSharedPointer<BraceCount> braces;
+
+    void clearLayers(int length);
+    void mark(int start, int length, int layer);
+    void markCall(const QChar *s, int start, int end, int layer);
+    void paintLayers();
+    void addWords(const QStringList &list, int value, bool fold);
+    int  wordValue(const QChar *s, int length, bool fold);
+
+    static bool isWord(const QChar &c) {
+        return c.isLetterOrNumber() || c.isMark() || c == QLatin1Char('_');
+    }
+
+    QVector<uchar>  layers;
+    QVector<QTextCharFormat> layerFormats;
+    QHash<QString,int> words;
+    int             wordMax;
+    QString         word;
+    bool            useRules;
+
+    QTimer          fillTimer;
+    bool            filling;
+    int             fillLine;
+    int             viewFirst;
+    int             viewLast;
+    bool            viewPainted;
+
     struct HighlightingRule
     {
         QRegExp pattern;
@@ -119,6 +196,9 @@ protected:
     bool            hlBlockComStyle;
     QFont::Weight   hlBlockComWeight;
     Qt::GlobalColor hlBlockComColor;
+
+private slots:
+    void fillSlice();
 };
 
 #endif
@@ -22,9 +22,10 @@
 #include "Sleeper.h"
 
 Loader::Loader(QLabel *mainstatus, QPlainTextEdit *compileStatus, QProgressBar *progressBar, QWidget *parent) :
-    QPlainTextEdit(parent)
+    QPlainTextEdit(parent), TermView(this)
 {
     setFont(QFont("courier"));
+    termBuffer.setPlainMode();
     status   = mainstatus;
     compiler = compileStatus;
     progress = progressBar;
@@ -64,6 +65,7 @@ int Loader::load(QString program, QString workpath, QStringList args)
     }
 #endif
     this->setPlainText("");
+    termBuffer.clear();
     setReady(false);
     setDisableIO(false);
     process->start(this->program,args);
@@ -106,6 +108,7 @@ int Loader::reload(QString port)
         args.append("-t");
     }
 
+    termBuffer.clear();
     setReady(false);
     setDisableIO(false);
     process->start(this->program,args);
@@ -261,27 +264,10 @@ void Loader::procReadyRead()
     }
 
     if(ready) {
-        /* Just doing insertPlainText(s) don't get it.
-         * Also we need to add character enable filters simiar to PST
+        /* Apply CR and backspace in the buffer, then update
+         * the document once for the whole read.
          */
-        for(int n = 0; n < s.length();n++) {
-            char ch = QChar(s.at(n)).toLatin1();
-            //this->insertPlainText(QString(" %1").arg(ch, 2, 16, QChar('0')));
-            if(ch == '\0')
-                continue; // for now ignore 0's
-            if(ch == '\r')
-                continue; // for now ignore \r
-            if(ch == '\b') {
-                QString text = this->toPlainText();
-                this->setPlainText(text.mid(0,text.length()-1));
-                n+=2;
-                continue;
-            }
-            this->insertPlainText(QString(ch));
-        }
-        cur = this->textCursor();
-        cur.movePosition(QTextCursor::End, QTextCursor::MoveAnchor);
-        this->setTextCursor(cur);
+        termBuffer.write(this, s.constData(), s.length());
     }
     else {
         /* insertPlainText OK here - it's not too critical
@@ -21,8 +21,9 @@
 #define LOADER_H
 
 #include "qtversion.h"
+#include "termview.h"
 
-class Loader : public QPlainTextEdit
+class Loader : public QPlainTextEdit, public TermView
 {
     Q_OBJECT
 public:
@@ -62,6 +63,7 @@ private:
     QProgressBar    *progress;
     QPlainTextEdit  *console;
     QProcess        *process;
+    TermBuffer      termBuffer;
     QMutex          mutex;
     bool            running;
     bool            ready;
@@ -38,6 +38,7 @@
 //#include "quazip.h"
 //#include "quazipfile.h"
 #include "PropellerID.h"
+#include "PropellerLoader.h"
 #include "directory.h"
 
 #define ENABLE_ADD_LINK
@@ -75,6 +76,15 @@
 #define SPIN_EXTENSION ".spin"
 #define AUTO_PORT "AUTO"
 
+/* how long WX module discovery results are reused */
+#define WX_DISCOVERY_TTL 10000
+
+/*
+ * Upper bound for a parallel Propeller search over all ports.
+ * A board normally answers within one handshake, about 150 ms.
+ */
+#define PROP_SEARCH_DEADLINE 1000
+
 #define CloseFile "Close"
 #define NewFile "&New"
 #define OpenFile "&Open"
@@ -208,6 +218,7 @@ MainSpinWindow::MainSpinWindow(QWidget *parent) : QMainWindow(parent),
 
     projectModel = NULL;
     referenceModel = NULL;
+    term = NULL;
 
     /* main container */
     setWindowTitle(ASideGuiKey);
@@ -240,6 +251,7 @@ MainSpinWindow::MainSpinWindow(QWidget *parent) : QMainWindow(parent),
     process = new QProcess(this);
 
 #ifdef ENABLE_WXLOADER
+    wxProcDone = true;
     wxProcess = new QProcess(this);
 
     connect(wxProcess, SIGNAL(readyReadStandardOutput()),this,SLOT(wxProcReadyRead()));
@@ -298,6 +310,22 @@ MainSpinWindow::MainSpinWindow(QWidget *parent) : QMainWindow(parent),
 
     term->setPortListener(portListener);
 
+    projectFind = NULL;
+
+    /* workspace index for Find in Project, kept current in the background */
+    codeIndex = new TrigramIndex(this);
+    QStringList indexRoots;
+    QVariant indexWrkv = settings->value(gccWorkspaceKey);
+    if(indexWrkv.canConvert(QVariant::String))
+        indexRoots.append(indexWrkv.toString());
+    indexRoots.append(propDialog->getSpinLibraryStr());
+    codeIndex->setRoots(indexRoots);
+
+    /* extra terminals give up their port whenever the main one has it */
+    termSessions = new TermSessions(this);
+    connect(portListener,SIGNAL(portOpened(QString)),termSessions,SLOT(suspend(QString)));
+    connect(portListener,SIGNAL(portClosed(QString)),termSessions,SLOT(resume(QString)));
+
     //term->setWindowTitle(QString(ASideGuiKey)+" "+tr("Simple Terminal"));
     // education request that the window title be SimpleIDE Terminal
     term->setWindowTitle(QString(ASideGuiKey)+" "+tr("Terminal"));
@@ -318,7 +346,8 @@ MainSpinWindow::MainSpinWindow(QWidget *parent) : QMainWindow(parent),
     enumeratePorts();
 
     portConnectionMonitor = new PortConnectionMonitor();
-    connect(portConnectionMonitor, SIGNAL(portChanged()), this, SLOT(enumeratePortsEvent()));
+    portConnectionMonitor->setExtraPorts(settings->value(extraPortsKey).toStringList());
+    connect(portConnectionMonitor, SIGNAL(portsChanged(QStringList,QStringList)), this, SLOT(updatePorts(QStringList,QStringList)));
 
     /* these are read once per app startup */
     QVariant lastportv  = settings->value(lastPortNameKey);
@@ -451,6 +480,9 @@ MainSpinWindow::MainSpinWindow(QWidget *parent) : QMainWindow(parent),
     }
 #endif
     rescueDialog = new RescueDialog(this);
+    gangLoadDialog = new GangLoadDialog(this);
+    connect(gangLoadDialog,SIGNAL(portBusy(QString)),termSessions,SLOT(suspend(QString)));
+    connect(gangLoadDialog,SIGNAL(portFree(QString)),termSessions,SLOT(resume(QString)));
 
 #if 0
     // remove according to issue 212
@@ -475,14 +507,8 @@ void MainSpinWindow::keyHandler(QKeyEvent* event)
 
 void MainSpinWindow::sendPortMessage(QString s)
 {
-    QByteArray barry;
-    foreach(QChar c, s.toUtf8()) {
-        Sleeper::ms(1);
-        barry.append(c);
-        portListener->send(barry);
-        barry.clear();
-        this->thread()->yieldCurrentThread();
-    }
+    QByteArray barry = s.toUtf8();
+    portListener->send(barry);
 }
 
 void MainSpinWindow::terminalEditorTextChanged()
@@ -653,6 +679,7 @@ void MainSpinWindow::quitProgram()
     /* never leave port open */
     portListener->close();
     term->accept(); // just in case serial terminal is open
+    termSessions->closeAll();
 
     portConnectionMonitor->stop();
     programStopBuild();
@@ -1325,6 +1352,9 @@ void MainSpinWindow::openFileName(QString fileName)
         }
     }
 #endif
+    else if(showLargeFile(fileName)) {
+        /* listings, map files and logs too big for an editor */
+    }
     else {
         QFile file(fileName);
         if (file.open(QFile::ReadOnly))
@@ -3861,6 +3891,8 @@ void MainSpinWindow::saveFile()
         if (file.open(QFile::WriteOnly)) {
             os << data;
             file.close();
+            codeIndex->fileChanged(fileName);
+            editorSaved(n);
         }
         if(saveas) {
             this->closeTab(n);
@@ -3890,6 +3922,8 @@ void MainSpinWindow::saveFileByTabIndex(int tab)
         if (file.open(QFile::WriteOnly)) {
             file.write(data.toUtf8());
             file.close();
+            codeIndex->fileChanged(fileName);
+            editorSaved(tab);
         }
     }
 }
@@ -4125,6 +4159,7 @@ void MainSpinWindow::downloadSdCard()
     args.append(this->shortFileName(fileName));
 
     btnConnected->setChecked(false);
+    termSessions->suspend(portName);
     portListener->close(); // disconnect uart before use
 
     builder->showBuildStart(aSideLoader,args);
@@ -4157,6 +4192,7 @@ void MainSpinWindow::downloadSdCard()
         compileStatus->appendPlainText(tr("File to SD Card killed by user."));
         status->setText(status->text() + tr(" Done."));
     }
+    termSessions->resume(portName);
 #endif
 }
 
@@ -4190,7 +4226,6 @@ void MainSpinWindow::procFinished(int exitCode, QProcess::ExitStatus exitStatus)
 void MainSpinWindow::wxProcReadyLoad(void)
 {
     QString str = wxProcess->readAllStandardOutput();
-    compileStatus->appendPlainText(str);
 
     qDebug() << "wxProcReadyLoad" << str;
 
@@ -4207,7 +4242,7 @@ void MainSpinWindow::wxProcReadyRead(void)
     QString name = namev.toString();
     QString str;
 
-    if(procDone == true) return;
+    if(wxProcDone == true) return;
 
     qDebug() << "wxProcReadyRead" << str;
 
@@ -4224,22 +4259,22 @@ void MainSpinWindow::wxProcError(QProcess::ProcessError error)
 {
     QVariant name = wxProcess->property("Name");
 
-    if(procDone == true) return;
+    if(wxProcDone == true) return;
 
     qDebug() << "wxProcError" << error;
 
     compileStatus->appendPlainText(name.toString() + tr(" error ... (%1)").arg(error));
     compileStatus->appendPlainText(wxProcess->readAllStandardOutput());
 
-    procMutex.lock();
-    procDone = true;
-    procMutex.unlock();
+    wxProcDone = true;
+    // don't retry a broken loader on every port scan
+    wxPortsTime.start();
 }
 
 #ifdef ESP8266_MODULE
 void MainSpinWindow::wxProcFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
-    if(procDone == true)
+    if(wxProcDone == true)
         return;
 
     qDebug() << "wxProcFinished" << wxPortString << exitCode << exitStatus;
@@ -4247,9 +4282,8 @@ void MainSpinWindow::wxProcFinished(int exitCode, QProcess::ExitStatus exitStatu
     QString str = wxPortString;
 
     if (!str.contains("Name:",Qt::CaseInsensitive)) {
-        procMutex.lock();
-        procDone = true;
-        procMutex.unlock();
+        wxProcDone = true;
+        mergeWxPorts(QList<WxPortInfo>());
         return;
     }
 
@@ -4258,6 +4292,7 @@ void MainSpinWindow::wxProcFinished(int exitCode, QProcess::ExitStatus exitStatu
     QRegExp idre("Name:");
     QRegExp mcre("MAC:");
     QStringList fs;
+    QList<WxPortInfo> found;
 
     foreach (QString mod, ms) {
         WxPortInfo info;
@@ -4309,13 +4344,13 @@ void MainSpinWindow::wxProcFinished(int exitCode, QProcess::ExitStatus exitStatu
                 info.portName = "X-"+info.macAddr;
             }
             QString name = info.portName;
-            foreach (WxPortInfo myinfo, wxPorts) {
+            foreach (WxPortInfo myinfo, found) {
                 if (name.compare(myinfo.portName, Qt::CaseInsensitive) == 0) {
                     name += "-" + info.ipAddr;
                     info.portName = name;
                 }
             }
-            wxPorts.append(info);
+            found.append(info);
         }
 #ifdef REMOVE
         if (info.ipAddr.length() &&
@@ -4333,21 +4368,20 @@ void MainSpinWindow::wxProcFinished(int exitCode, QProcess::ExitStatus exitStatu
                     info.portName = "X-"+info.macUpper+info.macAddr;
                 }
             }
-            wxPorts.append(info);
+            found.append(info);
         }
 #endif
     }
 
-    procMutex.lock();
-    procDone = true;
-    procMutex.unlock();
+    wxProcDone = true;
+    mergeWxPorts(found);
 }
 #endif
 
 #ifdef XBEE_SB6_MODULE
 void MainSpinWindow::wxProcFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
-    if(procDone == true)
+    if(wxProcDone == true)
         return;
 
     qDebug() << "wxProcFinished" << exitCode << exitStatus;
@@ -4355,9 +4389,8 @@ void MainSpinWindow::wxProcFinished(int exitCode, QProcess::ExitStatus exitStatu
     QString str = wxPortString;
 
     if (!str.contains("========",Qt::CaseInsensitive)) {
-        procMutex.lock();
-        procDone = true;
-        procMutex.unlock();
+        wxProcDone = true;
+        mergeWxPorts(QList<WxPortInfo>());
         return;
     }
 
@@ -4366,6 +4399,7 @@ void MainSpinWindow::wxProcFinished(int exitCode, QProcess::ExitStatus exitStatu
     QRegExp idre("nodeId:");
     QRegExp mcre("macAddr:");
     QStringList fs;
+    QList<WxPortInfo> found;
 
     foreach (QString mod, ms) {
         WxPortInfo info;
@@ -4426,13 +4460,12 @@ void MainSpinWindow::wxProcFinished(int exitCode, QProcess::ExitStatus exitStatu
                     info.portName = "X-"+info.macUpper+info.macAddr;
                 }
             }
-            wxPorts.append(info);
+            found.append(info);
         }
     }
 
-    procMutex.lock();
-    procDone = true;
-    procMutex.unlock();
+    wxProcDone = true;
+    mergeWxPorts(found);
 }
 #endif
 
@@ -4563,65 +4596,162 @@ void MainSpinWindow::procReadyRead()
 
 /*
  * make star go away if no changes.
+ * The editor keeps the saved state, so typing never reads the file.
  */
 void MainSpinWindow::fileChanged()
 {
     if(fileChangeDisable)
         return;
 
-    int index = editorTabs->currentIndex();
-    QString name = editorTabs->tabText(index);
-    Editor *ed = editors->at(index);
+    int index = editors->indexOf(qobject_cast<Editor*>(sender()));
+    if(index < 0)
+        index = editorTabs->currentIndex();
+    if(index < 0 || index >= editors->count())
+        return;
+    if(editorTabs->tabToolTip(index).length() == 0)
+        return;
+    setTabDirty(index, editors->at(index)->isDirty());
+}
+
+/*
+ * Open a file at or above the size set in Properties in a read-only
+ * viewer window instead of an editor tab.
+ * Returns false if the file is smaller or can't be mapped.
+ */
+bool MainSpinWindow::showLargeFile(QString fileName)
+{
+    qint64 limit = propDialog->getLargeFileSize();
+    if(limit <= 0 || QFileInfo(fileName).size() < limit)
+        return false;
+
+    FileViewer *viewer = new FileViewer(this);
+    viewer->setWindowFlags(Qt::Window);
+    viewer->setAttribute(Qt::WA_DeleteOnClose);
+    viewer->setFont(editorFont);
+    if(!viewer->openFile(fileName)) {
+        delete viewer;
+        return false;
+    }
+    viewer->resize(800,600);
+    viewer->show();
+    viewer->raise();
+    viewer->activateWindow();
+    return true;
+}
 
-    /* tab controls have been moved to the editor class */
+/*
+ * Close viewers of a file the build is about to rewrite.
+ * The new file is shown again after the build.
+ */
+void MainSpinWindow::closeLargeFile(QString fileName)
+{
+    foreach(FileViewer *viewer, findChildren<FileViewer *>()) {
+        if(QFileInfo(viewer->path()) == QFileInfo(fileName)) {
+            /* deleted later, so let go of the file now */
+            viewer->closeFile();
+            viewer->close();
+        }
+    }
+}
 
-    QString curtext = ed->toPlainText();
-    if(curtext.length() == 0)
-        return;
-    QString fileName = editorTabs->tabToolTip(index);
+void MainSpinWindow::setTabDirty(int tab, bool dirty)
+{
+    QString name = editorTabs->tabText(tab);
+    bool star = name.endsWith("*");
+    if(dirty && !star)
+        editorTabs->setTabText(tab, name+tr(" *"));
+    else if(!dirty && star)
+        editorTabs->setTabText(tab, shortFileName(editorTabs->tabToolTip(tab)));
+}
+
+/*
+ * Call after a tab's file is loaded or written.
+ */
+void MainSpinWindow::editorSaved(int tab)
+{
+    QString fileName = editorTabs->tabToolTip(tab);
+    editors->at(tab)->setSaved();
+    setTabDirty(tab, false);
     if(fileName.length() == 0)
         return;
+    fileStamps.insert(fileName, fileStamp(fileName));
+    if(!fileWatcher->files().contains(fileName))
+        fileWatcher->addPath(fileName);
+}
+
+MainSpinWindow::FileStamp MainSpinWindow::fileStamp(const QString &fileName)
+{
+    FileStamp stamp;
+    QFileInfo info(fileName);
+    stamp.modified = info.lastModified();
+    stamp.size = info.size();
+    stamp.hash = 0;
     QFile file(fileName);
-    if(file.exists() == false) {
-        if(curtext.length() > 0) {
-            if(name.at(name.length()-1) != '*') {
-                name += tr(" *");
-                editorTabs->setTabText(index, name);
-            }
-        }
-        return;
+    if(file.open(QFile::ReadOnly)) {
+        stamp.hash = qHash(file.readAll());
+        file.close();
     }
-    QString text;
-    int ret = 0;
+    return stamp;
+}
 
-    QChar ch = name.at(name.length()-1);
-    if(file.open(QFile::ReadOnly))
-    {
-        QTextStream in(&file);
-        if(this->isFileUTF16(&file))
-            in.setCodec("UTF-16");
-        else
-            in.setCodec("UTF-8");
+/*
+ * Another program changed or removed an open file. Unchanged editors
+ * take the new text, changed ones ask first. A removed file leaves
+ * the editor marked as changed.
+ */
+void MainSpinWindow::fileChangedOnDisk(QString fileName)
+{
+    QFileInfo info(fileName);
+    if(info.exists()) {
+        /* an edit in the same second as our save has the same time */
+        FileStamp saved = fileStamps.value(fileName);
+        if(info.lastModified() == saved.modified && info.size() == saved.size &&
+           fileStamp(fileName).hash == saved.hash)
+            return; // our own save
+    }
 
-        text = in.readAll();
-        file.close();
+    int tab = tabIndexByFileName(fileName);
+    if(tab < 0) {
+        fileWatcher->removePath(fileName);
+        fileStamps.remove(fileName);
+        return;
+    }
+    Editor *ed = editors->at(tab);
+    if(!info.exists()) {
+        ed->document()->setModified(true);
+        setTabDirty(tab, true);
+        return;
+    }
 
-        QString ctext = curtext;
-        QPlainTextEdit myed(this);
-        myed.setPlainText(text);
-        text = myed.toPlainText();
+    /* files replaced by rename are no longer watched */
+    if(!fileWatcher->files().contains(fileName))
+        fileWatcher->addPath(fileName);
+    fileStamps.insert(fileName, fileStamp(fileName));
 
-        ret = ctext.compare(text);
-        if(ret == 0) {
-            if( ch == QChar('*'))
-                editorTabs->setTabText(index, this->shortFileName(fileName));
+    if(ed->isDirty()) {
+        int rc = QMessageBox::question(this, tr("File Changed"),
+                    tr("%1 was changed by another program.").arg(shortFileName(fileName))+" "+
+                    tr("Reload it and lose your changes?"),
+                    QMessageBox::Yes | QMessageBox::No);
+        if(rc != QMessageBox::Yes)
             return;
-        }
-    }
-    if( ch != QChar('*')) {
-        name += tr(" *");
-        editorTabs->setTabText(index, name);
     }
+
+    QFile file(fileName);
+    if(!file.open(QFile::ReadOnly))
+        return;
+    QTextStream in(&file);
+    if(this->isFileUTF16(&file))
+        in.setCodec("UTF-16");
+    else
+        in.setCodec("UTF-8");
+    QString text = in.readAll();
+    file.close();
+
+    fileChangeDisable = true;
+    ed->reloadText(text);
+    fileChangeDisable = false;
+    editorSaved(tab);
 }
 
 void MainSpinWindow::printFile()
@@ -4772,6 +4902,113 @@ void MainSpinWindow::replaceInFile()
     editor->setFocus();
 }
 
+/*
+ * Find and replace in all project files.
+ */
+void MainSpinWindow::findInProject()
+{
+    if(projectFind == NULL) {
+        projectFind = new ProjectFind(this);
+        projectFind->setIndex(codeIndex);
+        projectFind->setEditors(editorTabs, editors);
+        connect(projectFind,SIGNAL(showMatch(QString,int)),this,SLOT(projectFindShow(QString,int)));
+    }
+
+    QStringList libraryFiles;
+    QStringList files = projectFileList(&libraryFiles);
+
+    projectFind->setFiles(files, libraryFiles);
+    if(editorTabs->count() > 0) {
+        QString text = editors->at(editorTabs->currentIndex())->textCursor().selectedText();
+        if(text.isEmpty() == false)
+            projectFind->setFindText(text);
+    }
+    projectFind->show();
+    projectFind->raise();
+    projectFind->activateWindow();
+}
+
+void MainSpinWindow::projectFindShow(QString fileName, int line)
+{
+    openFileName(fileName);
+    Editor *ed = editors->at(editorTabs->currentIndex());
+    if(ed) ed->setLineNumber(line);
+}
+
+/*
+ * Full path of every source in the project. Folders named by -I entries
+ * and the Spin library give the library files.
+ * Without a project the open editor files are used.
+ */
+QStringList MainSpinWindow::projectFileList(QStringList *libraryFiles)
+{
+    QStringList files;
+    QStringList folders;
+
+    if(projectFile.isEmpty()) {
+        for(int n = 0; n < editorTabs->count(); n++) {
+            QString name = editorTabs->tabToolTip(n);
+            if(name.length() > 0 && QFile::exists(name))
+                files.append(name);
+        }
+        return files;
+    }
+
+    QString projPath = sourcePath(projectFile);
+    QString spinLib = propDialog->getSpinLibraryStr();
+
+    QFile proj(projectFile);
+    if(proj.open(QFile::ReadOnly | QFile::Text)) {
+        QStringList list = QString(proj.readAll()).split("\n");
+        proj.close();
+        foreach(QString item, list) {
+            item = item.trimmed();
+            if(item.isEmpty() || item.at(0) == '>')
+                continue;
+            if(item.indexOf("-I") == 0) {
+                QString dir = QDir::fromNativeSeparators(item.mid(2).trimmed());
+                if(QDir::isRelativePath(dir))
+                    dir = projPath+dir;
+                folders.append(dir);
+                continue;
+            }
+            if(item.at(0) == '-' || item.endsWith(".a"))
+                continue;
+
+            QString name = item;
+            if(item.contains(FILELINK)) {
+                name = item.mid(item.indexOf(FILELINK)+QString(FILELINK).length());
+                name = QDir::fromNativeSeparators(name);
+                if(QDir::isRelativePath(name))
+                    name = projPath+name;
+            }
+            else {
+                name = projPath+item;
+                if(!QFile::exists(name) && QFile::exists(spinLib+item))
+                    name = spinLib+item;
+            }
+            if(QFile::exists(name) && !files.contains(name))
+                files.append(name);
+        }
+    }
+
+    if(libraryFiles != NULL) {
+        if(isSpinProject() && spinLib.length() > 0)
+            folders.append(spinLib);
+        QStringList filters;
+        filters << "*.c" << "*.cpp" << "*.h" << "*.s" << "*.spin";
+        foreach(QString folder, folders) {
+            QDir dir(folder);
+            foreach(QString s, dir.entryList(filters, QDir::Files)) {
+                QString name = dir.absoluteFilePath(s);
+                if(!files.contains(name) && !libraryFiles->contains(name))
+                    libraryFiles->append(name);
+            }
+        }
+    }
+    return files;
+}
+
 /*
  * FindHelp
  *
@@ -5315,6 +5552,59 @@ void MainSpinWindow::programDebug()
     cbPort->setEnabled(false);
 }
 
+/*
+ * Build once, then load the image to every selected port in parallel.
+ */
+void MainSpinWindow::programGangLoad()
+{
+    if(gangLoadDialog->isLoading()) {
+        gangLoadDialog->show();
+        return;
+    }
+
+    if(runBuild(""))
+        return;
+
+    portListener->close();
+    btnConnected->setChecked(false);
+    term->setPortEnabled(false);
+
+    getApplicationSettings();
+
+    gangLoadDialog->clearPorts();
+    for(int n = 0; n < cbPort->count(); n++) {
+        QString port = cbPort->itemText(n);
+        if(port.isEmpty() || port.compare(AUTO_PORT) == 0)
+            continue;
+        QStringList ramArgs = getLoaderArguments("-r", QString(), port, false);
+        QStringList eepromArgs = getLoaderArguments("-e -r", QString(), port, false);
+        gangLoadDialog->addPort(port, ramArgs, eepromArgs, nativeLoaderImage(ramArgs, port));
+    }
+    gangLoadDialog->setLoader(aSideLoader, this->sourcePath(projectFile),
+        rtsReset() ? PropellerID::RESET_BY_RTS : PropellerID::RESET_BY_DTR);
+    gangLoadDialog->show();
+    gangLoadDialog->raise();
+}
+
+/*
+ * Show the extra terminal sessions, offering every known port.
+ */
+void MainSpinWindow::terminalSessions()
+{
+    QStringList ports;
+    for(int n = 0; n < cbPort->count(); n++) {
+        QString port = cbPort->itemText(n);
+        if(port.isEmpty() || port.compare(AUTO_PORT) == 0)
+            continue;
+        ports.append(port);
+    }
+    termSessions->setPorts(ports);
+    termSessions->show();
+    termSessions->raise();
+    if(termSessions->sessionCount() == 0)
+        termSessions->newSession();
+}
+
 void MainSpinWindow::debugCompileLoad()
 {
     QString gdbprog("propeller-elf-gdb");
@@ -5569,6 +5859,16 @@ void MainSpinWindow::setCurrentBoard(int index)
     projectOptions->setBoardType(boardName);
     cbBoard->setCurrentIndex(index);
     sdCardDownloadEnable();
+
+    /* A board config terminal-baudrate sets the terminal rate, e.g. for
+     * Mbaud logging. baudrate is the loader rate and is left alone.
+     */
+    ASideBoard* board = aSideConfig->getBoardData(boardName);
+    if(board != NULL && term != NULL) {
+        QString rate = board->get(ASideBoard::termbaudrate);
+        if(rate.length() > 0 && rate.toInt() > 0)
+            term->setBaudRate(rate.toInt());
+    }
 }
 
 void MainSpinWindow::setCurrentPort(int index)
@@ -6031,6 +6331,77 @@ void MainSpinWindow::statusPassed()
     status->setStyleSheet("QLabel { background-color: rgb(0,200,0); }");
 }
 
+/*
+ * Loader command line for one port, as runLoader would start it.
+ */
+QStringList MainSpinWindow::getLoaderArguments(QString copts, QString file, QString port, bool rename_only)
+{
+    QStringList args = getLoaderParameters(copts, file);
+
+#ifdef ENABLE_WXLOADER
+    // picky wxloader J
+    for (int n = args.count()-1; n > -1; n--) {
+        if (args[n].length() == 0)
+            args.removeAt(n);
+    }
+
+    QString loadtype = cbBoard->currentText();
+    if(loadtype.compare("GENERIC") == 0) loadtype = "RCFAST";
+    if(!loadtype.isEmpty() && loadtype.length() > 0 && rename_only == false) {
+        args.append("-I");
+        args.append(aSideIncludes);
+        args.append("-b");
+        args.append(loadtype.toLower());
+    }
+
+    if (getWxPortIpAddr(port).length()) {
+        //args.removeOne("-r");
+        args.append("-i");
+        args.append(getWxPortIpAddr(port));
+    } else {
+        //args.append("-s"); // autodetect serial port
+        args.append("-p");
+        args.append(port);
+    }
+
+    // Do this if syntax is enforced. I.E. proploader [options] file
+    QString tmp = args[0];
+    args.removeAt(0);
+    if (rename_only == false) {
+        args.append(tmp);
+    }
+
+#endif
+
+#ifdef ENABLE_PROPELLER_LOAD
+    args.append("-p");
+    args.append(port);
+#endif
+    return args;
+}
+
+/*
+ * Image path for the in-process loader, or empty if the board doesn't
+ * select "loader: native", the port is a WX module, or the build
+ * isn't a Spin image.
+ */
+QString MainSpinWindow::nativeLoaderImage(QStringList args, QString port)
+{
+    ASideBoard *board = aSideConfig->getBoardData(cbBoard->currentText());
+    if(board == NULL || getWxPortIpAddr(port).length() > 0)
+        return QString();
+    if(board->get(ASideBoard::loader).compare("native", Qt::CaseInsensitive) != 0)
+        return QString();
+    foreach(QString arg, args) {
+        if(arg.endsWith(".binary") || arg.endsWith(".eeprom")) {
+            if(QFileInfo(arg).isRelative())
+                arg = this->sourcePath(projectFile) + arg;
+            return arg;
+        }
+    }
+    return QString();
+}
+
 int  MainSpinWindow::runLoader(QString copts)
 {
 
@@ -6102,54 +6473,21 @@ int  MainSpinWindow::runLoader(QString copts)
     }
 #endif
 
-    QStringList args = getLoaderParameters(copts, file);
-
     portName = serialPort();
     if(portName.compare(AUTO_PORT) == 0) {
         compileStatus->appendPlainText("error: Propeller not found on any port.");
         return 1;
     }
 
-#ifdef ENABLE_WXLOADER
-    // picky wxloader J
-    for (int n = args.count()-1; n > -1; n--) {
-        if (args[n].length() == 0)
-            args.removeAt(n);
-    }
-
-    QString loadtype = cbBoard->currentText();
-    if(loadtype.compare("GENERIC") == 0) loadtype = "RCFAST";
-    if(!loadtype.isEmpty() && loadtype.length() > 0 && rename_only == false) {
-        args.append("-I");
-        args.append(aSideIncludes);
-        args.append("-b");
-        args.append(loadtype.toLower());
-    }
-
-    if (getWxPortIpAddr(portName).length()) {
-        //args.removeOne("-r");
-        args.append("-i");
-        args.append(getWxPortIpAddr(portName));
-    } else {
-        //args.append("-s"); // autodetect serial port
-        args.append("-p");
-        args.append(portName);
-    }
+    QStringList args = getLoaderArguments(copts, file, portName, rename_only);
 
-    // Do this if syntax is enforced. I.E. proploader [options] file
-    QString tmp = args[0];
-    args.removeAt(0);
-    if (rename_only == false) {
-        args.append(tmp);
+    /* boards configured with "loader: native" load Spin images in-process */
+    if(rename_only == false && copts.indexOf("-R") < 0) {
+        QString image = nativeLoaderImage(args, portName);
+        if(image.length() > 0)
+            return runNativeLoader(copts, image);
     }
 
-#endif
-
-#ifdef ENABLE_PROPELLER_LOAD
-    args.append("-p");
-    args.append(portName);
-#endif
-
     builder->showBuildStart(aSideLoader,args);
 
     process->setProperty("Name", QVariant(aSideLoader));
@@ -6176,6 +6514,7 @@ int  MainSpinWindow::runLoader(QString copts)
         statusDialog->init("Loading", "Loading Program");
     }
 
+    termSessions->suspend(portName);
     portListener->close();
 
     process->start(aSideLoader,args);
@@ -6210,6 +6549,7 @@ int  MainSpinWindow::runLoader(QString copts)
     compileStatus->setTextCursor(cur);
 
     statusDialog->stop();
+    termSessions->resume(portName);
 
     if (rename_only) {
         Sleeper::ms(2000);
@@ -6219,6 +6559,52 @@ int  MainSpinWindow::runLoader(QString copts)
     return process->exitCode() | killed;
 }
 
+/*
+ * Load a Spin image with PropellerLoader instead of the external loader.
+ * Same contract as runLoader: returns 0 on success.
+ */
+int  MainSpinWindow::runNativeLoader(QString copts, QString image)
+{
+    int command = PropellerLoader::LOAD_RUN_RAM;
+    if(copts.contains("-e")) {
+        command = copts.contains("-r") ? PropellerLoader::LOAD_RUN_EEPROM : PropellerLoader::LOAD_EEPROM;
+    }
+
+    PropellerLoader loader;
+    if(rtsReset())
+        loader.setRtsReset();
+    else
+        loader.setDtrReset();
+
+    connect(&loader, SIGNAL(progress(int)), progress, SLOT(setValue(int)));
+    connect(&loader, SIGNAL(message(QString)), compileStatus, SLOT(appendPlainText(QString)));
+
+    statusDialog->init("Loading", "Loading Program");
+    status->setText(status->text()+tr(" Loading ... "));
+    termSessions->suspend(portName);
+    portListener->close();
+
+    loader.load(portName, image, command);
+    while(loader.isLoading()) {
+        QApplication::processEvents();
+        Sleeper::ms(20);
+    }
+    /* deliver the worker's last queued messages */
+    QApplication::processEvents();
+
+    int rc = loader.getResult();
+    termSessions->resume(portName);
+    status->setText(status->text() + (rc ? tr(" Load failed.") : tr(" Done.")));
+
+    QTextCursor cur = compileStatus->textCursor();
+    cur.movePosition(QTextCursor::End,QTextCursor::MoveAnchor);
+    compileStatus->setTextCursor(cur);
+
+    statusDialog->stop();
+    progress->hide();
+    return rc;
+}
+
 void MainSpinWindow::compilerError(QProcess::ProcessError error)
 {
     qDebug() << error;
@@ -6238,11 +6624,16 @@ void MainSpinWindow::closeTab(int tab)
 
     fileChangeDisable = true;
 
+    QString fileName = editorTabs->tabToolTip(tab);
     editors->at(tab)->setPlainText("");
     editors->remove(tab);
     if(editorTabs->count() == 1)
         newFile();
     editorTabs->removeTab(tab);
+    if(fileName.length() > 0 && tabIndexByFileName(fileName) < 0) {
+        fileWatcher->removePath(fileName);
+        fileStamps.remove(fileName);
+    }
 
     fileChangeDisable = false;
     currentTabChanged();
@@ -6509,6 +6900,10 @@ void MainSpinWindow::setupProjectTools(QSplitter *vsplit)
     /* project editors */
     editors = new QVector<Editor*>();
 
+    /* open files changed by other programs */
+    fileWatcher = new QFileSystemWatcher(this);
+    connect(fileWatcher,SIGNAL(fileChanged(QString)),this,SLOT(fileChangedOnDisk(QString)));
+
     /* project editor tabs */
     editorTabs = new QTabWidget(this);
     editorTabs->setTabsClosable(true);
@@ -6535,6 +6930,14 @@ void MainSpinWindow::setupProjectTools(QSplitter *vsplit)
     ideDebugAction->setShortcut(Qt::CTRL+Qt::ShiftModifier+Qt::Key_D);
     connect(ideDebugAction,SIGNAL(triggered()),this,SLOT(ideDebugShow()));
     this->addAction(ideDebugAction);
+    QAction *hlBenchAction = new QAction(tr("Benchmark Highlighter"), this);
+    hlBenchAction->setShortcut(Qt::CTRL+Qt::ShiftModifier+Qt::Key_H);
+    connect(hlBenchAction,SIGNAL(triggered()),this,SLOT(highlightBenchmark()));
+    this->addAction(hlBenchAction);
+    QAction *replaceBenchAction = new QAction(tr("Benchmark Replace All"), this);
+    replaceBenchAction->setShortcut(Qt::CTRL+Qt::ShiftModifier+Qt::Key_R);
+    connect(replaceBenchAction,SIGNAL(triggered()),this,SLOT(replaceBenchmark()));
+    this->addAction(replaceBenchAction);
 #endif
 
 #if defined(GDBENABLE)
@@ -7770,20 +8173,19 @@ void MainSpinWindow::showAssemblyFile()
     if(vs.canConvert(QVariant::String))
         fileName = vs.toString();
 
-    if(makeDebugFiles(fileName))
-        return;
-
     QString outfile = fileName.mid(0,fileName.lastIndexOf("."));
     if(outfile.contains(FILELINK)) {
         outfile = outfile.mid(outfile.indexOf(FILELINK)+QString(FILELINK).length());
         if(outfile.contains("/")) {
             outfile = outfile.mid(outfile.lastIndexOf("/")+1);
         }
-        openFileName(outputPath+outfile+SHOW_ASM_EXTENTION);
-    }
-    else {
-        openFileName(outputPath+outfile+SHOW_ASM_EXTENTION);
     }
+    closeLargeFile(outputPath+outfile+SHOW_ASM_EXTENTION);
+
+    if(makeDebugFiles(fileName))
+        return;
+
+    openFileName(outputPath+outfile+SHOW_ASM_EXTENTION);
     qDebug() << "outputPath:" << outputPath << "outfile:" << outfile;
 }
 
@@ -7797,6 +8199,7 @@ void MainSpinWindow::showMapFile()
         fileName = vs.toString();
 
     QString outfile = fileName.mid(0,fileName.lastIndexOf("."));
+    closeLargeFile(outputPath+outfile+SHOW_MAP_EXTENTION);
     runBuild("-Xlinker -Map="+outputPath+outfile+SHOW_MAP_EXTENTION);
 
     openFileName(outputPath+outfile+SHOW_MAP_EXTENTION);
@@ -7846,25 +8249,28 @@ void MainSpinWindow::findChip()
 
     compileStatus->setPlainText("Identifying Propellers ...\n");
 
-    if(rtsReset())
-        propId.setRtsReset();
-    else
-        propId.setDtrReset();
-
     int indx = cbPort->currentIndex();
     this->enumeratePorts();
     int size = cbPort->count();
     if(indx < size)
         cbPort->setCurrentIndex(indx);
 
+    QStringList ports;
     for (int n = 1; n < size; n++) {
-        QString mp;
-        mp = cbPort->itemText(n);
-        int rc = propId.isDevice(mp);
-        if(rc < 0) {
+        ports.append(cbPort->itemText(n));
+    }
+
+    PropellerSearch search(rtsReset() ? PropellerID::RESET_BY_RTS : PropellerID::RESET_BY_DTR);
+    search.find(ports, PROP_SEARCH_DEADLINE, false);
+
+    foreach(QString mp, ports) {
+        int rc = search.getStatus(mp);
+        if(rc == -2) {
+            compileStatus->appendPlainText("  Port "+mp+" did not answer in time.");
+        } else if(rc < 0) {
             compileStatus->appendPlainText("  Port "+mp+" is busy.");
         } else if(rc > 0) {
-            compileStatus->appendPlainText("  Propeller found on "+mp+".");
+            compileStatus->appendPlainText("  Propeller version "+QString::number(search.getVersion(mp))+" found on "+mp+".");
         } else {
             compileStatus->appendPlainText("  Propeller not found on "+mp+".");
         }
@@ -7875,23 +8281,19 @@ QString MainSpinWindow::serialPort()
 {
     int portIndex = cbPort->currentIndex();
     if(cbPort->currentText().compare(AUTO_PORT) == 0) {
-        if(rtsReset())
-            propId.setRtsReset();
-        else
-            propId.setDtrReset();
-
         //compileStatus->setPlainText("Finding first available propeller ... ");
         int size = cbPort->count();
 
+        QStringList ports;
         for (int n = 1; n < size; n++) {
-            QString mp;
-            mp = cbPort->itemText(n);
-            int rc = propId.isDevice(mp);
-            if(rc > 0) {
-                //compileStatus->appendPlainText("Propeller found on "+mp+".");
-                portIndex = n;
-                break;
-            }
+            ports.append(cbPort->itemText(n));
+        }
+
+        PropellerSearch search(rtsReset() ? PropellerID::RESET_BY_RTS : PropellerID::RESET_BY_DTR);
+        QString mp = search.find(ports, PROP_SEARCH_DEADLINE);
+        if(mp.length() > 0) {
+            //compileStatus->appendPlainText("Propeller found on "+mp+".");
+            portIndex = ports.indexOf(mp)+1;
         }
     }
     return(cbPort->itemText(portIndex));
@@ -7901,6 +8303,94 @@ void MainSpinWindow::enumeratePortsEvent()
 {
     enumeratePorts();
     QApplication::processEvents();
+    portListChanged();
+}
+
+/*
+ * Port names sort by their text with any trailing number compared
+ * as a number, so ttyUSB2 comes before ttyUSB10.
+ */
+static bool portNameLessThan(const QString &a, const QString &b)
+{
+    int alen = a.length();
+    int blen = b.length();
+    while(alen > 0 && a.at(alen-1).isDigit())
+        alen--;
+    while(blen > 0 && b.at(blen-1).isDigit())
+        blen--;
+    int rc = a.left(alen).compare(b.left(blen), Qt::CaseInsensitive);
+    if(rc != 0)
+        return rc < 0;
+    return a.mid(alen).toInt() < b.mid(blen).toInt();
+}
+
+/*
+ * Find where a serial port belongs in the port combo.
+ * Serial ports are kept sorted ahead of any WX ports.
+ */
+int MainSpinWindow::portInsertIndex(QString name)
+{
+    int n;
+    for(n = 0; n < cbPort->count(); n++) {
+        QString item = cbPort->itemText(n);
+#ifdef ENABLE_WXLOADER
+        if(wxPortNames.contains(item))
+            break;
+#endif
+        if(portNameLessThan(name, item))
+            break;
+    }
+    return n;
+}
+
+/*
+ * Apply hotplug changes from the port monitor to the port combo.
+ * Unlike enumeratePorts() this doesn't close the port listener,
+ * so a terminal session on a port that is still present stays open.
+ */
+void MainSpinWindow::updatePorts(QStringList added, QStringList removed)
+{
+    QString current = cbPort->currentText();
+
+    foreach(QString name, removed) {
+        int n = cbPort->findText(name);
+        if(n < 0)
+            continue;
+        if(n < friendlyPortName.count())
+            friendlyPortName.removeAt(n);
+        cbPort->removeItem(n);
+    }
+    QList<QextPortInfo> ports;
+    if(added.count() > 0)
+        ports = QextSerialEnumerator::getPorts();
+    foreach(QString name, added) {
+        if(cbPort->findText(name) > -1)
+            continue;
+        QString friendName = name;
+        for(int i = 0; i < ports.size(); i++) {
+            if(PortConnectionMonitor::portItemName(ports.at(i)) == name) {
+                friendName = ports.at(i).friendName;
+                break;
+            }
+        }
+        int n = portInsertIndex(name);
+        friendlyPortName.insert(n, friendName);
+        cbPort->insertItem(n, name);
+    }
+
+    int n = cbPort->findText(current);
+    if(n > -1)
+        cbPort->setCurrentIndex(n);
+    btnConnected->setCheckable(cbPort->count() > 0);
+
+    portListChanged();
+}
+
+/*
+ * Reselect or reconnect ports after the port list changes.
+ */
+void MainSpinWindow::portListChanged()
+{
     int len = this->cbPort->count();
 
     QString lastTermPort = term->getLastConnectedPortName();
@@ -8011,11 +8501,25 @@ QString MainSpinWindow::getWxPortIpAddr(QString wxname)
     return "";
 }
 
-#ifdef ESP8266_MODULE
+/*
+ * Start WX module discovery in the background and return what we know.
+ * Discovery results are cached for WX_DISCOVERY_TTL ms and merged into
+ * the port combo by mergeWxPorts() when the loader finishes.
+ * tools/wxdiscover answers discovery in place of a real module.
+ */
 QList<WxPortInfo> MainSpinWindow::getWxPorts(void)
 {
+    if(wxPortsTime.isValid() && wxPortsTime.elapsed() < WX_DISCOVERY_TTL)
+        return wxPorts;
+    if(wxProcess->state() != QProcess::NotRunning)
+        return wxPorts;
+
     QStringList args;
+#ifdef ESP8266_MODULE
     args.append("-W");
+#else
+    args.append("-X");
+#endif
 
     wxProcess->setProperty("Name", QVariant(aSideLoader));
     wxProcess->setProperty("IsLoader", QVariant(true));
@@ -8023,63 +8527,56 @@ QList<WxPortInfo> MainSpinWindow::getWxPorts(void)
     wxProcess->setProcessChannelMode(QProcess::MergedChannels);
     //wxProcess->setWorkingDirectory(sourcePath(fileName));
 
-    procMutex.lock();
-    procDone = false;
-    procMutex.unlock();
-
+    wxProcDone = false;
     wxPortString = "";
-    wxPorts.clear();
-
-    statusDialog->init("Searching", "Searching for ports");
 
     qDebug() << aSideLoader << args;
 
     wxProcess->start(aSideLoader, args);
 
-    while(procDone == false)
-        QApplication::processEvents();
-
-    statusDialog->stop();
-
-    //QString output = wxProcess->readAllStandardOutput();
-    //qDebug() << output;
     return wxPorts;
 }
-#else
-QList<WxPortInfo> MainSpinWindow::getWxPorts(void)
-{
-    QStringList args;
-    args.append("-X");
-
-    wxProcess->setProperty("Name", QVariant(aSideLoader));
-    wxProcess->setProperty("IsLoader", QVariant(true));
-
-    wxProcess->setProcessChannelMode(QProcess::MergedChannels);
-    //wxProcess->setWorkingDirectory(sourcePath(fileName));
 
-    procMutex.lock();
-    procDone = false;
-    procMutex.unlock();
-
-    wxPortString = "";
-    wxPorts.clear();
-
-    statusDialog->init("Searching", "Searching for ports");
-
-    qDebug() << aSideLoader << args;
+/*
+ * Called when discovery finishes. Adds new WX ports to the combo and
+ * removes ones that disappeared, except a port the terminal is using.
+ */
+void MainSpinWindow::mergeWxPorts(QList<WxPortInfo> found)
+{
+    wxPorts = found;
+    wxPortsTime.start();
 
-    wxProcess->start(aSideLoader, args);
+    QStringList names;
+    foreach (WxPortInfo wx, wxPorts) {
+        names.append(wx.portName);
+    }
 
-    while(procDone == false)
-        QApplication::processEvents();
+    QString current = cbPort->currentText();
+    QString busy = btnConnected->isChecked() ? term->getPortName() : QString("");
 
-    statusDialog->stop();
+    foreach (QString name, wxPortNames) {
+        if (names.contains(name) || name.compare(busy) == 0)
+            continue;
+        int n = cbPort->findText(name);
+        if (n < 0)
+            continue;
+        if (n < friendlyPortName.count())
+            friendlyPortName.removeAt(n);
+        cbPort->removeItem(n);
+    }
+    foreach (QString name, names) {
+        if (cbPort->findText(name) > -1)
+            continue;
+        friendlyPortName.append(name);
+        cbPort->addItem(name);
+    }
+    wxPortNames = names;
 
-    //QString output = wxProcess->readAllStandardOutput();
-    //qDebug() << output;
-    return wxPorts;
+    int n = cbPort->findText(current);
+    if (n > -1)
+        cbPort->setCurrentIndex(n);
+    btnConnected->setCheckable(cbPort->count() > 0);
 }
-#endif
 
 void MainSpinWindow::enumeratePorts()
 {
@@ -8100,87 +8597,40 @@ void MainSpinWindow::enumeratePorts()
     friendlyPortName.append(AUTO_PORT);
 #endif
     QList<QextPortInfo> ports = QextSerialEnumerator::getPorts();
-    QStringList stringlist;
+    QStringList names;
+    QHash<QString,QString> friendNames;
     QString name;
-    stringlist << "List of ports:";
     for (int i = 0; i < ports.size(); i++) {
-        stringlist << "port name:" << ports.at(i).portName;
-        stringlist << "friendly name:" << ports.at(i).friendName;
-        stringlist << "physical name:" << ports.at(i).physName;
-        stringlist << "enumerator name:" << ports.at(i).enumName;
-        stringlist << "vendor ID:" << QString::number(ports.at(i).vendorID, 16);
-        stringlist << "product ID:" << QString::number(ports.at(i).productID, 16);
-        stringlist << "===================================";
-#if defined(Q_OS_WIN)
-        name = ports.at(i).portName;
-        if(ports.at(i).friendName.length() > 0) {
-            if(ports.at(i).friendName.contains("Bluetooth", Qt::CaseInsensitive)) {
-                continue;
-            }
-        }
-        if(name.lastIndexOf('\\') > -1)
-            name = name.mid(name.lastIndexOf('\\')+1);
-        if(name.contains(QString("LPT"),Qt::CaseInsensitive) == false) {
-            friendlyPortName.append(ports.at(i).friendName);
-            cbPort->addItem(name);
-        }
-#elif defined(Q_OS_MAC)
-        name = ports.at(i).portName;
-        if(ports.at(i).physName.length() > 0) {
-            if(ports.at(i).physName.contains("Bluetooth", Qt::CaseInsensitive)) {
-                continue;
-            }
-        }
-        if(name.indexOf("usbserial",0,Qt::CaseInsensitive) > -1) {
-            friendlyPortName.append(ports.at(i).friendName);
-            cbPort->addItem(name);
-        }
-#else
-        QString ttys = "ttyS";
-
-        name = ports.at(i).physName;
-        friendlyPortName.append(ports.at(i).friendName);
-
-        qDebug() << "USB" << name.indexOf("usb",0,Qt::CaseInsensitive);
-
-        // ttyUSBn
-        if(name.indexOf("ttyusb",0,Qt::CaseInsensitive) > -1) {
-            cbPort->addItem(name);
-            qDebug() << "Added " << name;
-        }
-        // ttyACMn
-        else if(name.indexOf("ttyacm",0,Qt::CaseInsensitive) > -1) {
-            cbPort->addItem(name);
-            qDebug() << "Added " << name;
-	}
-        // ttyAMAn
-        else if(name.indexOf("ttyama",0,Qt::CaseInsensitive) > -1) {
-            cbPort->addItem(name);
-            qDebug() << "Added " << name;
-	}
-        // ttySn
-        else if(name.indexOf(ttys,0,Qt::CaseInsensitive) > -1) {
-            /* just allow ttyS0 - ttyS9 */
-            QString ttysNum = name.mid(ttys.length());
-            int ttyslen = ttysNum.length();
-            //qDebug() << "enumerateports " << name << ttysNum << ttyslen;
-            if (ttyslen > 5 && ttyslen < 7) {
-                cbPort->addItem(name);
-                qDebug() << "Added " << name;
-            }
+        name = PortConnectionMonitor::portItemName(ports.at(i));
+        if(name.isEmpty() || friendNames.contains(name))
+            continue;
+        names.append(name);
+        friendNames.insert(name, ports.at(i).friendName);
+    }
+    qSort(names.begin(), names.end(), portNameLessThan);
+    foreach(name, names) {
+        friendlyPortName.append(friendNames.value(name));
+        cbPort->addItem(name);
+    }
+
+    /* Device paths the enumerator can't see, such as the pty end of a
+     * board emulator. Listed only while the device exists.
+     */
+    QSettings settings(publisherKey, ASideGuiKey);
+    foreach(QString extra, settings.value(extraPortsKey).toStringList()) {
+        if(QFile::exists(extra) && cbPort->findText(extra) < 0) {
+            friendlyPortName.append(extra);
+            cbPort->addItem(extra);
         }
-        else
-            cbPort->addItem(name);
-#endif
-        qDebug() << "enumerateports" << name;
     }
 
 #ifdef ENABLE_WXLOADER
-    getWxPorts();
-    foreach (WxPortInfo wx, wxPorts) {
+    wxPortNames.clear();
+    foreach (WxPortInfo wx, getWxPorts()) {
         if (cbPort->findText(wx.portName) > -1) {
             continue;
         }
+        wxPortNames.append(wx.portName);
         friendlyPortName.append(wx.portName);
         cbPort->addItem(wx.portName);
     }
@@ -8270,6 +8720,14 @@ void MainSpinWindow::portRename()
             int w = text.length()*s;
             if (size.width() < w) size.setWidth(w);
             int ndx = cbPort->currentIndex();
+            QString oldName = cbPort->itemText(ndx);
+            for (int n = 0; n < wxPorts.count(); n++) {
+                if (wxPorts[n].portName.compare(oldName) == 0)
+                    wxPorts[n].portName = text;
+            }
+            int wxn = wxPortNames.indexOf(oldName);
+            if (wxn > -1)
+                wxPortNames[wxn] = text;
             cbPort->setItemText(ndx, text);
             //cbPort->setCurrentText(text);
             cbPort->setToolTip(text);
@@ -8500,6 +8958,7 @@ void MainSpinWindow::setEditorTab(int num, QString shortName, QString fileName,
     fileChangeDisable = false;
     editorTabs->setTabText(num,shortName);
     editorTabs->setTabToolTip(num,fileName);
+    editorSaved(num);
     editorTabs->setCurrentIndex(num);
     currentTabChanged();
     qDebug() << "setEditorTab" << fileName << num << "Total Tabs" << editorTabs->count() << "Total Editors" << editors->count();
@@ -8596,6 +9055,7 @@ void MainSpinWindow::setupFileMenu()
 */
     editMenu->addSeparator();
     editMenu->addAction(QIcon(":/images/find.png"), tr("&Find and Replace"), this, SLOT(replaceInFile()), QKeySequence::Find);
+    editMenu->addAction(tr("Find in &Project ..."), this, SLOT(findInProject()), Qt::CTRL+Qt::ShiftModifier+Qt::Key_F);
 
     editMenu->addSeparator();
     editMenu->addAction(QIcon(":/images/redo.png"), tr("&Redo"), this, SLOT(redoChange()), QKeySequence::Redo);
@@ -8692,12 +9152,14 @@ void MainSpinWindow::setupFileMenu()
 #endif
 /* CHANGE_ALL_MAC_PROGRAM_KEYS */
 
+    programMenu->addAction(tr("Load to Selected Ports ..."), this, SLOT(programGangLoad()));
     programMenu->addAction(QIcon(":/images/Abort.png"), tr("Stop Build or Loader"), this, SLOT(programStopBuild()));
     programMenu->addSeparator();
 #ifdef ENABLE_FILETO_SDCARD
     programMenu->addAction(QIcon(":/images/SaveToSD.png"), tr(FileToSDCard), this, SLOT(downloadSdCard()));
 #endif
     programMenu->addAction(QIcon(":/images/console.png"), tr("Open Terminal"), this, SLOT(menuActionConnectButton()));
+    programMenu->addAction(tr("Terminal Sessions ..."), this, SLOT(terminalSessions()));
     programMenu->addAction(QIcon(":/images/reset.png"), tr("Reset Port"), this, SLOT(portResetButton()));
     programMenu->addAction(tr(BuildAllLibraries), this, SLOT(programBuildAllLibraries()), Qt::CTRL+Qt::ALT+Qt::Key_F12);
 
@@ -9188,3 +9650,31 @@ void MainSpinWindow::ideDebugShow()
         statusTabs->setCurrentIndex(ideDebugTabIndex);
     }
 }
+
+/*
+ * Time the regex highlight rules against the lexer on the current editor.
+ */
+void MainSpinWindow::highlightBenchmark()
+{
+    int n = editorTabs->currentIndex();
+    if(n < 0 || n >= editors->count())
+        return;
+    Highlighter *hl = editors->at(n)->getHighlighter();
+    if(hl == NULL)
+        return;
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    QString s = hl->benchmark();
+    QApplication::restoreOverrideCursor();
+    QMessageBox::information(this, tr("Benchmark Highlighter"), s);
+}
+
+/*
+ * Time Replace All on a generated document with 100k matches.
+ */
+void MainSpinWindow::replaceBenchmark()
+{
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    QString s = TextReplacer::benchmark(100000);
+    QApplication::restoreOverrideCursor();
+    QMessageBox::information(this, tr("Benchmark Replace All"), s);
+}
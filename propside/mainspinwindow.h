@@ -46,6 +46,7 @@
 #include "projectoptions.h"
 #include "cbuildtree.h"
 #include "replacedialog.h"
+#include "textreplacer.h"
 #include "aboutdialog.h"
 #include "ctags.h"
 #include "newproject.h"
@@ -63,6 +64,10 @@
 #include "zipper.h"
 #include "StatusDialog.h"
 #include "rescuedialog.h"
+#include "gangloaddialog.h"
+#include "termsessions.h"
+#include "projectfind.h"
+#include "fileviewer.h"
 
 #ifdef QT5
 #include <QtPrintSupport/QPrinter>
@@ -173,6 +178,8 @@ public slots:
     void programBurnEE();
     void programRun();
     void programDebug();
+    void programGangLoad();
+    void terminalSessions();
 
     void debugCompileLoad();
     void gdbShowLine();
@@ -193,6 +200,7 @@ public slots:
     void quitProgram();
 
     void fileChanged();
+    void fileChangedOnDisk(QString fileName);
     void keyHandler(QKeyEvent* event);
     void sendPortMessage(QString s);
 
@@ -200,10 +208,13 @@ public slots:
     QString serialPort();
 
     QList<WxPortInfo> getWxPorts(void);
+    void mergeWxPorts(QList<WxPortInfo> found);
     QString getWxPortIpAddr(QString wxname);
 
     void enumeratePorts();
     void enumeratePortsEvent();
+    void updatePorts(QStringList added, QStringList removed);
+    void portListChanged();
     void reloadBoardTypes();
     void initBoardTypes();
 
@@ -221,6 +232,8 @@ public slots:
     void editCommand();
     void systemCommand();
     void replaceInFile();
+    void findInProject();
+    void projectFindShow(QString fileName, int line);
     void redoChange();
     void undoChange();
     void findDeclaration();
@@ -314,6 +327,9 @@ private:
 #endif
     QStringList getLoaderParameters(QString options, QString file);
     int  runLoader(QString options);
+    int  runNativeLoader(QString options, QString image);
+    QStringList getLoaderArguments(QString copts, QString file, QString port, bool rename_only);
+    QString nativeLoaderImage(QStringList args, QString port);
 #ifdef KEEP_CTOOLS
     int  startProgram(QString program, QString workpath, QStringList args, DumpType dump = DumpOff);
 #endif
@@ -343,8 +359,14 @@ private:
     void updateSpinProjectTree(QString fileName, QString projName);
 
     void setEditorTab(int num, QString shortName, QString fileName, QString text);
+    void setTabDirty(int tab, bool dirty);
+    bool showLargeFile(QString fileName);
+    void closeLargeFile(QString fileName);
+    int  portInsertIndex(QString name);
+    void editorSaved(int tab);
     QString shortFileName(QString fileName);
     QString sourcePath(QString file);
+    QStringList projectFileList(QStringList *libraryFiles);
 
     void cStatusClicked(QString line);
     void spinStatusClicked(QString line);
@@ -409,6 +431,16 @@ private:
 
     QTabWidget      *editorTabs;
     QVector<Editor*> *editors;
+    QFileSystemWatcher *fileWatcher;
+    /* an open file as last loaded or saved; the time alone may only
+     * have second resolution, so size and contents are kept too */
+    typedef struct {
+        QDateTime   modified;
+        qint64      size;
+        uint        hash;
+    } FileStamp;
+    FileStamp       fileStamp(const QString &fileName);
+    QMap<QString,FileStamp> fileStamps;
     QFont           editorFont;
     bool            fileChangeDisable;
     bool            tabChangeDisable;
@@ -511,16 +543,25 @@ private:
     bool            allowProjectView;
 
     RescueDialog    *rescueDialog;
+    GangLoadDialog  *gangLoadDialog;
+    TermSessions    *termSessions;
+    ProjectFind     *projectFind;
+    TrigramIndex    *codeIndex;
 
     QString         lastCbPort;
     QPrinter        printer;
 
     QList<WxPortInfo> wxPorts;
+    QStringList     wxPortNames;
+    QElapsedTimer   wxPortsTime;
     QProcess        *wxProcess;
     QString         wxPortString;
+    bool            wxProcDone;
 
 public slots:
     void ideDebugShow();
+    void highlightBenchmark();
+    void replaceBenchmark();
 private:
     int ideDebugTabIndex;
 
@@ -0,0 +1,372 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "projectfind.h"
+#include "textreplacer.h"
+#include "editor.h"
+
+/* item data roles for result rows */
+#define ROLE_FILE   (Qt::UserRole)
+#define ROLE_LINE   (Qt::UserRole+1)
+#define ROLE_TEXT   (Qt::UserRole+2)
+
+ProjectFind::ProjectFind(QWidget *parent) :
+    QDialog(parent)
+{
+    regex = false;
+    wholeWord = false;
+    caseSensitive = false;
+    index = NULL;
+    editorTabs = NULL;
+    editors = NULL;
+    listed = 0;
+
+    setWindowTitle(tr("Find in Project"));
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    QGridLayout *grid = new QGridLayout();
+    findEdit = new QLineEdit(this);
+    replaceEdit = new QLineEdit(this);
+    findBtn = new QPushButton(tr("Find"), this);
+    stopBtn = new QPushButton(tr("Stop"), this);
+    replaceBtn = new QPushButton(tr("Replace ..."), this);
+    findBtn->setDefault(true);
+    stopBtn->setAutoDefault(false);
+    stopBtn->setEnabled(false);
+    replaceBtn->setAutoDefault(false);
+    grid->addWidget(new QLabel(tr("Find text:"), this), 0, 0);
+    grid->addWidget(findEdit, 0, 1);
+    grid->addWidget(findBtn, 0, 2);
+    grid->addWidget(stopBtn, 0, 3);
+    grid->addWidget(new QLabel(tr("Replace with:"), this), 1, 0);
+    grid->addWidget(replaceEdit, 1, 1);
+    grid->addWidget(replaceBtn, 1, 2);
+    layout->addLayout(grid);
+
+    QHBoxLayout *optRow = new QHBoxLayout();
+    wordBox = new QCheckBox(tr("Whole Word"), this);
+    caseBox = new QCheckBox(tr("Case Sensitive"), this);
+    regexBox = new QCheckBox(tr("Regular Expression"), this);
+    libraryBox = new QCheckBox(tr("Include Library Folders"), this);
+    workspaceBox = new QCheckBox(tr("Include Workspace"), this);
+    workspaceBox->setEnabled(false);
+    optRow->addWidget(wordBox);
+    optRow->addWidget(caseBox);
+    optRow->addWidget(regexBox);
+    optRow->addWidget(libraryBox);
+    optRow->addWidget(workspaceBox);
+    optRow->addStretch();
+    layout->addLayout(optRow);
+
+    results = new QTreeWidget(this);
+    results->setColumnCount(1);
+    results->setHeaderHidden(true);
+    results->setUniformRowHeights(true);
+    layout->addWidget(results);
+
+    summary = new QLabel(this);
+    layout->addWidget(summary);
+
+    connect(findEdit, SIGNAL(returnPressed()), this, SLOT(find()));
+    connect(findBtn, SIGNAL(clicked()), this, SLOT(find()));
+    connect(stopBtn, SIGNAL(clicked()), this, SLOT(stop()));
+    connect(replaceBtn, SIGNAL(clicked()), this, SLOT(replace()));
+    connect(results, SIGNAL(itemActivated(QTreeWidgetItem*,int)), this, SLOT(itemActivated(QTreeWidgetItem*,int)));
+    connect(&search, SIGNAL(found(QString,int,int,int,QString)), this, SLOT(addHit(QString,int,int,int,QString)));
+    connect(&search, SIGNAL(finished(int,int,qint64)), this, SLOT(searchDone(int,int,qint64)));
+
+    setLayout(layout);
+    resize(700,500);
+}
+
+/**
+ * @param projectFiles full paths of project files.
+ * @param libraryFiles full paths of library sources, searched on request.
+ */
+void ProjectFind::setFiles(const QStringList &projectFiles, const QStringList &libraryFiles)
+{
+    this->projectFiles = projectFiles;
+    this->libraryFiles = libraryFiles;
+    libraryBox->setEnabled(libraryFiles.count() > 0);
+    results->clear();
+    fileItems.clear();
+    summary->setText(tr("%1 project files").arg(projectFiles.count()));
+}
+
+/**
+ * @param tabs editor tabs; each tab tool tip is the full file name.
+ * @param editors the editor of each tab, in tab order.
+ */
+void ProjectFind::setEditors(QTabWidget *tabs, QVector<Editor*> *editors)
+{
+    this->editorTabs = tabs;
+    this->editors = editors;
+}
+
+/*
+ * Editors by full file name as the tabs are now. Tabs open and close
+ * while the dialog is up, so this is looked up for each find or replace.
+ */
+QMap<QString,QPlainTextEdit*> ProjectFind::openEditors()
+{
+    QMap<QString,QPlainTextEdit*> open;
+    if(editorTabs == NULL || editors == NULL)
+        return open;
+    for(int n = 0; n < editorTabs->count(); n++) {
+        QString name = editorTabs->tabToolTip(n);
+        if(name.length() > 0 && n < editors->count())
+            open.insert(name, editors->at(n));
+    }
+    return open;
+}
+
+void ProjectFind::setFindText(const QString &text)
+{
+    findEdit->setText(text);
+    findEdit->selectAll();
+}
+
+/**
+ * @param index workspace index used to skip files, or NULL for none.
+ */
+void ProjectFind::setIndex(TrigramIndex *index)
+{
+    this->index = index;
+    workspaceBox->setEnabled(index != NULL);
+}
+
+void ProjectFind::find()
+{
+    pattern = findEdit->text();
+    regex = regexBox->isChecked();
+    wholeWord = wordBox->isChecked();
+    caseSensitive = caseBox->isChecked();
+
+    TextReplacer check(pattern, QString(), regex, wholeWord, caseSensitive);
+    if(!check.isValid()) {
+        summary->setText(check.errorString());
+        return;
+    }
+
+    results->clear();
+    fileItems.clear();
+    timer.start();
+
+    QStringList files = projectFiles;
+    QSet<QString> listedSet = files.toSet();
+    if(libraryBox->isChecked()) {
+        foreach(const QString &s, libraryFiles) {
+            if(!listedSet.contains(s)) {
+                listedSet.insert(s);
+                files.append(s);
+            }
+        }
+    }
+    if(index != NULL && workspaceBox->isChecked()) {
+        foreach(const QString &s, index->files()) {
+            if(!listedSet.contains(s)) {
+                listedSet.insert(s);
+                files.append(s);
+            }
+        }
+    }
+
+    /* search what the user sees in open editors, not the saved file */
+    QMap<QString,QString> openText;
+    QMapIterator<QString,QPlainTextEdit*> it(openEditors());
+    while(it.hasNext()) {
+        it.next();
+        openText.insert(it.key(), it.value()->toPlainText());
+    }
+
+    listed = files.count();
+    if(index != NULL) {
+        /* the index only knows what is on disk */
+        QStringList keep = index->narrow(files, pattern, regex);
+        QSet<QString> keepSet = keep.toSet();
+        foreach(const QString &s, files) {
+            if(openText.contains(s) && !keepSet.contains(s))
+                keep.append(s);
+        }
+        files = keep;
+    }
+
+    findBtn->setEnabled(false);
+    replaceBtn->setEnabled(false);
+    stopBtn->setEnabled(true);
+    summary->setText(tr("Searching %1 of %2 files ...").arg(files.count()).arg(listed));
+    search.start(files, openText, pattern, regex, wholeWord, caseSensitive);
+}
+
+void ProjectFind::stop()
+{
+    search.stop();
+}
+
+void ProjectFind::addHit(QString fileName, int line, int column, int length, QString text)
+{
+    Q_UNUSED(column);
+    Q_UNUSED(length);
+
+    QTreeWidgetItem *fileItem = fileItems.value(fileName, NULL);
+    if(fileItem == NULL) {
+        fileItem = new QTreeWidgetItem(results);
+        fileItem->setText(0, QDir::toNativeSeparators(fileName));
+        fileItem->setData(0, ROLE_FILE, fileName);
+        fileItem->setData(0, ROLE_LINE, 0);
+        fileItem->setExpanded(true);
+        fileItems.insert(fileName, fileItem);
+    }
+    QTreeWidgetItem *item = new QTreeWidgetItem(fileItem);
+    item->setText(0, QString("%1: %2").arg(line).arg(text.trimmed()));
+    item->setData(0, ROLE_FILE, fileName);
+    item->setData(0, ROLE_LINE, line);
+    item->setData(0, ROLE_TEXT, text);
+}
+
+void ProjectFind::searchDone(int files, int hits, qint64 ms)
+{
+    Q_UNUSED(ms);
+    findBtn->setEnabled(true);
+    replaceBtn->setEnabled(true);
+    stopBtn->setEnabled(false);
+    summary->setText(tr("%1 matches in %2 of %3 files, %4 read (%5 ms)")
+            .arg(hits).arg(fileItems.count()).arg(listed).arg(files).arg(timer.elapsed()));
+}
+
+void ProjectFind::itemActivated(QTreeWidgetItem *item, int column)
+{
+    Q_UNUSED(column);
+    if(item == NULL)
+        return;
+    QString fileName = item->data(0, ROLE_FILE).toString();
+    int line = item->data(0, ROLE_LINE).toInt();
+    emit showMatch(fileName, line > 0 ? line : 1);
+}
+
+/*
+ * Preview the replacement line by line for every file in the results,
+ * then apply it to the files left checked.
+ */
+void ProjectFind::replace()
+{
+    if(fileItems.count() == 0 || search.isRunning())
+        return;
+
+    QString with = replaceEdit->text();
+    TextReplacer lineReplacer(pattern, with, regex, wholeWord, caseSensitive);
+
+    QDialog preview(this);
+    preview.setWindowTitle(tr("Replace in Project"));
+    QVBoxLayout *layout = new QVBoxLayout(&preview);
+    layout->addWidget(new QLabel(tr("Replace \"%1\" with \"%2\" in the checked files:").arg(pattern).arg(with), &preview));
+    QTreeWidget *tree = new QTreeWidget(&preview);
+    tree->setColumnCount(2);
+    tree->setHeaderLabels(QStringList() << tr("Line") << tr("Replacement"));
+    layout->addWidget(tree);
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, Qt::Horizontal, &preview);
+    buttons->button(QDialogButtonBox::Ok)->setText(tr("Replace"));
+    connect(buttons, SIGNAL(accepted()), &preview, SLOT(accept()));
+    connect(buttons, SIGNAL(rejected()), &preview, SLOT(reject()));
+    layout->addWidget(buttons);
+    preview.resize(800,500);
+
+    for(int n = 0; n < results->topLevelItemCount(); n++) {
+        QTreeWidgetItem *fileItem = results->topLevelItem(n);
+        QTreeWidgetItem *top = new QTreeWidgetItem(tree);
+        top->setText(0, fileItem->text(0));
+        top->setData(0, ROLE_FILE, fileItem->data(0, ROLE_FILE));
+        top->setCheckState(0, Qt::Checked);
+        for(int c = 0; c < fileItem->childCount(); c++) {
+            QTreeWidgetItem *hit = fileItem->child(c);
+            QString text = hit->data(0, ROLE_TEXT).toString();
+            QTreeWidgetItem *item = new QTreeWidgetItem(top);
+            item->setText(0, hit->text(0));
+            item->setText(1, lineReplacer.replaceAll(text).trimmed());
+        }
+        top->setExpanded(true);
+    }
+    tree->resizeColumnToContents(0);
+
+    if(preview.exec() != QDialog::Accepted)
+        return;
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    QMap<QString,QPlainTextEdit*> open = openEditors();
+    int files = 0;
+    int total = 0;
+    QStringList failed;
+    for(int n = 0; n < tree->topLevelItemCount(); n++) {
+        QTreeWidgetItem *top = tree->topLevelItem(n);
+        if(top->checkState(0) != Qt::Checked)
+            continue;
+        QString fileName = top->data(0, ROLE_FILE).toString();
+        int count = 0;
+        if(applyReplace(fileName, open.value(fileName, NULL), &count)) {
+            if(count > 0)
+                files++;
+            total += count;
+        }
+        else {
+            failed.append(fileName);
+        }
+    }
+    QApplication::restoreOverrideCursor();
+
+    QString msg = tr("Replaced %1 instances in %2 files.").arg(total).arg(files);
+    if(failed.count() > 0)
+        msg += "\n\n"+tr("Could not write:")+"\n"+failed.join("\n");
+    QMessageBox::information(this, tr("Replace Done"), msg);
+
+    find();
+}
+
+/*
+ * An open editor, ed, is changed as one undo step and left unsaved.
+ * Other files are rewritten only if something changed, in the
+ * encoding they were read with.
+ */
+bool ProjectFind::applyReplace(const QString &fileName, QPlainTextEdit *ed, int *count)
+{
+    TextReplacer replacer(pattern, replaceEdit->text(), regex, wholeWord, caseSensitive);
+
+    if(ed != NULL) {
+        *count = replacer.replaceAll(ed->document());
+        return true;
+    }
+
+    QTextCodec *codec;
+    QString text = replacer.replaceAll(ProjectSearch::readFile(fileName, &codec), count);
+    if(*count == 0)
+        return true;
+
+    QFile file(fileName);
+    if(!file.open(QFile::WriteOnly | QFile::Truncate))
+        return false;
+    bool ok = file.write(codec->fromUnicode(text)) >= 0;
+    file.close();
+    return ok;
+}
+
+void ProjectFind::reject()
+{
+    search.stop();
+    QDialog::reject();
+}
@@ -0,0 +1,96 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROJECTFIND_H
+#define PROJECTFIND_H
+
+#include "qtversion.h"
+#include "projectsearch.h"
+#include "trigramindex.h"
+
+class Editor;
+
+/*
+ * Find and replace across every file in the project, and optionally
+ * the library folders it uses or the whole workspace. Results are listed per file as they
+ * arrive; activating one emits showMatch. Replace shows each changed
+ * line before anything is written. Open editors are searched and edited
+ * in place so unsaved changes are kept and replace can be undone there.
+ * With an index set, files it shows can't match are not read at all.
+ */
+class ProjectFind : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit ProjectFind(QWidget *parent = 0);
+
+    void setFiles(const QStringList &projectFiles, const QStringList &libraryFiles);
+    void setEditors(QTabWidget *tabs, QVector<Editor*> *editors);
+    void setFindText(const QString &text);
+    void setIndex(TrigramIndex *index);
+
+signals:
+    void showMatch(QString fileName, int line);
+
+public slots:
+    void find();
+    void stop();
+    void replace();
+    void reject();
+
+private slots:
+    void addHit(QString fileName, int line, int column, int length, QString text);
+    void searchDone(int files, int hits, qint64 ms);
+    void itemActivated(QTreeWidgetItem *item, int column);
+
+private:
+    QMap<QString,QPlainTextEdit*> openEditors();
+    bool    applyReplace(const QString &fileName, QPlainTextEdit *ed, int *count);
+
+    ProjectSearch   search;
+    TrigramIndex    *index;
+    QElapsedTimer   timer;
+    int             listed;
+    QStringList     projectFiles;
+    QStringList     libraryFiles;
+    QTabWidget      *editorTabs;
+    QVector<Editor*> *editors;
+    QHash<QString,QTreeWidgetItem*> fileItems;
+
+    /* options of the search shown in the list */
+    QString         pattern;
+    bool            regex;
+    bool            wholeWord;
+    bool            caseSensitive;
+
+    QLineEdit       *findEdit;
+    QLineEdit       *replaceEdit;
+    QCheckBox       *wordBox;
+    QCheckBox       *caseBox;
+    QCheckBox       *regexBox;
+    QCheckBox       *libraryBox;
+    QCheckBox       *workspaceBox;
+    QPushButton     *findBtn;
+    QPushButton     *stopBtn;
+    QPushButton     *replaceBtn;
+    QTreeWidget     *results;
+    QLabel          *summary;
+};
+
+#endif // PROJECTFIND_H
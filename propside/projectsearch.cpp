@@ -0,0 +1,217 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "projectsearch.h"
+#include "textreplacer.h"
+
+/* hits reported per file and per search */
+#define MAX_FILE_HITS   1000
+#define MAX_HITS        20000
+
+/*
+ * Scans one file on a pool thread.
+ */
+class ProjectSearchJob : public QRunnable
+{
+public:
+    ProjectSearchJob(ProjectSearch *search, QAtomicInt *current, int gen,
+                     const QString &fileName, const QString &text, bool haveText,
+                     const QString &pattern, bool regex, bool wholeWord, bool caseSensitive)
+        : search(search), current(current), gen(gen),
+          fileName(fileName), text(text), haveText(haveText),
+          pattern(pattern), regex(regex), wholeWord(wholeWord), caseSensitive(caseSensitive)
+    {
+    }
+
+    void run()
+    {
+        if(current->fetchAndAddRelaxed(0) == gen) {
+            scan();
+        }
+        QMetaObject::invokeMethod(search, "fileDone", Qt::QueuedConnection, Q_ARG(int, gen));
+    }
+
+private:
+    void scan()
+    {
+        if(!haveText)
+            text = ProjectSearch::readFile(fileName);
+
+        TextReplacer finder(pattern, QString(), regex, wholeWord, caseSensitive);
+        QList<TextReplacer::Match> list = finder.findAll(text, MAX_FILE_HITS);
+
+        const QChar *s = text.constData();
+        int line = 1;
+        int lineStart = 0;
+        int pos = 0;
+        foreach(const TextReplacer::Match &m, list) {
+            if(current->fetchAndAddRelaxed(0) != gen)
+                return;
+            for(; pos < m.start; pos++) {
+                if(s[pos] == QLatin1Char('\n')) {
+                    line++;
+                    lineStart = pos+1;
+                }
+            }
+            int lineEnd = text.indexOf(QLatin1Char('\n'), m.start);
+            if(lineEnd < 0)
+                lineEnd = text.length();
+            QString lineText = text.mid(lineStart, lineEnd-lineStart);
+            if(lineText.endsWith(QLatin1Char('\r')))
+                lineText.chop(1);
+            QMetaObject::invokeMethod(search, "addHit", Qt::QueuedConnection,
+                Q_ARG(int, gen), Q_ARG(QString, fileName), Q_ARG(int, line),
+                Q_ARG(int, m.start-lineStart), Q_ARG(int, m.length), Q_ARG(QString, lineText));
+        }
+    }
+
+    ProjectSearch *search;
+    QAtomicInt  *current;
+    int         gen;
+    QString     fileName;
+    QString     text;
+    bool        haveText;
+    QString     pattern;
+    bool        regex;
+    bool        wholeWord;
+    bool        caseSensitive;
+};
+
+ProjectSearch::ProjectSearch(QObject *parent) : QObject(parent)
+{
+    generation = 0;
+    pending = 0;
+    fileCount = 0;
+    hits = 0;
+    pool.setMaxThreadCount(qMax(QThread::idealThreadCount(), 2));
+}
+
+ProjectSearch::~ProjectSearch()
+{
+    current.fetchAndStoreRelaxed(-1);
+    pool.waitForDone();
+}
+
+/**
+ * Start searching. A search already running is stopped first.
+ * @param files full path of each file to search.
+ * @param openText text of files open in editors, searched instead of the disk copy.
+ */
+void ProjectSearch::start(const QStringList &files, const QMap<QString,QString> &openText,
+                          const QString &pattern, bool regex, bool wholeWord, bool caseSensitive)
+{
+    generation++;
+    current.fetchAndStoreRelaxed(generation);
+    pending = files.count();
+    fileCount = files.count();
+    hits = 0;
+    timer.start();
+
+    if(pending == 0) {
+        emit finished(0, 0, 0);
+        return;
+    }
+
+    foreach(const QString &fileName, files) {
+        bool open = openText.contains(fileName);
+        pool.start(new ProjectSearchJob(this, &current, generation, fileName,
+                openText.value(fileName), open, pattern, regex, wholeWord, caseSensitive));
+    }
+}
+
+/**
+ * Stop the current search. Queued jobs skip their files.
+ */
+void ProjectSearch::stop()
+{
+    if(pending > 0)
+        emit finished(fileCount-pending, hits, timer.elapsed());
+    generation++;
+    current.fetchAndStoreRelaxed(generation);
+    pending = 0;
+}
+
+bool ProjectSearch::isRunning()
+{
+    return pending > 0;
+}
+
+/*
+ * Decode file bytes as UTF-16 if they start with a byte order mark,
+ * else as UTF-8, or as Latin-1 if they aren't valid UTF-8.
+ */
+static QString decodeFile(const QByteArray &data, QTextCodec **codec)
+{
+    QTextCodec *utf8 = QTextCodec::codecForName("UTF-8");
+    QTextCodec *c = QTextCodec::codecForUtfText(data, utf8);
+    QTextCodec::ConverterState state;
+    QString text = c->toUnicode(data.constData(), data.length(), &state);
+    if(c == utf8 && state.invalidChars > 0) {
+        c = QTextCodec::codecForName("ISO-8859-1");
+        text = c->toUnicode(data);
+    }
+    if(codec)
+        *codec = c;
+    return text;
+}
+
+/**
+ * Read a whole file through a memory map.
+ * Falls back to a plain read if the file can't be mapped.
+ * @param codec if given, set to the encoding the file was read with,
+ *        so it can be written back the same way.
+ */
+QString ProjectSearch::readFile(const QString &fileName, QTextCodec **codec)
+{
+    if(codec)
+        *codec = QTextCodec::codecForName("UTF-8");
+
+    QFile file(fileName);
+    if(!file.open(QFile::ReadOnly))
+        return QString();
+
+    QString text;
+    qint64 size = file.size();
+    uchar *data = size > 0 ? file.map(0, size) : NULL;
+    if(data != NULL) {
+        text = decodeFile(QByteArray::fromRawData((const char *) data, (int) size), codec);
+        file.unmap(data);
+    }
+    else {
+        text = decodeFile(file.readAll(), codec);
+    }
+    file.close();
+    return text;
+}
+
+void ProjectSearch::addHit(int gen, QString fileName, int line, int column, int length, QString text)
+{
+    if(gen != generation || hits >= MAX_HITS)
+        return;
+    hits++;
+    emit found(fileName, line, column, length, text);
+}
+
+void ProjectSearch::fileDone(int gen)
+{
+    if(gen != generation || pending == 0)
+        return;
+    if(--pending == 0)
+        emit finished(fileCount, hits, timer.elapsed());
+}
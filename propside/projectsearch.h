@@ -0,0 +1,64 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROJECTSEARCH_H
+#define PROJECTSEARCH_H
+
+#include "qtversion.h"
+
+/*
+ * Searches a list of files on a thread pool.
+ * Each file is read through a memory map, or taken from the open editor
+ * text when one is given, and scanned with TextReplacer. Hits stream back
+ * to the GUI thread through found() as each file is scanned. Starting a
+ * new search drops results still queued from the last one.
+ */
+class ProjectSearch : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ProjectSearch(QObject *parent = 0);
+    ~ProjectSearch();
+
+    void start(const QStringList &files, const QMap<QString,QString> &openText,
+               const QString &pattern, bool regex, bool wholeWord, bool caseSensitive);
+    void stop();
+    bool isRunning();
+
+    static QString readFile(const QString &fileName, QTextCodec **codec = 0);
+
+signals:
+    void found(QString fileName, int line, int column, int length, QString text);
+    void finished(int files, int hits, qint64 ms);
+
+private slots:
+    void addHit(int gen, QString fileName, int line, int column, int length, QString text);
+    void fileDone(int gen);
+
+private:
+    QThreadPool     pool;
+    QAtomicInt      current;    // generation jobs compare against
+    int             generation;
+    int             pending;
+    int             fileCount;
+    int             hits;
+    QElapsedTimer   timer;
+};
+
+#endif // PROJECTSEARCH_H
@@ -1044,6 +1044,20 @@ void Properties::setupGeneral()
         loadDelay.setText(s);
     }
 
+    /* files this big open in the read-only viewer */
+    QLabel *lLargeFile = new QLabel(tr("Large File Viewer Size (KB)"),tbox);
+    tlayout->addWidget(lLargeFile,row,0);
+    largeFileSize.setMaximumWidth(60);
+    largeFileSize.setText("4096");
+    largeFileSize.setAlignment(Qt::AlignHCenter);
+    tlayout->addWidget(&largeFileSize,row++,1);
+
+    var = settings.value(largeFileSizeKey);
+    if(var.canConvert(QVariant::Int)) {
+        QString s = var.toString();
+        largeFileSize.setText(s);
+    }
+
     QLabel *lreset = new QLabel(tr("Reset Signal"),tbox);
     tlayout->addWidget(lreset,row,0);
     resetType.addItem("DTR");
@@ -1764,6 +1778,7 @@ void Properties::accept()
     //settings.setValue(autoLibIncludeKey,autoLibCheck.isChecked());
     settings.setValue(tabSpacesKey,tabSpaces.text());
     settings.setValue(loadDelayKey,loadDelay.text());
+    settings.setValue(largeFileSizeKey,largeFileSize.text());
     settings.setValue(resetTypeKey,resetType.currentIndex());
 
     settings.setValue(hlNumStyleKey,hlNumStyle.isChecked());
@@ -1810,6 +1825,7 @@ void Properties::reject()
     //autoLibCheck.setChecked(useAutoLib);
     tabSpaces.setText(tabSpacesStr);
     loadDelay.setText(loadDelayStr);
+    largeFileSize.setText(largeFileSizeStr);
     resetType.setCurrentIndex(resetTypeEnum);
     hlNumStyle.setChecked(hlNumStyleBool);
     hlNumWeight.setChecked(hlNumWeightBool);
@@ -1849,6 +1865,7 @@ void Properties::showProperties()
     useAutoLib = autoLibCheck.isChecked();
     tabSpacesStr = tabSpaces.text();
     loadDelayStr = loadDelay.text();
+    largeFileSizeStr = largeFileSize.text();
     resetTypeEnum = (Reset)resetType.currentIndex();
     hlNumStyleBool = hlNumStyle.isChecked();
     hlNumWeightBool = hlNumWeight.isChecked();
@@ -1887,6 +1904,16 @@ int Properties::getLoadDelay()
     return loadDelay.text().toInt();
 }
 
+/*
+ * Size in bytes at which files open in the viewer. Zero or less
+ * turns the viewer off.
+ */
+qint64 Properties::getLargeFileSize()
+{
+    qint64 kb = largeFileSize.text().toLongLong();
+    return kb > 0 ? kb*1024 : -1;
+}
+
 Properties::Reset Properties::getResetType()
 {
     return (Reset) resetType.currentIndex();
@@ -75,9 +75,11 @@
 #define recentProjectsKey   "SimpleIDE_recentProjectsList"
 #define tabSpacesKey        "SimpleIDE_TabSpacesCount"
 #define loadDelayKey        "SimpleIDE_LoadDelay_us"
+#define largeFileSizeKey    "SimpleIDE_LargeFileViewerKB"
 #define resetTypeKey        "SimpleIDE_ResetType"
 #define spinCompilerKey     "SimpleIDE_SpinCompiler"
 #define altTerminalKey      "SimpleIDE_AltTerminal"
+#define extraPortsKey       "SimpleIDE_ExtraPorts"
 #define hlEnableKey         "SimpleIDE_HighlightEnable"
 #define hlNumStyleKey       "SimpleIDE_HighlightNumberStyle"
 #define hlNumWeightKey      "SimpleIDE_HighlightNumberWeight"
@@ -112,6 +114,7 @@ public:
 
     int getTabSpaces();
     int getLoadDelay();
+    qint64 getLargeFileSize();
     int setComboIndexByValue(QComboBox *combo, QString value);
 
     Qt::GlobalColor getQtColor(int index);
@@ -194,6 +197,7 @@ private:
     
     QString     tabSpacesStr;
     QString     loadDelayStr;
+    QString     largeFileSizeStr;
     Reset       resetTypeEnum;
 
     bool        useAutoLib;
@@ -232,6 +236,7 @@ private:
 
     QLineEdit   tabSpaces;
     QLineEdit   loadDelay;
+    QLineEdit   largeFileSize;
     QComboBox   resetType;
     QCheckBox   keepZipFolder;
     QCheckBox   autoLibCheck;
@@ -62,6 +62,7 @@ DEFINES += ENABLE_FILETO_SDCARD
 SOURCES += mainspin.cpp \
     PortConnectionMonitor.cpp \
     PropellerID.cpp \
+    PropellerLoader.cpp \
     editor.cpp \
     ctags.cpp \
     mainspinwindow.cpp \
@@ -71,6 +72,9 @@ SOURCES += mainspin.cpp \
     projecttree.cpp \
     terminal.cpp \
     termprefs.cpp \
+    termbuffer.cpp \
+    termview.cpp \
+    consoledecoder.cpp \
     properties.cpp \
     newproject.cpp \
     PortListener.cpp \
@@ -103,10 +107,25 @@ SOURCES += mainspin.cpp \
     StatusDialog.cpp \
     workspacedialog.cpp \
     rescuedialog.cpp \
+    gangloaddialog.cpp \
+    termsessions.cpp \
+    scrollback.cpp \
+    termsearch.cpp \
+    termstats.cpp \
+    framedecoder.cpp \
+    telemetryplot.cpp \
+    telemetrydialog.cpp \
+    textreplacer.cpp \
+    projectsearch.cpp \
+    projectfind.cpp \
+    trigramindex.cpp \
+    fileviewer.cpp \
+    spinsymbols.cpp \
     xesp8266port.cpp
 HEADERS += mainspinwindow.h \
     PortConnectionMonitor.h \
     PropellerID.h \
+    PropellerLoader.h \
     editor.h \
     ctags.h \
     highlighter.h \
@@ -115,6 +134,9 @@ HEADERS += mainspinwindow.h \
     PortListener.h \
     terminal.h \
     termprefs.h \
+    termbuffer.h \
+    termview.h \
+    consoledecoder.h \
     properties.h \
     newproject.h \
     console.h \
@@ -153,6 +175,20 @@ HEADERS += mainspinwindow.h \
     StatusDialog.h \
     workspacedialog.h \
     rescuedialog.h \
+    gangloaddialog.h \
+    termsessions.h \
+    scrollback.h \
+    termsearch.h \
+    termstats.h \
+    framedecoder.h \
+    telemetryplot.h \
+    telemetrydialog.h \
+    textreplacer.h \
+    projectsearch.h \
+    projectfind.h \
+    trigramindex.h \
+    fileviewer.h \
+    spinsymbols.h \
     qtversion.h \
     xesp8266port.h
 FORMS += hardware.ui \
@@ -164,6 +200,7 @@ RESOURCES += resources.qrc
 # linux quazip doesn't need version, but windows does
 unix { 
     SOURCES += qextserialport_unix.cpp
+    SOURCES += qextserialport_baud.cpp
     LIBS += -lz
 }
 
@@ -154,6 +154,18 @@ void QextSerialPortPrivate::setBaudRate(BaudRateType baudRate, bool update)
             updatePortSettings();
         break;
     default:
+#if defined(Q_OS_LINUX) || defined(Q_OS_MAC) || defined(Q_OS_WIN)
+        /* Any other positive rate is programmed directly: termios2 on
+           Linux, IOSSIOSPEED on Mac, and the DCB takes it as-is on Windows.
+           Whether the UART can hit it is up to the adapter. */
+        if ((int)baudRate > 0) {
+            Settings.BaudRate=baudRate;
+            settingsDirtyFlags |= DFE_BaudRate;
+            if (update && q_func()->isOpen())
+                updatePortSettings();
+            break;
+        }
+#endif
         QESP_WARNING()<<"QextSerialPort does not support baudRate:"<<baudRate;
     }
 }
@@ -624,8 +636,31 @@ QextSerialPort::QueryMode QextSerialPort::queryMode() const
 */
 QByteArray QextSerialPort::readAll()
 {
+#ifdef Q_OS_UNIX
+    /*
+     * Drain the driver in large blocks rather than sizing one read from
+     * bytesAvailable(). At Mbaud rates FIONREAD lags the data still being
+     * moved out of the USB adapter, and the extra syscall per poll adds up.
+     * With VMIN 0 and a timeout under 100ms VTIME is 0 too, so a short read
+     * returns at once and means we're caught up.
+     */
+    enum { READ_CHUNK = 16384 };
+    QByteArray ba;
+    for (;;) {
+        int len = ba.length();
+        ba.resize(len + READ_CHUNK);
+        qint64 got = this->read(ba.data() + len, READ_CHUNK);
+        if (got < 0)
+            got = 0;
+        ba.resize(len + (int)got);
+        if (got < READ_CHUNK)
+            break;
+    }
+    return ba;
+#else
     int avail = this->bytesAvailable();
     return (avail > 0) ? this->read(avail) : QByteArray();
+#endif
 }
 
 /*!
@@ -728,6 +763,20 @@ unsigned long QextSerialPort::lineStatus()
     return 0;
 }
 
+/*!
+    Returns the driver's running count of receive overruns (UART FIFO and
+    tty buffer), or -1 if the port is closed or the platform doesn't keep
+    one. The count is cumulative, so callers should look at differences.
+*/
+qint64 QextSerialPort::overruns()
+{
+    Q_D(QextSerialPort);
+    QReadLocker locker(&d->lock);
+    if (isOpen())
+        return d->overruns_sys();
+    return -1;
+}
+
 /*!
   Returns a human-readable description of the last device error that occurred.
 */
@@ -203,6 +203,7 @@ public:
     ulong lastError() const;
 
     ulong lineStatus();
+    qint64 overruns();
     QString errorString();
 
 public Q_SLOTS:
@@ -0,0 +1,64 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Baud rates for the POSIX QextSerialPort backend that the Bxxx speed
+ * constants can't express.
+ *
+ * Linux needs struct termios2 from <asm/termbits.h>, which clashes with
+ * the <termios.h> used by qextserialport_unix.cpp, so this lives in its
+ * own translation unit. Mac OS X uses the IOSSIOSPEED ioctl instead.
+ */
+#include <errno.h>
+#include <sys/ioctl.h>
+#if defined(__linux__)
+#include <asm/termbits.h>
+#elif defined(__APPLE__)
+#include <termios.h>
+#include <IOKit/serial/ioss.h>
+#endif
+
+/**
+ * Program an arbitrary baud rate on an open port.
+ * This must be called after tcsetattr() since that rewrites the speed.
+ * @param fd is the open serial port descriptor.
+ * @param baud is the rate in bits per second.
+ * @returns 0 on success or -1 with errno set.
+ */
+int qextSetCustomBaudRate(int fd, int baud)
+{
+#if defined(__linux__) && defined(BOTHER)
+    struct termios2 tio;
+    if(::ioctl(fd, TCGETS2, &tio) == -1)
+        return -1;
+    tio.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+    tio.c_cflag |= BOTHER | (BOTHER << IBSHIFT);
+    tio.c_ispeed = baud;
+    tio.c_ospeed = baud;
+    return ::ioctl(fd, TCSETS2, &tio);
+#elif defined(__APPLE__) && defined(IOSSIOSPEED)
+    speed_t speed = baud;
+    return ::ioctl(fd, IOSSIOSPEED, &speed);
+#else
+    (void) fd;
+    (void) baud;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
@@ -191,6 +191,7 @@ public:
     QSocketNotifier *readNotifier;
     struct termios Posix_CommConfig;
     struct termios old_termios;
+    bool customBaud;
 #elif (defined Q_OS_WIN)
     HANDLE Win_Handle;
     OVERLAPPED overlap;
@@ -229,6 +230,7 @@ public:
     bool close_sys();
     bool flush_sys();
     ulong lineStatus_sys();
+    qint64 overruns_sys();
     qint64 bytesAvailable_sys() const;
 
 #ifdef Q_OS_WIN
@@ -239,4 +241,9 @@ public:
     QextSerialPort * q_ptr;
 };
 
+#ifdef Q_OS_UNIX
+/* qextserialport_baud.cpp - rates with no Bxxx constant */
+int qextSetCustomBaudRate(int fd, int baud);
+#endif
+
 #endif //_QEXTSERIALPORT_P_H_
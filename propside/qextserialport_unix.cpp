@@ -38,6 +38,9 @@
 #include <sys/time.h>
 #include <sys/ioctl.h>
 #include <sys/select.h>
+#ifdef Q_OS_LINUX
+#include <linux/serial.h>
+#endif
 #include <QtCore/QMutexLocker>
 #include <QtCore/QDebug>
 #include <QtCore/QSocketNotifier>
@@ -46,6 +49,7 @@ void QextSerialPortPrivate::platformSpecificInit()
 {
     fd = 0;
     readNotifier = 0;
+    customBaud = false;
 }
 
 /*!
@@ -199,6 +203,18 @@ unsigned long QextSerialPortPrivate::lineStatus_sys()
     return Status;
 }
 
+qint64 QextSerialPortPrivate::overruns_sys()
+{
+#if defined(Q_OS_LINUX) && defined(TIOCGICOUNT)
+    struct serial_icounter_struct icount;
+    if (::ioctl(fd, TIOCGICOUNT, &icount) == -1)
+        return -1;
+    return (qint64)icount.overrun + icount.buf_overrun;
+#else
+    return -1;
+#endif
+}
+
 /*!
     Reads a block of data from the serial port.  This function will read at most maxSize bytes from
     the serial port and place them in the buffer pointed to by data.  Return value is the number of
@@ -253,6 +269,7 @@ void QextSerialPortPrivate::updatePortSettings()
         return;
 
     if (settingsDirtyFlags & DFE_BaudRate) {
+        customBaud = false;
         switch (Settings.BaudRate) {
         case BAUD50:
             setBaudRate2Termios(&Posix_CommConfig, B50);
@@ -351,6 +368,10 @@ void QextSerialPortPrivate::updatePortSettings()
             setBaudRate2Termios(&Posix_CommConfig, B4000000);
             break;
 #endif
+        default:
+            /* set after tcsetattr() below, which would overwrite it */
+            customBaud = true;
+            break;
         }
     }
     if (settingsDirtyFlags & DFE_Parity) {
@@ -437,8 +458,13 @@ void QextSerialPortPrivate::updatePortSettings()
     }
 
     /*if any thing in Posix_CommConfig changed, flush*/
-    if (settingsDirtyFlags & DFE_Settings_Mask)
+    if (settingsDirtyFlags & DFE_Settings_Mask) {
         ::tcsetattr(fd, TCSAFLUSH, &Posix_CommConfig);
+        if (customBaud && qextSetCustomBaudRate(fd, Settings.BaudRate) == -1) {
+            QESP_WARNING()<<"QextSerialPort can't set baudRate:"<<Settings.BaudRate;
+            translateError(errno);
+        }
+    }
 
     if (settingsDirtyFlags & DFE_TimeOut) {
         int millisec = Settings.Timeout_Millisec;
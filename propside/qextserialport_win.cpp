@@ -285,6 +285,14 @@ ulong QextSerialPortPrivate::lineStatus_sys(void) {
     return Status;
 }
 
+/*
+  ClearCommError() only reports that an overrun happened, not how many.
+*/
+qint64 QextSerialPortPrivate::overruns_sys()
+{
+    return -1;
+}
+
 /*
   Triggered when there's activity on our HANDLE.
 */
@@ -26,8 +26,9 @@
 
 #include <QMargins>
 #include "replacedialog.h"
+#include "textreplacer.h"
 
-#define USE_REGEX 0
+#define USE_REGEX 1
 
 ReplaceDialog::ReplaceDialog(QWidget *parent) : QDialog(parent)
 {
@@ -81,7 +82,8 @@ ReplaceDialog::ReplaceDialog(QWidget *parent) : QDialog(parent)
 #if USE_REGEX
     regexButton = new QToolButton(this);
     regexButton->setToolTip(tr("RegEx Function"));
-    regexButton->setIcon(QIcon(":/images/dotstar.png"));
+    regexButton->setText(".*");
+    regexButton->setMinimumWidth(bwd);
     regexButton->setCheckable(true);
 #endif
 
@@ -154,6 +156,17 @@ QTextDocument::FindFlag ReplaceDialog::getFlags(int prev)
     return (QTextDocument::FindFlag) flags;
 }
 
+/*
+ * Select a match found by TextReplacer.
+ */
+static void selectMatch(QPlainTextEdit *editor, const TextReplacer::Match &m)
+{
+    QTextCursor cur = editor->textCursor();
+    cur.setPosition(m.start);
+    cur.setPosition(m.start+m.length, QTextCursor::KeepAnchor);
+    editor->setTextCursor(cur);
+}
+
 void ReplaceDialog::setFindHighlight(QPlainTextEdit *ed)
 {
     if (ed != NULL) {
@@ -180,13 +193,11 @@ void ReplaceDialog::findChanged(QString text)
 
 #if USE_REGEX
     if(regexButton->isChecked()) {
-        QRegExp reg(text);
-        reg.setPatternSyntax(QRegExp::RegExp2);
-        QTextDocument *ted = const_cast<QTextDocument *>(editor->document());
-        cur.beginEditBlock();
-        cur = ted->find(reg,findPosition,getFlags());
-        editor->setTextCursor(cur);
-        cur.endEditBlock();
+        TextReplacer finder(text, QString(), true,
+                            wholeWordButton->isChecked(), caseSensitiveButton->isChecked());
+        TextReplacer::Match m;
+        if(finder.findNext(editor->toPlainText(), findPosition, false, m))
+            selectMatch(editor, m);
     }
     else
     {
@@ -225,41 +236,26 @@ void ReplaceDialog::findNextClicked()
 
 #if USE_REGEX
     if(regexButton->isChecked()) {
-        QRegExp reg(text);
-        QTextDocument *ted = const_cast<QTextDocument *>(editor->document());
-        QTextCursor cur = ted->find(reg,findPosition,getFlags());
-        if(cur.hasSelection()) {
-            count++;
-        }
-        else {
-            if(showBeginMessage(tr("Find"))) {
-                QTextCursor cur = ted->find(reg,findPosition,getFlags());
-                if(cur.hasSelection()) {
-                    count++;
-                }
-            }
-        }
-        editor->setTextCursor(cur);
+        if(findRegex(false))
+            findPosition = editor->textCursor().position();
+        return;
     }
-    else
 #endif
-    {
-        if(editor->find(text,getFlags()) == true) {
-            /*
-            QTextCursor cur = editor->textCursor();
-            QTextCharFormat fmt;
-            QBrush findBrush(Qt::yellow);
-            fmt.setBackground(findBrush);
-            cur.mergeCharFormat(fmt);
-            cur.movePosition(QTextCursor::StartOfWord);
-            */
-            count++;
-        }
-        else {
-            if(showBeginMessage(tr("Find"))) {
-                if(editor->find(text,getFlags()) == true) {
-                    count++;
-                }
+    if(editor->find(text,getFlags()) == true) {
+        /*
+        QTextCursor cur = editor->textCursor();
+        QTextCharFormat fmt;
+        QBrush findBrush(Qt::yellow);
+        fmt.setBackground(findBrush);
+        cur.mergeCharFormat(fmt);
+        cur.movePosition(QTextCursor::StartOfWord);
+        */
+        count++;
+    }
+    else {
+        if(showBeginMessage(tr("Find"))) {
+            if(editor->find(text,getFlags()) == true) {
+                count++;
             }
         }
     }
@@ -283,37 +279,22 @@ void ReplaceDialog::findPrevClicked()
 
 #if USE_REGEX
     if(regexButton->isChecked()) {
-        QRegExp reg(text);
-        QTextDocument *ted = const_cast<QTextDocument *>(editor->document());
-        QTextCursor cur = ted->find(reg,findPosition,getFlags(QTextDocument::FindBackward));
-        if(cur.hasSelection()) {
+        if(findRegex(true))
+            findPosition = editor->textCursor().position();
+        return;
+    }
+#endif
+    if(edtext.contains(text,Qt::CaseInsensitive)) {
+        if(editor->find(text,getFlags(QTextDocument::FindBackward)) == true) {
             count++;
         }
         else {
-            if(showBeginMessage(tr("Find"))) {
-                QTextCursor cur = ted->find(reg,findPosition,getFlags(QTextDocument::FindBackward));
-                if(cur.hasSelection()) {
+            if(showEndMessage(tr("Find"))) {
+                if(editor->find(text,getFlags(QTextDocument::FindBackward)) == true) {
                     count++;
                 }
             }
         }
-        editor->setTextCursor(cur);
-    }
-    else
-#endif
-    {
-        if(edtext.contains(text,Qt::CaseInsensitive)) {
-            if(editor->find(text,getFlags(QTextDocument::FindBackward)) == true) {
-                count++;
-            }
-            else {
-                if(showEndMessage(tr("Find"))) {
-                    if(editor->find(text,getFlags(QTextDocument::FindBackward)) == true) {
-                        count++;
-                    }
-                }
-            }
-        }
     }
 
     if(count > 0) {
@@ -359,6 +340,14 @@ void ReplaceDialog::replaceNextClicked()
     if(editor == NULL)
         return;
 
+#if USE_REGEX
+    if(regexButton->isChecked()) {
+        if(replaceRegex(false))
+            findNextClicked();
+        return;
+    }
+#endif
+
     QString s = editor->textCursor().selectedText();
     if(s.length()) {
         QTextCursor cur = editor->textCursor();
@@ -378,6 +367,14 @@ void ReplaceDialog::replacePrevClicked()
     if(editor == NULL)
         return;
 
+#if USE_REGEX
+    if(regexButton->isChecked()) {
+        if(replaceRegex(true))
+            findPrevClicked();
+        return;
+    }
+#endif
+
     QString s = editor->textCursor().selectedText();
     if(s.length()) {
         QTextCursor cur = editor->textCursor();
@@ -394,41 +391,99 @@ void ReplaceDialog::replacePrevClicked()
 
 void ReplaceDialog::replaceAllClicked()
 {
-    int count = 0;
     QString text = findEdit->text();
     if(editor == NULL)
         return;
 
-    editor->textCursor().beginEditBlock();
-    QString edtext = editor->toPlainText();
+    bool regex = false;
+#if USE_REGEX
+    regex = regexButton->isChecked();
+#endif
+
+    /* find every match in one pass and replace them as one undo step */
+    TextReplacer replacer(text, replaceEdit->text(), regex,
+                          wholeWordButton->isChecked(), caseSensitiveButton->isChecked());
+    if(!replacer.isValid()) {
+        QMessageBox::information(this, tr("Replace"), replacer.errorString());
+        return;
+    }
+
     editor->setCenterOnScroll(true);
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    int count = replacer.replaceAll(editor->document());
+    QApplication::restoreOverrideCursor();
 
-    QString s = editor->textCursor().selectedText();
-    if(s.length()>0) {
-        editor->textCursor().removeSelectedText();
-        editor->textCursor().insertText(replaceEdit->text());
-        count++;
+    QMessageBox::information(this, tr("Replace Done"),
+        tr("Replaced %1 instances of \"%2\".").arg(count).arg(text));
+
+    okButton->setFocus(); // focus back to find
+}
+
+/*
+ * Regex Find goes through TextReplacer so it matches the way Replace All
+ * does. An empty match at the cursor is passed over going forward, or
+ * Find Next would never move.
+ */
+bool ReplaceDialog::findRegex(bool backward)
+{
+    TextReplacer finder(findEdit->text(), replaceEdit->text(), true,
+                        wholeWordButton->isChecked(), caseSensitiveButton->isChecked());
+    if(!finder.isValid()) {
+        QMessageBox::information(this, tr("Find"), finder.errorString());
+        return false;
     }
-    while(edtext.contains(text,Qt::CaseInsensitive)) {
-        editor->find(text,getFlags());
-        s = editor->textCursor().selectedText();
-        if(s.length()>0) {
-            editor->textCursor().removeSelectedText();
-            editor->textCursor().insertText(replaceEdit->text());
-            count++;
+
+    QString text = editor->toPlainText();
+    QTextCursor cur = editor->textCursor();
+    int from = backward ? cur.selectionStart() : cur.selectionEnd();
+    TextReplacer::Match m;
+    bool found = finder.findNext(text, from, backward, m);
+    if(found && !backward && m.length == 0 && m.start == from && !cur.hasSelection())
+        found = finder.findNext(text, from+1, backward, m);
+
+    if(!found) {
+        if(backward) {
+            if(!showEndMessage(tr("Find")))
+                return false;
+            found = finder.findNext(text, text.length(), backward, m);
         }
         else {
-            if(showBeginMessage(tr("Replace")) == false)
-                break;
+            if(!showBeginMessage(tr("Find")))
+                return false;
+            found = finder.findNext(text, 0, backward, m);
         }
-        edtext = editor->toPlainText();
     }
-    editor->textCursor().endEditBlock();
+    if(found)
+        selectMatch(editor, m);
+    return found;
+}
 
-    QMessageBox::information(this, tr("Replace Done"),
-        tr("Replaced %1 instances of \"%2\".").arg(count).arg(text));
+/*
+ * Replace the selection if it is a match, expanding \0 to \9 from it.
+ * The cursor is left after the new text, or before it going backward.
+ */
+bool ReplaceDialog::replaceRegex(bool backward)
+{
+    TextReplacer replacer(findEdit->text(), replaceEdit->text(), true,
+                          wholeWordButton->isChecked(), caseSensitiveButton->isChecked());
+    QTextCursor cur = editor->textCursor();
+    if(!replacer.isValid() || !cur.hasSelection())
+        return false;
 
-    okButton->setFocus(); // focus back to find
+    int start = cur.selectionStart();
+    TextReplacer::Match m;
+    if(!replacer.findNext(editor->toPlainText(), start, false, m))
+        return false;
+    if(m.start != start || m.length != cur.selectionEnd()-start)
+        return false;
+
+    cur.beginEditBlock();
+    cur.insertText(m.text);
+    cur.endEditBlock();
+    if(backward)
+        cur.setPosition(start);
+    editor->setTextCursor(cur);
+    return true;
 }
 
 QString ReplaceDialog::getReplaceText()
@@ -60,6 +60,9 @@ public slots:
     void replaceAllClicked();
 
 private:
+    bool findRegex(bool backward);
+    bool replaceRegex(bool backward);
+
     QPlainTextEdit *editor;
 
     QToolButton *findNextButton;
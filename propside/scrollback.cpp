@@ -0,0 +1,260 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scrollback.h"
+
+/* newest text kept in memory before older lines go to disk */
+#define SCROLLBACK_TAIL_LIMIT   (8*1024*1024)
+/* bytes scanned per pass by search() */
+#define SCROLLBACK_SCAN_BLOCK   (4*1024*1024)
+
+ScrollBack::ScrollBack()
+{
+    file = NULL;
+    fileBytes = 0;
+    crPending = false;
+    lineOpen = false;
+}
+
+ScrollBack::~ScrollBack()
+{
+    clear();
+}
+
+void ScrollBack::clear()
+{
+    QMutexLocker locker(&lock);
+    if(file != NULL) {
+        file->close();
+        delete file;
+        file = NULL;
+    }
+    starts.clear();
+    tail.clear();
+    fileBytes = 0;
+    crPending = false;
+    lineOpen = false;
+}
+
+/*
+ * Add received bytes. CR, LF and CR LF end a line; other control
+ * characters are terminal commands and are not kept.
+ */
+void ScrollBack::append(const QByteArray &data)
+{
+    QMutexLocker locker(&lock);
+    const char *s = data.constData();
+    int len = data.length();
+    int n = 0;
+
+    while(n < len) {
+        uchar c = (uchar) s[n];
+        if(crPending) {
+            crPending = false;
+            if(c == '\n') {
+                n++;
+                continue;
+            }
+        }
+        if(c == '\r' || c == '\n') {
+            endLine();
+            crPending = (c == '\r');
+            n++;
+            continue;
+        }
+        if(c < ' ' && c != '\t') {
+            n++;
+            continue;
+        }
+        /* copy a run of ordinary text in one go */
+        int end = n+1;
+        while(end < len && ((uchar) s[end] >= ' ' || s[end] == '\t'))
+            end++;
+        if(!lineOpen) {
+            starts.append(fileBytes + tail.length());
+            lineOpen = true;
+        }
+        tail.append(s+n, end-n);
+        n = end;
+    }
+
+    if(tail.length() > SCROLLBACK_TAIL_LIMIT)
+        spill();
+}
+
+void ScrollBack::endLine()
+{
+    if(!lineOpen)
+        starts.append(fileBytes + tail.length());
+    tail.append('\n');
+    lineOpen = false;
+}
+
+/*
+ * Move the complete lines in the tail to the temporary file.
+ */
+void ScrollBack::spill()
+{
+    int keep = tail.lastIndexOf('\n') + 1;
+    if(keep < 1)
+        return;
+    if(file == NULL) {
+        file = new QTemporaryFile(QDir::tempPath()+"/scrollback-XXXXXX");
+        if(!file->open(QIODevice::ReadWrite)) {
+            delete file;
+            file = NULL;
+            return;
+        }
+    }
+    file->seek(fileBytes);
+    if(file->write(tail.constData(), keep) != keep)
+        return;
+    fileBytes += keep;
+    tail.remove(0, keep);
+}
+
+QByteArray ScrollBack::bytes(qint64 start, qint64 end)
+{
+    QByteArray ba;
+    if(start < fileBytes && file != NULL) {
+        qint64 fend = (end < fileBytes) ? end : fileBytes;
+        file->seek(start);
+        ba = file->read(fend - start);
+        start = fend;
+    }
+    if(end > start)
+        ba.append(tail.mid(int(start - fileBytes), int(end - start)));
+    return ba;
+}
+
+int ScrollBack::lineAt(qint64 offset)
+{
+    return int(qUpperBound(starts.begin(), starts.end(), offset) - starts.begin()) - 1;
+}
+
+int ScrollBack::lineCount()
+{
+    QMutexLocker locker(&lock);
+    return starts.count();
+}
+
+/*
+ * Return the number of the line that the next received text goes on.
+ */
+int ScrollBack::currentLine()
+{
+    QMutexLocker locker(&lock);
+    return lineOpen ? starts.count()-1 : starts.count();
+}
+
+QString ScrollBack::line(int n)
+{
+    QMutexLocker locker(&lock);
+    if(n < 0 || n >= starts.count())
+        return QString();
+    qint64 end = (n+1 < starts.count()) ? starts[n+1] : fileBytes + tail.length();
+    QByteArray ba = bytes(starts[n], end);
+    if(ba.endsWith('\n'))
+        ba.chop(1);
+    return QString::fromUtf8(ba.constData(), ba.length());
+}
+
+/*
+ * Return the numbers of lines matching pattern, oldest first.
+ * The store is read in blocks of whole lines; plain text is matched on
+ * the raw bytes and only regular expressions decode each line.
+ * The lock is only held while a block is copied out, so append() isn't
+ * held up by the scan. If current is given the search gives up as soon
+ * as it no longer holds gen.
+ */
+QList<int> ScrollBack::search(const QString &pattern, bool regex, bool caseSensitive, int maxHits,
+            QAtomicInt *current, int gen)
+{
+    QList<int> hits;
+    if(pattern.isEmpty())
+        return hits;
+
+    lock.lock();
+    int count = starts.count();
+    qint64 total = fileBytes + tail.length();
+    lock.unlock();
+
+    int first = 0;
+    while(first < count && hits.count() < maxHits) {
+        if(current != NULL && current->fetchAndAddRelaxed(0) != gen)
+            break;
+        lock.lock();
+        if(count > starts.count()) {
+            /* cleared meanwhile */
+            lock.unlock();
+            break;
+        }
+        int last = qMin(lineAt(starts[first] + SCROLLBACK_SCAN_BLOCK), count-1);
+        if(last < first)
+            last = first;
+        qint64 base = starts[first];
+        qint64 end = (last+1 < count) ? starts[last+1] : total;
+        QByteArray block = bytes(base, end);
+        QVector<int> at(last-first+1);
+        for(int n = first; n <= last; n++)
+            at[n-first] = int(starts[n] - base);
+        lock.unlock();
+        scanBlock(block, at, first, pattern, regex, caseSensitive, maxHits, hits);
+        first = last+1;
+    }
+    return hits;
+}
+
+/*
+ * Scan one block of whole lines. at holds the offset of each line in
+ * the block, and first is the number of the block's first line.
+ */
+void ScrollBack::scanBlock(const QByteArray &block, const QVector<int> &at, int first,
+            const QString &pattern, bool regex, bool caseSensitive, int maxHits, QList<int> &hits)
+{
+    int count = at.count();
+    if(regex) {
+        QRegExp rx(pattern, caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive, QRegExp::RegExp2);
+        for(int n = 0; n < count && hits.count() < maxHits; n++) {
+            int a = at[n];
+            int b = (n+1 < count) ? at[n+1] : block.length();
+            QString text = QString::fromUtf8(block.constData()+a, b-a);
+            if(rx.indexIn(text) > -1)
+                hits.append(first+n);
+        }
+        return;
+    }
+
+    QByteArray pat = pattern.toUtf8();
+    QByteArray text = block;
+    if(!caseSensitive) {
+        pat = pat.toLower();
+        text = text.toLower();
+    }
+    QByteArrayMatcher matcher(pat);
+    int pos = matcher.indexIn(text, 0);
+    while(pos > -1 && hits.count() < maxHits) {
+        int n = int(qUpperBound(at.begin(), at.end(), pos) - at.begin()) - 1;
+        hits.append(first+n);
+        if(n+1 >= count)
+            break;
+        /* one hit per line */
+        pos = matcher.indexIn(text, at[n+1]);
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCROLLBACK_H
+#define SCROLLBACK_H
+
+#include "qtversion.h"
+
+/*
+ * Terminal history kept outside the console document.
+ * Received text is stored one line per '\n' with a line start index
+ * that grows as data arrives. Once the in-memory tail passes a limit the
+ * older lines are moved to a temporary file, so hours of output cost a
+ * few bytes of index per line. search() scans the raw bytes in large
+ * blocks, so a substring lookup over millions of lines stays fast.
+ * search() may run on another thread while data is appended; it covers
+ * the lines present when it starts.
+ */
+class ScrollBack
+{
+public:
+    ScrollBack();
+    ~ScrollBack();
+
+    void append(const QByteArray &data);
+    void clear();
+
+    int     lineCount();
+    int     currentLine();
+    QString line(int n);
+    QList<int> search(const QString &pattern, bool regex, bool caseSensitive, int maxHits = 10000,
+                QAtomicInt *current = 0, int gen = 0);
+
+private:
+    void    endLine();
+    void    spill();
+    QByteArray bytes(qint64 start, qint64 end);
+    int     lineAt(qint64 offset);
+    void    scanBlock(const QByteArray &block, const QVector<int> &at, int first,
+                const QString &pattern, bool regex, bool caseSensitive, int maxHits, QList<int> &hits);
+
+    QVector<qint64> starts;     // offset of each line in the whole store
+    QByteArray  tail;           // newest lines, from offset fileBytes on
+    QFile       *file;          // oldest lines, if spilled
+    qint64      fileBytes;
+    bool        crPending;      // CR seen, LF may follow
+    bool        lineOpen;       // last line has no '\n' yet
+    QMutex      lock;           // search() reads from another thread
+};
+
+#endif // SCROLLBACK_H
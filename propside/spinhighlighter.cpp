@@ -25,10 +25,27 @@
 
 #include "spinhighlighter.h"
 
+/* lexer layers in the order the rules below are applied */
+enum {
+    LayerNone = 0,
+    LayerQuote,
+    LayerNumber,
+    LayerFunction,
+    LayerKeyword,
+    LayerPreProc,
+    LayerLineComment,
+    LayerBlockComment,
+    LayerCount
+};
+
+/* word value flag for keywords that need a trailing # */
+#define SHARP_SUFFIX 0x100
+
 SpinHighlighter::SpinHighlighter(QTextDocument *parent, Properties *prop)
     : Highlighter(parent, prop)
 {
     highlight();
+    startFill();
 }
 
 /*
@@ -72,223 +89,232 @@ void SpinHighlighter::highlight()
     keywordFormat.setForeground(hlKeyWordColor);
     keywordFormat.setFontWeight(hlKeyWordWeight);
     keywordFormat.setFontItalic(hlKeyWordStyle);
-    QStringList keywordPatterns;
+    QStringList keywords;
     /*
      * add spin patterns later
      */
+    keywords
+            << "_CLKFREQ"
+            << "_CLKMODE"
+            << "_FREE"
+            << "_STACK"
+            << "_XINFREQ"
+            << "ABORT"
+            << "ABS"
+            << "ABSNEG"
+            << "ADD"
+            << "ADDABS"
+            << "ADDS"
+            << "ADDSX"
+            << "ADDX"
+            << "AND"
+            << "ANDN"
+            << "BYTE"
+            << "BYTEFILL"
+            << "BYTEMOVE"
+            << "CALL"
+            << "CASE"
+            << "CHIPVER"
+            << "CLKFREQ"
+            << "CLKMODE"
+            << "CLKSET"
+            << "CMP"
+            << "CMPS"
+            << "CMPSUB"
+            << "CMPSX"
+            << "CMPX"
+            << "CNT"
+            << "COGID"
+            << "COGINIT"
+            << "COGNEW"
+            << "COGSTOP"
+            << "CON"
+            << "CONSTANT"
+            << "CTRA"
+            << "CTRB"
+            << "DAT"
+            << "DIRA"
+            << "DJNZ"
+            << "ELSE"
+            << "ELSEIF"
+            << "ELSEIFNOT"
+            << "FALSE"
+            << "FILE"
+            << "FIT"
+            << "FLOAT"
+            << "FROM"
+            << "FRQA"
+            << "FRQB"
+            << "HUBOP"
+            << "IF"
+            << "IFNOT"
+            << "IF_A"
+            << "IF_AE"
+            << "IF_ALWAYS"
+            << "IF_B"
+            << "IF_BE"
+            << "IF_C"
+            << "IF_C_AND_NZ"
+            << "IF_C_AND_Z"
+            << "IF_C_EQ_Z"
+            << "IF_C_NE_Z"
+            << "IF_C_OR_NZ"
+            << "IF_C_OR_Z"
+            << "IF_E"
+            << "IF_NC"
+            << "IF_NC_AND_NZ"
+            << "IF_NC_AND_Z"
+            << "IF_NC_OR_NZ"
+            << "IF_NC_OR_Z"
+            << "IF_NE"
+            << "IF_NEVER"
+            << "IF_NZ"
+            << "IF_NZ_AND_C"
+            << "IF_NZ_AND_NC"
+            << "IF_NZ_OR_C"
+            << "IF_NZ_OR_NC"
+            << "IF_Z"
+            << "IF_Z_AND_C"
+            << "IF_Z_AND_NC"
+            << "IF_Z_EQ_C"
+            << "IF_Z_NE_C"
+            << "IF_Z_OR_C"
+            << "IF_Z_OR_NC"
+            << "INA"
+            << "JMP"
+            << "JMPRET"
+            << "LOCKCLR"
+            << "LOCKNEW"
+            << "LOCKRET"
+            << "LOCKSET"
+            << "LONG"
+            << "LONGFILL"
+            << "LONGMOVE"
+            << "LOOKDOWN"
+            << "LOOKDOWNZ"
+            << "LOOKUP"
+            << "LOOKUPZ"
+            << "MAX"
+            << "MAXS"
+            << "MIN"
+            << "MINS"
+            << "MOV"
+            << "MOVD"
+            << "MOVI"
+            << "MOVS"
+            << "MUXC"
+            << "MUXNC"
+            << "MUXNZ"
+            << "MUXZ"
+            << "NEG"
+            << "NEGC"
+            << "NEGNC"
+            << "NEGNZ"
+            << "NEGX"
+            << "NEGZ"
+            << "NEXT"
+            << "NOP"
+            << "NOT"
+            << "NR"
+            << "OBJ"
+            << "OR"
+            << "ORG"
+            << "OTHER"
+            << "OUTA"
+            << "PAR"
+            << "PHSA"
+            << "PHSB"
+            << "PI"
+            << "PLL1X"
+            << "PLL2X"
+            << "PLL4X"
+            << "PLL8X"
+            << "PLL16X"
+            << "POSX"
+            << "PRI"
+            << "PUB"
+            << "QUIT"
+            << "RCFAST"
+            << "RCL"
+            << "RCR"
+            << "RCSLOW"
+            << "RDBYTE"
+            << "RDLONG"
+            << "RDWORD"
+            << "REBOOT"
+            << "REPEAT"
+            << "RES"
+            << "RESULT"
+            << "RET"
+            << "RETURN"
+            << "REV"
+            << "ROL"
+            << "ROR"
+            << "ROUND"
+            << "SAR"
+            << "SHL"
+            << "SHR"
+            << "SPR"
+            << "STEP"
+            << "STRCOMP"
+            << "STRING"
+            << "STRSIZE"
+            << "SUB"
+            << "SUBABS"
+            << "SUBS"
+            << "SUBSX"
+            << "SUBX"
+            << "SUMC"
+            << "SUMNC"
+            << "SUMNZ"
+            << "SUMZ"
+            << "TEST"
+            << "TESTN"
+            << "TJNZ"
+            << "TJZ"
+            << "TO"
+            << "TRUE"
+            << "TRUNC"
+            << "UNTIL"
+            << "VAR"
+            << "VCFG"
+            << "VSCL"
+            << "WAITCNT"
+            << "WAITPEQ"
+            << "WAITPNE"
+            << "WAITVID"
+            << "WC"
+            << "WHILE"
+            << "WORD"
+            << "WORDFILL"
+            << "WORDMOVE"
+            << "WR"
+            << "WRBYTE"
+            << "WRLONG"
+            << "WRWORD"
+            << "WZ"
+            << "XINPUT"
+            << "XOR"
+            << "XTAL1"
+            << "XTAL2"
+            << "XTAL3"
+            ;
+    QStringList sharpKeywords;
+    sharpKeywords
+            << "DIRB"
+            << "ENC"
+            << "INB"
+            << "MUL"
+            << "MULS"
+            << "ONES"
+            << "OUTB"
+            ;
+    QStringList keywordPatterns;
+    foreach (const QString &keyword, keywords)
+        keywordPatterns << "\\b"+keyword+"\\b";
+    foreach (const QString &keyword, sharpKeywords)
+        keywordPatterns << "\\b"+keyword+"#\\b";
     keywordPatterns
-            << "\\b_CLKFREQ\\b"
-            << "\\b_CLKMODE\\b"
-            << "\\b_FREE\\b"
-            << "\\b_STACK\\b"
-            << "\\b_XINFREQ\\b"
-            << "\\bABORT\\b"
-            << "\\bABS\\b"
-            << "\\bABSNEG\\b"
-            << "\\bADD\\b"
-            << "\\bADDABS\\b"
-            << "\\bADDS\\b"
-            << "\\bADDSX\\b"
-            << "\\bADDX\\b"
-            << "\\bAND\\b"
-            << "\\bANDN\\b"
-            << "\\bBYTE\\b"
-            << "\\bBYTEFILL\\b"
-            << "\\bBYTEMOVE\\b"
-            << "\\bCALL\\b"
-            << "\\bCASE\\b"
-            << "\\bCHIPVER\\b"
-            << "\\bCLKFREQ\\b"
-            << "\\bCLKMODE\\b"
-            << "\\bCLKSET\\b"
-            << "\\bCMP\\b"
-            << "\\bCMPS\\b"
-            << "\\bCMPSUB\\b"
-            << "\\bCMPSX\\b"
-            << "\\bCMPX\\b"
-            << "\\bCNT\\b"
-            << "\\bCOGID\\b"
-            << "\\bCOGINIT\\b"
-            << "\\bCOGNEW\\b"
-            << "\\bCOGSTOP\\b"
-            << "\\bCON\\b"
-            << "\\bCONSTANT\\b"
-            << "\\bCTRA\\b"
-            << "\\bCTRB\\b"
-            << "\\bDAT\\b"
-            << "\\bDIRA\\b"
-            << "\\bDIRB#\\b"
-            << "\\bDJNZ\\b"
-            << "\\bELSE\\b"
-            << "\\bELSEIF\\b"
-            << "\\bELSEIFNOT\\b"
-            << "\\bENC#\\b"
-            << "\\bFALSE\\b"
-            << "\\bFILE\\b"
-            << "\\bFIT\\b"
-            << "\\bFLOAT\\b"
-            << "\\bFROM\\b"
-            << "\\bFRQA\\b"
-            << "\\bFRQB\\b"
-            << "\\bHUBOP\\b"
-            << "\\bIF\\b"
-            << "\\bIFNOT\\b"
-            << "\\bIF_A\\b"
-            << "\\bIF_AE\\b"
-            << "\\bIF_ALWAYS\\b"
-            << "\\bIF_B\\b"
-            << "\\bIF_BE\\b"
-            << "\\bIF_C\\b"
-            << "\\bIF_C_AND_NZ\\b"
-            << "\\bIF_C_AND_Z\\b"
-            << "\\bIF_C_EQ_Z\\b"
-            << "\\bIF_C_NE_Z\\b"
-            << "\\bIF_C_OR_NZ\\b"
-            << "\\bIF_C_OR_Z\\b"
-            << "\\bIF_E\\b"
-            << "\\bIF_NC\\b"
-            << "\\bIF_NC_AND_NZ\\b"
-            << "\\bIF_NC_AND_Z\\b"
-            << "\\bIF_NC_OR_NZ\\b"
-            << "\\bIF_NC_OR_Z\\b"
-            << "\\bIF_NE\\b"
-            << "\\bIF_NEVER\\b"
-            << "\\bIF_NZ\\b"
-            << "\\bIF_NZ_AND_C\\b"
-            << "\\bIF_NZ_AND_NC\\b"
-            << "\\bIF_NZ_OR_C\\b"
-            << "\\bIF_NZ_OR_NC\\b"
-            << "\\bIF_Z\\b"
-            << "\\bIF_Z_AND_C\\b"
-            << "\\bIF_Z_AND_NC\\b"
-            << "\\bIF_Z_EQ_C\\b"
-            << "\\bIF_Z_NE_C\\b"
-            << "\\bIF_Z_OR_C\\b"
-            << "\\bIF_Z_OR_NC\\b"
-            << "\\bINA\\b"
-            << "\\bINB#\\b"
-            << "\\bJMP\\b"
-            << "\\bJMPRET\\b"
-            << "\\bLOCKCLR\\b"
-            << "\\bLOCKNEW\\b"
-            << "\\bLOCKRET\\b"
-            << "\\bLOCKSET\\b"
-            << "\\bLONG\\b"
-            << "\\bLONGFILL\\b"
-            << "\\bLONGMOVE\\b"
-            << "\\bLOOKDOWN\\b"
-            << "\\bLOOKDOWNZ\\b"
-            << "\\bLOOKUP\\b"
-            << "\\bLOOKUPZ\\b"
-            << "\\bMAX\\b"
-            << "\\bMAXS\\b"
-            << "\\bMIN\\b"
-            << "\\bMINS\\b"
-            << "\\bMOV\\b"
-            << "\\bMOVD\\b"
-            << "\\bMOVI\\b"
-            << "\\bMOVS\\b"
-            << "\\bMUL#\\b"
-            << "\\bMULS#\\b"
-            << "\\bMUXC\\b"
-            << "\\bMUXNC\\b"
-            << "\\bMUXNZ\\b"
-            << "\\bMUXZ\\b"
-            << "\\bNEG\\b"
-            << "\\bNEGC\\b"
-            << "\\bNEGNC\\b"
-            << "\\bNEGNZ\\b"
-            << "\\bNEGX\\b"
-            << "\\bNEGZ\\b"
-            << "\\bNEXT\\b"
-            << "\\bNOP\\b"
-            << "\\bNOT\\b"
-            << "\\bNR\\b"
-            << "\\bOBJ\\b"
-            << "\\bONES#\\b"
-            << "\\bOR\\b"
-            << "\\bORG\\b"
-            << "\\bOTHER\\b"
-            << "\\bOUTA\\b"
-            << "\\bOUTB#\\b"
-            << "\\bPAR\\b"
-            << "\\bPHSA\\b"
-            << "\\bPHSB\\b"
-            << "\\bPI\\b"
-            << "\\bPLL1X\\b"
-            << "\\bPLL2X\\b"
-            << "\\bPLL4X\\b"
-            << "\\bPLL8X\\b"
-            << "\\bPLL16X\\b"
-            << "\\bPOSX\\b"
-            << "\\bPRI\\b"
-            << "\\bPUB\\b"
-            << "\\bQUIT\\b"
-            << "\\bRCFAST\\b"
-            << "\\bRCL\\b"
-            << "\\bRCR\\b"
-            << "\\bRCSLOW\\b"
-            << "\\bRDBYTE\\b"
-            << "\\bRDLONG\\b"
-            << "\\bRDWORD\\b"
-            << "\\bREBOOT\\b"
-            << "\\bREPEAT\\b"
-            << "\\bRES\\b"
-            << "\\bRESULT\\b"
-            << "\\bRET\\b"
-            << "\\bRETURN\\b"
-            << "\\bREV\\b"
-            << "\\bROL\\b"
-            << "\\bROR\\b"
-            << "\\bROUND\\b"
-            << "\\bSAR\\b"
-            << "\\bSHL\\b"
-            << "\\bSHR\\b"
-            << "\\bSPR\\b"
-            << "\\bSTEP\\b"
-            << "\\bSTRCOMP\\b"
-            << "\\bSTRING\\b"
-            << "\\bSTRSIZE\\b"
-            << "\\bSUB\\b"
-            << "\\bSUBABS\\b"
-            << "\\bSUBS\\b"
-            << "\\bSUBSX\\b"
-            << "\\bSUBX\\b"
-            << "\\bSUMC\\b"
-            << "\\bSUMNC\\b"
-            << "\\bSUMNZ\\b"
-            << "\\bSUMZ\\b"
-            << "\\bTEST\\b"
-            << "\\bTESTN\\b"
-            << "\\bTJNZ\\b"
-            << "\\bTJZ\\b"
-            << "\\bTO\\b"
-            << "\\bTRUE\\b"
-            << "\\bTRUNC\\b"
-            << "\\bUNTIL\\b"
-            << "\\bVAR\\b"
-            << "\\bVCFG\\b"
-            << "\\bVSCL\\b"
-            << "\\bWAITCNT\\b"
-            << "\\bWAITPEQ\\b"
-            << "\\bWAITPNE\\b"
-            << "\\bWAITVID\\b"
-            << "\\bWC\\b"
-            << "\\bWHILE\\b"
-            << "\\bWORD\\b"
-            << "\\bWORDFILL\\b"
-            << "\\bWORDMOVE\\b"
-            << "\\bWR\\b"
-            << "\\bWRBYTE\\b"
-            << "\\bWRLONG\\b"
-            << "\\bWRWORD\\b"
-            << "\\bWZ\\b"
-            << "\\bXINPUT\\b"
-            << "\\bXOR\\b"
-            << "\\bXTAL1\\b"
-            << "\\bXTAL2\\b"
-            << "\\bXTAL3\\b"
-
             << "--"
             << "++"
             << "?"
@@ -365,18 +391,21 @@ void SpinHighlighter::highlight()
     preprocessorFormat.setFontItalic(hlPreProcStyle);
     preprocessorFormat.setForeground(hlPreProcColor);
     preprocessorFormat.setFontWeight(hlPreProcWeight);
-    QStringList preprocessorPatterns;
-    preprocessorPatterns
-            << "\\bdefine\\b"
-            << "\\bdefined\\b"
-            << "\\berror\\b"
-            << "\\belif\\b"
-            << "\\bendif\\b"
-            << "\\bifdef\\b"
-            << "\\binclude\\b"
-            << "\\bundef\\b"
-            << "\\bwarning\\b"
+    QStringList preprocessor;
+    preprocessor
+            << "define"
+            << "defined"
+            << "error"
+            << "elif"
+            << "endif"
+            << "ifdef"
+            << "include"
+            << "undef"
+            << "warning"
             ;
+    QStringList preprocessorPatterns;
+    foreach (const QString &word, preprocessor)
+        preprocessorPatterns << "\\b"+word+"\\b";
     foreach (const QString &pattern, preprocessorPatterns) {
         rule.pattern = QRegExp(pattern,Qt::CaseInsensitive);
         rule.format = preprocessorFormat;
@@ -398,5 +427,188 @@ void SpinHighlighter::highlight()
     commentStartExpression = QRegExp("[^']{*",Qt::CaseInsensitive,QRegExp::Wildcard);
     commentEndExpression = QRegExp("*}",Qt::CaseInsensitive,QRegExp::Wildcard);
 
+    // compile the same rules for lexBlock
+    layerFormats.fill(QTextCharFormat(), LayerCount);
+    layerFormats[LayerQuote] = quotationFormat;
+    layerFormats[LayerNumber] = numberFormat;
+    layerFormats[LayerFunction] = functionFormat;
+    layerFormats[LayerKeyword] = keywordFormat;
+    layerFormats[LayerPreProc] = preprocessorFormat;
+    layerFormats[LayerLineComment] = singleLineCommentFormat;
+    layerFormats[LayerBlockComment] = multiLineCommentFormat;
+    words.clear();
+    addWords(keywords, LayerKeyword, true);
+    addWords(sharpKeywords, LayerKeyword | SHARP_SUFFIX, true);
+    addWords(preprocessor, LayerPreProc, true);
+}
+
+static inline bool isCallChar(ushort c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '.';
+}
+
+static inline bool isHexChar(ushort c)
+{
+    return (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F') || (c >= '0' && c <= '9') || c == ',' || c == '_';
+}
+
+/**
+ * Single pass equivalent of the rules built in highlight().
+ * Of the operator patterns only the single characters -@!<>&/=:~ and
+ * the pairs #> and <# ever matched; patterns starting with + * ? are not
+ * valid QRegExps and those built from ^ and | match empty strings.
+ * The block comment starts one character before a { that is not
+ * preceded by ' and runs to the last } on the line.
+ */
+bool SpinHighlighter::lexBlock(const QString &text)
+{
+    const QChar *s = text.constData();
+    int len = text.length();
+    clearLayers(len);
+
+    int wordStart = -1;
+    int callStart = -1;
+    int firstQuote = -1;
+    int lastQuote = -1;
+    int lineComment = -1;
+
+    for(int n = 0; n <= len; n++) {
+        ushort c = n < len ? s[n].unicode() : 0;
+        bool w = n < len && isWord(s[n]);
+
+        if(w && wordStart < 0) {
+            wordStart = n;
+        }
+        else if(!w && wordStart >= 0) {
+            int length = n - wordStart;
+            const QChar *ws = s + wordStart;
+            int digits = 0;
+            while(digits < length && ((ws[digits] >= QLatin1Char('0') && ws[digits] <= QLatin1Char('9')) || ws[digits] == QLatin1Char('_')))
+                digits++;
+            if(digits == length) {
+                mark(wordStart, length, LayerNumber);
+            }
+            else {
+                int value = wordValue(ws, length, true);
+                if(value & SHARP_SUFFIX) {
+                    if(c == '#' && n+1 < len && isWord(s[n+1]))
+                        mark(wordStart, length+1, value & ~SHARP_SUFFIX);
+                }
+                else if(value) {
+                    mark(wordStart, length, value);
+                }
+            }
+            wordStart = -1;
+        }
+
+        if(isCallChar(c)) {
+            if(callStart < 0)
+                callStart = n;
+            if(c != '.')
+                continue;
+        }
+        else {
+            if(c == '(' && callStart >= 0)
+                markCall(s, callStart, n, LayerFunction);
+            callStart = -1;
+        }
+
+        switch(c) {
+        case '"':
+            if(firstQuote < 0)
+                firstQuote = n;
+            lastQuote = n;
+            break;
+        case '\'':
+            if(lineComment < 0)
+                lineComment = n;
+            break;
+        case '$': {
+            int end = n+1;
+            while(end < len && isHexChar(s[end].unicode()))
+                end++;
+            mark(n, end-n, LayerNumber);
+            break;
+        }
+        case '#':
+            if((n+1 < len && s[n+1] == QLatin1Char('>')) || (n > 0 && s[n-1] == QLatin1Char('<')))
+                mark(n, 1, LayerKeyword);
+            break;
+        case '-':
+        case '@':
+        case '!':
+        case '<':
+        case '>':
+        case '&':
+        case '/':
+        case '=':
+        case ':':
+        case '~':
+            mark(n, 1, LayerKeyword);
+            break;
+        }
+    }
+
+    if(lastQuote > firstQuote)
+        mark(firstQuote, lastQuote-firstQuote+1, LayerQuote);
+    if(lineComment >= 0)
+        mark(lineComment, len-lineComment, LayerLineComment);
+
+    lexComments(text, true);
+    paintLayers();
+    return true;
+}
+
+bool SpinHighlighter::lexState(const QString &text)
+{
+    lexComments(text, false);
+    return true;
+}
+
+/**
+ * Find block comments and set the block state and brace counts.
+ * @param paint marks the comments when true.
+ */
+void SpinHighlighter::lexComments(const QString &text, bool paint)
+{
+    int len = text.length();
+    setCurrentBlockState(0);
+    int lastBrace = text.lastIndexOf(QLatin1Char('}'));
+    int start = 0;
+    if(previousBlockState() != 1)
+        start = commentStart(text, 0);
+    while(start >= 0) {
+        int length;
+        if(lastBrace < start) {
+            setCurrentBlockState(1);
+            length = len - start;
+        }
+        else {
+            length = lastBrace - start + 1;
+        }
+        if(paint)
+            mark(start, length, LayerBlockComment);
+        start = commentStart(text, start + length);
+    }
+
+    /* Spin braces are comments, count them all as before */
+    int open = 0;
+    int close = 0;
+    countBraces(text, 0, len, &open, &close);
+    setBraces(open, close);
+}
+
+/**
+ * @returns index of the character before a { that is not a ' or -1.
+ */
+int SpinHighlighter::commentStart(const QString &text, int from)
+{
+    const QChar *s = text.constData();
+    int len = text.length();
+    for(int n = from; n+1 < len; n++) {
+        if(s[n+1] == QLatin1Char('{') && s[n] != QLatin1Char('\''))
+            return n;
+    }
+    return -1;
 }
 
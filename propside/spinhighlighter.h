@@ -67,6 +67,13 @@ public:
     SpinHighlighter(QTextDocument *parent, Properties *prop);
     void highlight();
 
+protected:
+    bool lexBlock(const QString &text);
+    bool lexState(const QString &text);
+
+private:
+    void lexComments(const QString &text, bool paint);
+    int  commentStart(const QString &text, int from);
 };
 
 #endif
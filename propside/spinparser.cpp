@@ -20,10 +20,50 @@
 #include <QWidget>
 #include "spinparser.h"
 
-#define KEY_ELEMENT_SEP ":"
+/*
+ * Reads and parses one file on a pool thread. Each job has its own
+ * parser so nothing is shared with the others.
+ */
+class SpinParseJob : public QRunnable
+{
+public:
+    SpinParseJob(const QString &fileName, SpinParser::FileTags *result)
+        : fileName(fileName), result(result)
+    {
+    }
+
+    void run()
+    {
+        QFile file(fileName);
+        if(file.open(QFile::ReadOnly) != true) {
+            result->valid = false;
+            result->tags.clear();
+            return;
+        }
+        QByteArray bytes = file.readAll();
+        file.close();
+
+        /* touched but not changed */
+        uint hash = qHash(bytes);
+        if(result->valid && result->hash == hash)
+            return;
+        result->hash = hash;
+
+        SpinParser parser;
+        parser.parseFile(fileName, bytes, result);
+        result->valid = true;
+    }
+
+private:
+    QString                 fileName;
+    SpinParser::FileTags    *result;
+};
 
 SpinParser::SpinParser()
 {
+    currentLine = 0;
+    parsed = NULL;
+    pool = NULL;
     setKind(&SpinKinds[SpinParser::K_NONE],     false,'n', "none", "none"); // place-holder only
     setKind(&SpinKinds[SpinParser::K_CONST],    true, 'c', "constant", "constants");
     setKind(&SpinKinds[SpinParser::K_PUB],      true, 'f', "public", "methods");
@@ -52,14 +92,37 @@ SpinParser::SpinParser()
 SpinParser::~SpinParser()
 {
     clearDB();
+    delete pool;
 }
 
 void SpinParser::clearDB()
 {
-    db.clear();
+    symbols.clear();
     spinFiles.clear();
 }
 
+/*
+ * Split a tag into a symbol for the node.
+ * A tag is composed as: symbol\tfile\tdeclaration\tsymboltype
+ * The declaration is a source line and may hold tabs itself.
+ */
+void SpinParser::addTag(QString node, QString tag)
+{
+    int name = tag.indexOf('\t');
+    int file = tag.indexOf('\t', name+1);
+    int kind = tag.lastIndexOf('\t');
+    if(name < 0 || file < 0 || kind <= file || kind+1 >= tag.length())
+        return;
+    SpinSymbols::Symbol sym;
+    sym.name = tag.left(name);
+    sym.node = node;
+    sym.file = tag.mid(name+1, file-name-1);
+    sym.declaration = tag.mid(file+1, kind-file-1);
+    sym.line = currentLine;
+    sym.kind = tag.at(kind+1);
+    symbols.add(sym);
+}
+
 void SpinParser::setKind(kindOption *kind, bool en, const char letter, const char *name, const char *desc)
 {
     kind->enabled = en;
@@ -72,39 +135,36 @@ void SpinParser::setKind(kindOption *kind, bool en, const char letter, const cha
  * get a tree list.
  * all object instances will be listed with sub-objects
  * the list will be indented according to relative position
+ * only files changed since the last call are parsed again.
  */
 QStringList SpinParser::spinFileTree(QString file, QString libpath)
 {
-    QString key;
-    QString value;
     QString subnode;
     QString subfile;
 
     libraryPath = libpath;
     clearDB();
+    objectFiles.clear();
 
-    this->findSpinTags(file, "root");
+    file = checkFile(file, file);
+    parseTree(file);
+    QStringList path;
+    addFileTags(file, "root", path);
 
     spinFiles.append(file.mid(file.lastIndexOf("/")+1));
-    QStringList keys = db.keys();
 
 #if defined(SPIN_AUTOCOMPLETE)
     makeTags(file);
 #endif
 
-    for(int n = 0; n < keys.length(); n++) {
-        key = keys[n];
-        value = db[key];
-        QStringList levels = key.split("/");
-        int lcount = levels.count()-1;
-        QStringList keyel = levels[lcount].split(KEY_ELEMENT_SEP);
-        if(keyel.count() < 2)
+    foreach(int id, symbols.all()) {
+        const SpinSymbols::Symbol &sym = symbols.at(id);
+        if(sym.kind != 'o')
             continue;
-        if(QString(keyel[0]).compare(keyel[1]) == 0) {
-            objectInfo(value, subnode, subfile);
-            //for(int n = 0; n < lcount; n++) subfile = " " + subfile;
-            spinFiles.append(subfile);
-        }
+        QString tag = sym.name+"\t"+sym.file+"\t"+sym.declaration+"\t"+sym.kind;
+        objectInfo(tag, subnode, subfile);
+        //for(int n = 0; n < lcount; n++) subfile = " " + subfile;
+        spinFiles.append(subfile);
     }
 
     return spinFiles;
@@ -112,8 +172,6 @@ QStringList SpinParser::spinFileTree(QString file, QString libpath)
 
 void SpinParser::makeTags(QString file)
 {
-    QStringList keys = db.keys();
-
     QString tagheader = \
 "!_TAG_FILE_FORMAT	1	/original ctags format/\n"
 "!_TAG_FILE_SORTED	1	/0=unsorted, 1=sorted, 2=foldcase/\n"
@@ -126,9 +184,9 @@ void SpinParser::makeTags(QString file)
     QFile tags(path+"tags");
     if(tags.open(QFile::WriteOnly | QFile::Text)) {
         tags.write(tagheader.toLatin1());
-        foreach(QString key, keys) {
-            QStringList tl = db[key].split("\t");
-            QString ts = tl[0]+"\t"+tl[1]+"\t/^"+tl[2]+"$/";
+        foreach(int id, symbols.all()) {
+            const SpinSymbols::Symbol &sym = symbols.at(id);
+            QString ts = sym.name+"\t"+sym.file+"\t/^"+sym.declaration+"$/";
             tags.write(ts.toLatin1()+"\n");
         }
         tags.close();
@@ -145,166 +203,84 @@ QString SpinParser::tagItem(QStringList tabs, int field)
 }
 
 /*
- * all symbols are accessible by key.
- * a key is a name list such as "/root/obj/subobj/subsubobj"
- * if the key is empty, return the root or top file list
+ * Autocomplete items for symbol ids in their ranked order.
+ * Kinds in kinds give "type\tdeclaration", kinds in nameKinds "type\tname".
  */
-QStringList SpinParser::spinSymbols(QString file, QString objname)
+QStringList SpinParser::tagList(QList<int> ids, QString kinds, QString nameKinds)
 {
     QStringList list;
-    QStringList keys = db.keys();
-    QString key;
-    QString value;
-    for(int n = 0; n < keys.length(); n++) {
-        key = keys[n];
-        value = db[key];
-        if(objname.length() > 0) {
-            if(key.contains(objname+":",Qt::CaseInsensitive)) {
-                QStringList tabs = value.split("\t");
-                if(tabs.count() > 2)
-                    list.append(tagItem(tabs,2));
-            }
-        }
-        else if(value.contains(file,Qt::CaseInsensitive)) {
-            QStringList tabs = value.split("\t");
-            if(tabs.count() > 2)
-                list.append(tagItem(tabs,2));
-        }
+    foreach(int id, ids) {
+        const SpinSymbols::Symbol &sym = symbols.at(id);
+        if(kinds.contains(sym.kind))
+            list.append(QString(sym.kind)+"\t"+sym.declaration);
+        else if(nameKinds.contains(sym.kind))
+            list.append(QString(sym.kind)+"\t"+sym.name);
     }
     return list;
 }
 
+/*
+ * all symbols are accessible by object instance name.
+ * if the name is empty, return the symbols declared in file.
+ * a prefix limits the list to names starting with it.
+ */
+QStringList SpinParser::spinSymbols(QString file, QString objname, QString prefix)
+{
+    if(objname.length() > 0)
+        return tagList(symbols.instance(objname, prefix), "cefpovx");
+
+    QString name = file.mid(file.lastIndexOf("/")+1);
+    if(name.endsWith(" *"))
+        name.chop(2);
+    return tagList(symbols.file(name, prefix), "cefpovx");
+}
+
 /*
  * these are convenience wrappers for typefilter
  */
-QStringList SpinParser::spinConstants(QString file, QString objname)
+QStringList SpinParser::spinConstants(QString file, QString objname, QString prefix)
 {
-    QStringList list;
-    QStringList keys = db.keys();
-    QString key;
-    QString value;
-    for(int n = 0; n < keys.length(); n++) {
-        key = keys[n];
-        value = db[key];
-        if(objname.length() > 0) {
-            if(key.contains(objname+":",Qt::CaseInsensitive)) {
-                QStringList tabs = value.split("\t");
-                if(tabs.count() > 2) {
-                    if(QString(tabs.at(3)).contains("c",Qt::CaseInsensitive))
-                        list.append(tagItem(tabs,2));
-                    else if(QString(tabs.at(3)).contains("e",Qt::CaseInsensitive)) {
-                        list.append(tagItem(tabs,0));
-                    }
-                }
-            }
-        }
-        else if(value.contains(file,Qt::CaseInsensitive)) {
-            QStringList tabs = value.split("\t");
-            if(tabs.count() > 2) {
-                if(QString(tabs.at(3)).contains("c",Qt::CaseInsensitive))
-                    list.append(tagItem(tabs,2));
-                else if(QString(tabs.at(3)).contains("e",Qt::CaseInsensitive)) {
-                    list.append(tagItem(tabs,0));
-                }
-            }
-        }
-    }
-    return list;
+    if(objname.length() > 0)
+        return tagList(symbols.instance(objname, prefix), "c", "e");
+
+    QString name = file.mid(file.lastIndexOf("/")+1);
+    if(name.endsWith(" *"))
+        name.chop(2);
+    return tagList(symbols.file(name, prefix), "c", "e");
 }
 
 QStringList SpinParser::spinMethods(QString file, QString objname)
 {
-    QStringList list;
-    QStringList keys = db.keys();
-    QString key;
-    QString value;
-    for(int n = 0; n < keys.length(); n++) {
-        key = keys[n];
-        value = db[key];
-        if(objname.length() > 0) {
-            if(key.contains(objname+":",Qt::CaseInsensitive)) {
-                QStringList tabs = value.split("\t");
-                if(tabs.count() > 2) {
-                    if(QString(tabs.at(3)).contains("p",Qt::CaseInsensitive))
-                        list.append(tagItem(tabs,2));
-                    if(QString(tabs.at(3)).contains("f",Qt::CaseInsensitive))
-                        list.append(tagItem(tabs,2));
-                }
-            }
-        }
-        else if(value.contains(file,Qt::CaseInsensitive)) {
-            QStringList tabs = value.split("\t");
-            if(tabs.count() > 2) {
-                if(QString(tabs.at(3)).contains("p",Qt::CaseInsensitive))
-                    list.append(tagItem(tabs,2));
-                if(QString(tabs.at(3)).contains("f",Qt::CaseInsensitive))
-                    list.append(tagItem(tabs,2));
-                if(QString(tabs.at(3)).contains("o",Qt::CaseInsensitive))
-                    list.append(tagItem(tabs,2));
-            }
-        }
-    }
-    return list;
+    if(objname.length() > 0)
+        return tagList(symbols.instance(objname), "pf");
+
+    QString name = file.mid(file.lastIndexOf("/")+1);
+    if(name.endsWith(" *"))
+        name.chop(2);
+    return tagList(symbols.file(name), "pfo");
 }
 
 QStringList SpinParser::spinDat(QString file, QString objname)
 {
-    QStringList list;
-    QStringList keys = db.keys();
-    QString key;
-    QString value;
-    for(int n = 0; n < keys.length(); n++) {
-        key = keys[n];
-        value = db[key];
-        if(key.contains(objname+":",Qt::CaseInsensitive)) {
-            QStringList tabs = value.split("\t");
-            if(tabs.count() > 2) {
-                if(QString(tabs.at(3)).contains("d",Qt::CaseInsensitive))
-                    list.append(tagItem(tabs,2));
-            }
-        }
-    }
-    return list;
+    Q_UNUSED(file);
+    return tagList(symbols.instance(objname), "x");
 }
 
 QStringList SpinParser::spinVars(QString file, QString objname)
 {
-    QStringList list;
-    QStringList keys = db.keys();
-    QString key;
-    QString value;
-    for(int n = 0; n < keys.length(); n++) {
-        key = keys[n];
-        value = db[key];
-        if(key.contains(objname+":",Qt::CaseInsensitive)) {
-            QStringList tabs = value.split("\t");
-            if(tabs.count() > 2) {
-                if(QString(tabs.at(3)).contains("v",Qt::CaseInsensitive))
-                    list.append(tagItem(tabs,2));
-            }
-        }
-    }
-    return list;
+    Q_UNUSED(file);
+    return tagList(symbols.instance(objname), "v");
 }
 
 QStringList SpinParser::spinObjects(QString file, QString objname)
 {
-    QStringList list;
-    QStringList keys = db.keys();
-    QString key;
-    QString value;
-    for(int n = 0; n < keys.length(); n++) {
-        key = keys[n];
-        value = db[key];
-        if(key.contains(objname+":",Qt::CaseInsensitive)) {
-            QStringList tabs = value.split("\t");
-            if(tabs.count() > 2) {
-                if(QString(tabs.at(3)).contains("o",Qt::CaseInsensitive))
-                    list.append(tagItem(tabs,2));
-            }
-        }
-    }
-    return list;
+    Q_UNUSED(file);
+    return tagList(symbols.instance(objname), "o");
+}
+
+void SpinParser::useSymbol(QString name)
+{
+    symbols.used(name);
 }
 
 /*
@@ -394,8 +370,7 @@ void SpinParser::match_constant (QString p)
             s.toInt(&ok);  // don't add numbers to the list
             if(ok == true) continue;
             tag = s+"\t"+currentFile+"\t"+p+"\t"+"e";
-            db.insert(objectNode+KEY_ELEMENT_SEP+s,tag);
-            // qDebug() << objectNode << " ## " << tag;
+            fileTag(tag);
         }
     }
     else if((len = p.indexOf("=")) > 0) {
@@ -408,8 +383,7 @@ void SpinParser::match_constant (QString p)
                 s = s.mid(4);
             s = s.trimmed();
             tag = s+"\t"+currentFile+"\t"+p+"\t"+SpinKinds[K_CONST].letter;
-            db.insert(objectNode+KEY_ELEMENT_SEP+s,tag);
-            // qDebug() << objectNode << " ## " << tag;
+            fileTag(tag);
         }
     }
 }
@@ -433,8 +407,7 @@ void SpinParser::match_dat (QString p)
                     s = s.mid(0,s.indexOf("["));
                 s = s.trimmed();
                 tag = s+"\t"+currentFile+"\t"+p+"\t"+SpinKinds[K_DAT].letter;
-                db.insert(objectNode+KEY_ELEMENT_SEP+s,tag);
-                // qDebug() << objectNode << " DAT " << tag;
+                fileTag(tag);
             }
         }
     }
@@ -458,12 +431,8 @@ void SpinParser::match_object (QString p)
         s = s.trimmed();
         tag = s+"\t"+currentFile+"\t"+p+"\t"+SpinKinds[K_OBJECT].letter;
         objectInfo(tag, subnode, subfile);
-        QString file = checkFile(subfile);
-        if(QFile::exists(file) == false)
-            return;
-        db.insert(objectNode+"/"+subnode+KEY_ELEMENT_SEP+s,tag);
-        // qDebug() << objectNode+"/"+subnode << " :: " << tag;
-        findSpinTags(subfile,objectNode+"/"+subnode);
+        // the file is found and parsed when the tree is put together
+        fileTag(tag, subfile);
     }
 }
 
@@ -482,8 +451,7 @@ void SpinParser::match_pri (QString p)
             s = s.mid(0,s.indexOf("("));
         s = s.trimmed();
         tag = s+"\t"+currentFile+"\t"+p+"\t"+SpinKinds[K_PRI].letter;
-        db.insert(objectNode+KEY_ELEMENT_SEP+s,tag);
-        // qDebug() << objectNode << " pri " << tag;
+        fileTag(tag);
     }
 }
 
@@ -502,8 +470,7 @@ void SpinParser::match_pub (QString p)
             s = s.mid(0,s.indexOf("("));
         s = s.trimmed();
         tag = s+"\t"+currentFile+"\t"+p+"\t"+SpinKinds[K_PUB].letter;
-        db.insert(objectNode+KEY_ELEMENT_SEP+s,tag);
-        // qDebug() << objectNode << " pub " << tag;
+        fileTag(tag);
     }
 }
 
@@ -530,8 +497,7 @@ void SpinParser::match_var (QString p)
                         s = s.mid(0,s.indexOf("["));
                     s = s.trimmed();
                     tag = s+"\t"+currentFile+"\t"+p+"\t"+SpinKinds[K_VAR].letter;
-                    db.insert(objectNode+KEY_ELEMENT_SEP+s,tag);
-                    // qDebug() << objectNode << " VAR " << tag;
+                    fileTag(tag);
                 }
             }
         }
@@ -556,7 +522,10 @@ int SpinParser::objectInfo(QString tag, QString &name, QString &file)
 }
 
 
-QString SpinParser::checkFile(QString fileName)
+/*
+ * Find an object file as named in parent.
+ */
+QString SpinParser::checkFile(QString fileName, QString parent)
 {
     QString retfile = fileName;
 
@@ -569,7 +538,7 @@ QString SpinParser::checkFile(QString fileName)
     else {
         QDir dir;
         QStringList list;
-        QString fs = this->currentFile;
+        QString fs = parent;
         QString shortfile = fileName.mid(fileName.lastIndexOf("/")+1);
         QString path = fs.mid(0,fs.lastIndexOf("/")+1);
         dir.setPath(path);
@@ -590,12 +559,129 @@ QString SpinParser::checkFile(QString fileName)
     return retfile;
 }
 
-void SpinParser::findSpinTags (QString fileName, QString objnode)
+/*
+ * Add the parse results of a file to the cache for it.
+ */
+void SpinParser::fileTag(QString tag, QString object)
+{
+    FileTag t;
+    t.tag = tag;
+    t.line = currentLine;
+    t.object = object;
+    parsed->tags.append(t);
+}
+
+/*
+ * checkFile once per object name and folder for each tree request.
+ */
+QString SpinParser::objectFile(QString object, QString parent)
+{
+    QString key = parent.mid(0,parent.lastIndexOf("/")+1)+"\t"+object;
+    if(!objectFiles.contains(key))
+        objectFiles.insert(key, checkFile(object, parent));
+    return objectFiles.value(key);
+}
+
+/*
+ * Parse every file in the tree that is not cached or has changed.
+ * Files are taken a level at a time and each level is parsed in
+ * parallel; the file names found in a level make the next one.
+ */
+void SpinParser::parseTree(QString file)
+{
+    if(pool == NULL) {
+        pool = new QThreadPool();
+        pool->setMaxThreadCount(qMax(QThread::idealThreadCount(), 2));
+    }
+
+    QSet<QString> seen;
+    QStringList level;
+    level.append(file);
+    seen.insert(file);
+
+    while(level.count() > 0) {
+        QStringList stale;
+        foreach(QString name, level) {
+            QFileInfo info(name);
+            if(!info.exists()) {
+                fileCache.remove(name);
+                continue;
+            }
+            if(!fileCache.contains(name)) {
+                FileTags empty;
+                empty.mtime = 0;
+                empty.size = 0;
+                empty.hash = 0;
+                empty.valid = false;
+                fileCache.insert(name, empty);
+            }
+            FileTags &cached = fileCache[name];
+            qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+            if(cached.valid && cached.mtime == mtime && cached.size == info.size())
+                continue;
+            cached.mtime = mtime;
+            cached.size = info.size();
+            stale.append(name);
+        }
+
+        /* jobs write only their own entry; the cache is not changed until the pool is done */
+        QList<FileTags*> results;
+        foreach(QString name, stale)
+            results.append(&fileCache[name]);
+        for(int n = 0; n < stale.count(); n++)
+            pool->start(new SpinParseJob(stale[n], results[n]));
+        pool->waitForDone();
+
+        QStringList next;
+        foreach(QString name, level) {
+            foreach(const FileTag &t, fileCache.value(name).tags) {
+                if(t.object.isEmpty())
+                    continue;
+                QString sub = objectFile(t.object, name);
+                if(!seen.contains(sub) && QFile::exists(sub)) {
+                    seen.insert(sub);
+                    next.append(sub);
+                }
+            }
+        }
+        level = next;
+    }
+}
+
+/*
+ * Put the cached tags of a file under an instance node and do the
+ * same for each object it uses. path holds the files above this one
+ * so an object that includes itself is not followed.
+ */
+void SpinParser::addFileTags(QString fileName, QString node, QStringList &path)
 {
-    fileName = checkFile(fileName);
-    if(QFile::exists(fileName) == false)
+    if(!fileCache.contains(fileName))
         return;
+    path.append(fileName);
+    QList<FileTag> tags = fileCache.value(fileName).tags;
+    foreach(const FileTag &t, tags) {
+        currentLine = t.line;
+        if(t.object.isEmpty()) {
+            addTag(node, t.tag);
+            continue;
+        }
+        QString sub = objectFile(t.object, fileName);
+        if(QFile::exists(sub) == false)
+            continue;
+        QString subnode = t.tag.left(t.tag.indexOf("\t"));
+        addTag(node+"/"+subnode, t.tag);
+        if(!path.contains(sub))
+            addFileTags(sub, node+"/"+subnode, path);
+    }
+    path.removeLast();
+}
 
+/*
+ * Parse a file's text into result. Object files named in OBJ
+ * sections are recorded but not followed.
+ */
+void SpinParser::parseFile(QString fileName, const QByteArray &bytes, FileTags *result)
+{
     QString line;
     QString tag;
     QString filestr;
@@ -603,32 +689,30 @@ void SpinParser::findSpinTags (QString fileName, QString objnode)
     SpinKind state = K_CONST; // spin starts with CONST
     bool blockComment = false;
 
-    QFile file(fileName);
-    QTextStream in(&file);
+    QByteArray data = bytes;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    QTextStream in(&buffer);
     in.setAutoDetectUnicode(true);
-    if(file.open(QFile::ReadOnly) != true)
-        return;
-    QStringList list;
-    QStringList lst2;
-
     filestr = in.readAll();
-    file.close();
+    buffer.close();
 
-    list = filestr.split("\n",QString::SkipEmptyParts,Qt::CaseInsensitive);
-    lst2 = filestr.split("\r",QString::SkipEmptyParts,Qt::CaseInsensitive);
+    parsed = result;
+    parsed->tags.clear();
+    currentFile = fileName;
 
     /* amazing that we have to do stuff like this with spin files */
-    if(lst2.count() > list.count())
-        list = filestr.split("\r",QString::SkipEmptyParts,Qt::CaseInsensitive);
+    QChar eol = filestr.count('\r') > filestr.count('\n') ? '\r' : '\n';
+
+    /* empty lines are kept so symbols get their line numbers */
+    QStringList list = filestr.split(eol, QString::KeepEmptyParts);
 
     for(int n = 0; n < list.length(); n++)
     {
         // give app a chance to do work? parsing can take a while.
         // QApplication::processEvents();
 
-        // do here in case OBJ detect causes context change
-        objectNode  = objnode;
-        currentFile = fileName;
+        currentLine = n+1;
 
         line = QString(list[n]).trimmed();
 
@@ -21,6 +21,7 @@
 #define SPINPARSER_H
 
 #include <QtCore>
+#include "spinsymbols.h"
 
 class SpinParser
 {
@@ -58,10 +59,10 @@ public:
     QString tagItem(QStringList tabs, int field);
 
     /* parse a file for autocomplete */
-    QStringList spinSymbols(QString file, QString objname);
+    QStringList spinSymbols(QString file, QString objname, QString prefix = "");
 
     /* parse a file for autocomplete constants */
-    QStringList spinConstants(QString file, QString objname);
+    QStringList spinConstants(QString file, QString objname, QString prefix = "");
 
     /* parse a file for autocomplete methods */
     QStringList spinMethods(QString file, QString objname);
@@ -75,6 +76,9 @@ public:
     /* parse a file for autocomplete objects */
     QStringList spinObjects(QString file, QString objname);
 
+    /* rank a name picked from autocomplete first next time */
+    void useSymbol(QString name);
+
     typedef struct {
         QString name;
         QString file;
@@ -82,7 +86,24 @@ public:
         int     type;
     } Tags;
 
+    /* a tag as parsed from one file, before it is put in the tree */
+    typedef struct {
+        QString tag;            // symbol\tfile\tdeclaration\tsymboltype
+        int     line;
+        QString object;         // object file named by an OBJ tag
+    } FileTag;
+
+    /* parse results of one file, kept until the file changes */
+    typedef struct {
+        qint64  mtime;
+        qint64  size;
+        uint    hash;           // of the file bytes
+        bool    valid;
+        QList<FileTag> tags;
+    } FileTags;
+
 private:
+    friend class SpinParseJob;
 
     typedef struct sKindOption {
         bool enabled;           /* are tags for kind enabled? */
@@ -106,23 +127,34 @@ private:
     /* this holds the current working spin file */
     QString     currentFile;
 
-    /* this holds the current working tree node */
-    QString     objectNode;
+    /* this holds the current working line number */
+    int         currentLine;
+
+    /* this holds the results of the file being parsed */
+    FileTags    *parsed;
+
+    /* parse results by full file path */
+    QHash<QString, FileTags> fileCache;
+
+    /* parses the files of one tree level at a time */
+    QThreadPool *pool;
+
+    /* object files found for the current tree by folder and name */
+    QHash<QString,QString> objectFiles;
 
     /*
-     * This holds a list of all project symbols.
-     * The key is a name-path key such as root/obj/subobj/subsubobj/name
-     * The items in the string list contain tag information.
-     * A tag is composed as:
-     * symbol\tfile\tdeclaration\tsymboltype
+     * This holds all project symbols by object instance node such as
+     * root/obj/subobj/subsubobj and by declaring file.
      */
-    QMap<QString, QString> db;
+    SpinSymbols symbols;
 
     QString     libraryPath;
 
 private:
 
     void clearDB();
+    void addTag(QString node, QString tag);
+    QStringList tagList(QList<int> ids, QString kinds, QString nameKinds = "");
 
     void setKind(kindOption *kind, bool en, const char letter, const char *type, const char *desc);
 
@@ -137,8 +169,12 @@ private:
     void match_pub (QString p);
     void match_var (QString p);
     int objectInfo(QString tag, QString &name, QString &file);
-    QString checkFile(QString fileName);
-    void findSpinTags (QString fileName, QString objnode);
+    QString checkFile(QString fileName, QString parent);
+    QString objectFile(QString object, QString parent);
+    void fileTag(QString tag, QString object = "");
+    void parseTree(QString file);
+    void addFileTags(QString fileName, QString node, QStringList &path);
+    void parseFile(QString fileName, const QByteArray &bytes, FileTags *result);
 
 };
 
@@ -0,0 +1,254 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spinsymbols.h"
+
+SpinTrie::SpinTrie()
+{
+    clear();
+}
+
+void SpinTrie::clear()
+{
+    Node root;
+    root.child = -1;
+    root.next = -1;
+    nodes.clear();
+    nodes.append(root);
+}
+
+/**
+ * @param name added case folded.
+ * @param id value returned by find for this name.
+ */
+void SpinTrie::insert(const QString &name, int id)
+{
+    int node = 0;
+    foreach(QChar c, name) {
+        c = c.toLower();
+        int child = nodes[node].child;
+        while(child >= 0 && nodes[child].ch != c)
+            child = nodes[child].next;
+        if(child < 0) {
+            Node n;
+            n.ch = c;
+            n.child = -1;
+            n.next = nodes[node].child;
+            child = nodes.count();
+            nodes.append(n);
+            nodes[node].child = child;
+        }
+        node = child;
+    }
+    nodes[node].ids.append(id);
+}
+
+/**
+ * @returns ids of every name starting with prefix, all for an empty prefix.
+ */
+QList<int> SpinTrie::find(const QString &prefix) const
+{
+    QList<int> list;
+    int node = 0;
+    foreach(QChar c, prefix) {
+        c = c.toLower();
+        int child = nodes[node].child;
+        while(child >= 0 && nodes[child].ch != c)
+            child = nodes[child].next;
+        if(child < 0)
+            return list;
+        node = child;
+    }
+
+    QVector<int> stack;
+    list += nodes[node].ids;
+    if(nodes[node].child >= 0)
+        stack.append(nodes[node].child);
+    while(stack.count() > 0) {
+        int n = stack.last();
+        stack.pop_back();
+        list += nodes[n].ids;
+        if(nodes[n].next >= 0)
+            stack.append(nodes[n].next);
+        if(nodes[n].child >= 0)
+            stack.append(nodes[n].child);
+    }
+    return list;
+}
+
+SpinSymbols::SpinSymbols()
+{
+    stamp = 0;
+}
+
+/*
+ * Names picked before are kept so ranking survives a new parse.
+ */
+void SpinSymbols::clear()
+{
+    symbols.clear();
+    folded.clear();
+    keys.clear();
+    instances.clear();
+    files.clear();
+    fileNames.clear();
+    instanceTries.clear();
+    fileTries.clear();
+}
+
+/**
+ * Add a symbol. A symbol with the same node and name replaces
+ * the one added before.
+ */
+void SpinSymbols::add(const Symbol &symbol)
+{
+    QString key = symbol.node+":"+symbol.name;
+    int id = keys.value(key, -1);
+    if(id >= 0) {
+        symbols[id] = symbol;
+        folded[id] = symbol.name.toLower();
+        return;
+    }
+
+    id = symbols.count();
+    symbols.append(symbol);
+    folded.append(symbol.name.toLower());
+    keys.insert(key, id);
+
+    QString inst = symbol.node.mid(symbol.node.lastIndexOf("/")+1).toLower();
+    instances[inst].append(id);
+    instanceTries.remove(inst);
+
+    /* a file used by several instances lists each name once */
+    QString file = symbol.file.mid(symbol.file.lastIndexOf("/")+1).toLower();
+    QString fileKey = file+":"+symbol.kind+":"+symbol.name;
+    if(!fileNames.contains(fileKey)) {
+        fileNames.insert(fileKey);
+        files[file].append(id);
+        fileTries.remove(file);
+    }
+}
+
+int SpinSymbols::count()
+{
+    return symbols.count();
+}
+
+const SpinSymbols::Symbol &SpinSymbols::at(int id)
+{
+    return symbols[id];
+}
+
+/**
+ * @param objname object instance name as used before the dot.
+ * @param prefix start of the names wanted; empty for all.
+ * @returns ranked ids of the instance's symbols.
+ */
+QList<int> SpinSymbols::instance(const QString &objname, const QString &prefix)
+{
+    return lookup(instances, instanceTries, objname, prefix);
+}
+
+/**
+ * @param shortName file name without a path.
+ * @param prefix start of the names wanted; empty for all.
+ * @returns ranked ids of the symbols declared in the file.
+ */
+QList<int> SpinSymbols::file(const QString &shortName, const QString &prefix)
+{
+    return lookup(files, fileTries, shortName, prefix);
+}
+
+/**
+ * @returns every id ordered by node and name.
+ */
+QList<int> SpinSymbols::all()
+{
+    QMap<QString,int> order;
+    QHash<QString,int>::const_iterator it;
+    for(it = keys.constBegin(); it != keys.constEnd(); ++it)
+        order.insert(it.key(), it.value());
+    return order.values();
+}
+
+/**
+ * Rank a name first in later lookups.
+ */
+void SpinSymbols::used(const QString &name)
+{
+    recent.insert(name.toLower(), ++stamp);
+}
+
+QList<int> SpinSymbols::lookup(QHash<QString, QList<int> > &scopes, QHash<QString, SpinTrie> &tries,
+                               const QString &scope, const QString &prefix)
+{
+    QString key = scope.toLower();
+    if(!scopes.contains(key))
+        return QList<int>();
+
+    if(!tries.contains(key)) {
+        SpinTrie &trie = tries[key];
+        foreach(int id, scopes[key])
+            trie.insert(symbols[id].name, id);
+    }
+    QList<int> ids = tries[key].find(prefix);
+    rank(ids);
+    return ids;
+}
+
+typedef struct {
+    int     used;
+    int     kind;
+    const QString *name;
+    int     id;
+} SpinRank;
+
+/* most recently used first, then by kind and name */
+static bool spinRankLessThan(const SpinRank &a, const SpinRank &b)
+{
+    if(a.used != b.used)
+        return a.used > b.used;
+    if(a.kind != b.kind)
+        return a.kind < b.kind;
+    return *a.name < *b.name;
+}
+
+/*
+ * Most recently used first, then by kind and name.
+ */
+void SpinSymbols::rank(QList<int> &ids)
+{
+    QVector<SpinRank> order(ids.count());
+    for(int n = 0; n < ids.count(); n++) {
+        SpinRank &r = order[n];
+        r.id = ids[n];
+        r.name = &folded.at(r.id);
+        r.used = recent.value(*r.name, 0);
+        r.kind = kindRank(symbols[r.id].kind);
+    }
+    qSort(order.begin(), order.end(), spinRankLessThan);
+    for(int n = 0; n < order.count(); n++)
+        ids[n] = order[n].id;
+}
+
+int SpinSymbols::kindRank(QChar kind)
+{
+    int rank = QString("fpceovx").indexOf(kind);
+    return rank < 0 ? 9 : rank;
+}
@@ -0,0 +1,101 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPINSYMBOLS_H
+#define SPINSYMBOLS_H
+
+#include <QtCore>
+
+/*
+ * Case insensitive prefix tree of names. Each name holds the ids
+ * given to insert; find returns the ids of every name with a prefix.
+ */
+class SpinTrie
+{
+public:
+    SpinTrie();
+    void clear();
+    void insert(const QString &name, int id);
+    QList<int> find(const QString &prefix) const;
+
+private:
+    typedef struct {
+        QChar       ch;
+        int         child;      // first child node or -1
+        int         next;       // next sibling node or -1
+        QList<int>  ids;
+    } Node;
+
+    QVector<Node> nodes;        // node 0 is the root
+};
+
+/*
+ * Symbols found in a Spin object tree.
+ * Every symbol belongs to one object instance node such as
+ * root/obj/subobj and is listed by the instance name and by the short
+ * name of the file declaring it. Completion lookups go through a prefix
+ * tree for each of those scopes, built on first use. Results are ranked
+ * by the last time a name was picked, then by kind, then by name.
+ */
+class SpinSymbols
+{
+public:
+    typedef struct {
+        QString name;
+        QString node;           // object instance path
+        QString file;           // full path of the declaring file
+        QString declaration;    // source line
+        int     line;           // line number in file
+        QChar   kind;           // tag letter: c e f p o v x
+    } Symbol;
+
+    SpinSymbols();
+
+    void clear();
+    void add(const Symbol &symbol);
+    int  count();
+    const Symbol &at(int id);
+
+    QList<int> instance(const QString &objname, const QString &prefix = QString());
+    QList<int> file(const QString &shortName, const QString &prefix = QString());
+    QList<int> all();
+
+    void used(const QString &name);
+
+private:
+    QList<int>  lookup(QHash<QString, QList<int> > &scopes, QHash<QString, SpinTrie> &tries,
+                       const QString &scope, const QString &prefix);
+    void        rank(QList<int> &ids);
+    static int  kindRank(QChar kind);
+
+    QVector<Symbol>             symbols;
+    QVector<QString>            folded;     // lower case name of each id
+    QHash<QString,int>          keys;       // node:name to id; a new declaration replaces the old
+    QHash<QString, QList<int> > instances;  // lower case instance name to ids
+    QHash<QString, QList<int> > files;      // lower case short file name to ids
+    QSet<QString>               fileNames;  // short file:kind:name already listed in files
+
+    QHash<QString, SpinTrie>    instanceTries;
+    QHash<QString, SpinTrie>    fileTries;
+
+    QHash<QString,int>          recent;     // lower case name to use stamp
+    int                         stamp;
+};
+
+#endif // SPINSYMBOLS_H
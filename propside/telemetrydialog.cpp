@@ -0,0 +1,139 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "telemetrydialog.h"
+#include "termprefs.h"
+
+TelemetryDialog::TelemetryDialog(QWidget *parent) :
+    QDialog(parent)
+{
+    listener = NULL;
+    setWindowTitle(tr("Telemetry Plot"));
+
+    QSettings settings(publisherKey, ASideGuiKey);
+
+    QGridLayout *form = new QGridLayout();
+    syncEdit = new QLineEdit(settings.value(termKeyPlotSync, "A5 5A").toString(), this);
+    syncEdit->setToolTip(tr("Sync bytes in hex, such as A5 5A"));
+    fieldsEdit = new QLineEdit(settings.value(termKeyPlotFields, "x:i16 y:i16 z:i16").toString(), this);
+    fieldsEdit->setToolTip(tr("Field types in order: u8 i8 u16 i16 u32 i32 f32 f64, optionally named as x:i16"));
+    bigEndianBox = new QCheckBox(tr("Big Endian"), this);
+    bigEndianBox->setChecked(settings.value(termKeyPlotBigEndian, false).toBool());
+    windowSpin = new QSpinBox(this);
+    windowSpin->setRange(100, 200000);
+    windowSpin->setSingleStep(1000);
+    windowSpin->setValue(settings.value(termKeyPlotWindow, 10000).toInt());
+    windowSpin->setSuffix(tr(" frames"));
+    form->addWidget(new QLabel(tr("Sync"), this), 0, 0);
+    form->addWidget(syncEdit, 0, 1);
+    form->addWidget(bigEndianBox, 0, 2);
+    form->addWidget(new QLabel(tr("Fields"), this), 1, 0);
+    form->addWidget(fieldsEdit, 1, 1);
+    form->addWidget(windowSpin, 1, 2);
+
+    plot = new TelemetryPlot(&decoder, this);
+    plot->setWindow(windowSpin->value());
+    connect(windowSpin, SIGNAL(valueChanged(int)), this, SLOT(windowChanged(int)));
+
+    QHBoxLayout *buttons = new QHBoxLayout();
+    startBtn = new QPushButton(tr("Start"), this);
+    stopBtn = new QPushButton(tr("Stop"), this);
+    QPushButton *closeBtn = new QPushButton(tr("Close"), this);
+    connect(startBtn, SIGNAL(clicked()), this, SLOT(start()));
+    connect(stopBtn, SIGNAL(clicked()), this, SLOT(stop()));
+    connect(closeBtn, SIGNAL(clicked()), this, SLOT(reject()));
+    startBtn->setAutoDefault(false);
+    stopBtn->setAutoDefault(false);
+    closeBtn->setAutoDefault(false);
+    stopBtn->setEnabled(false);
+    buttons->addWidget(startBtn);
+    buttons->addWidget(stopBtn);
+    buttons->addStretch(100);
+    buttons->addWidget(closeBtn);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addLayout(form);
+    layout->addWidget(plot, 100);
+    layout->addLayout(buttons);
+    setLayout(layout);
+    resize(700,450);
+}
+
+/*
+ * The listener must not keep feeding a decoder that's going away.
+ */
+TelemetryDialog::~TelemetryDialog()
+{
+    stop();
+}
+
+void TelemetryDialog::setPortListener(PortListener *listener)
+{
+    this->listener = listener;
+}
+
+void TelemetryDialog::start()
+{
+    if(listener == NULL)
+        return;
+
+    QString error;
+    if(!decoder.setLayout(syncEdit->text(), fieldsEdit->text(), bigEndianBox->isChecked(), &error)) {
+        QMessageBox::critical(this, tr("Frame Layout"), error);
+        return;
+    }
+
+    QSettings settings(publisherKey, ASideGuiKey);
+    settings.setValue(termKeyPlotSync, syncEdit->text());
+    settings.setValue(termKeyPlotFields, fieldsEdit->text());
+    settings.setValue(termKeyPlotBigEndian, bigEndianBox->isChecked());
+    settings.setValue(termKeyPlotWindow, windowSpin->value());
+
+    listener->setFrameDecoder(&decoder);
+    startBtn->setEnabled(false);
+    stopBtn->setEnabled(true);
+    syncEdit->setEnabled(false);
+    fieldsEdit->setEnabled(false);
+    bigEndianBox->setEnabled(false);
+}
+
+/*
+ * Give the port back to the console. The plot keeps the last frames.
+ */
+void TelemetryDialog::stop()
+{
+    if(listener != NULL)
+        listener->setFrameDecoder(NULL);
+    startBtn->setEnabled(true);
+    stopBtn->setEnabled(false);
+    syncEdit->setEnabled(true);
+    fieldsEdit->setEnabled(true);
+    bigEndianBox->setEnabled(true);
+}
+
+void TelemetryDialog::windowChanged(int frames)
+{
+    plot->setWindow(frames);
+}
+
+void TelemetryDialog::reject()
+{
+    stop();
+    QDialog::reject();
+}
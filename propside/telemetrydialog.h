@@ -0,0 +1,62 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TELEMETRYDIALOG_H
+#define TELEMETRYDIALOG_H
+
+#include "qtversion.h"
+#include "PortListener.h"
+#include "framedecoder.h"
+#include "telemetryplot.h"
+
+/*
+ * Terminal plot mode.
+ * While running, the terminal's PortListener hands received bytes to
+ * a FrameDecoder instead of the console, and the fields are plotted.
+ */
+class TelemetryDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit TelemetryDialog(QWidget *parent = 0);
+    ~TelemetryDialog();
+    void setPortListener(PortListener *listener);
+
+public slots:
+    void start();
+    void stop();
+    void reject();
+
+private slots:
+    void windowChanged(int frames);
+
+private:
+    PortListener    *listener;
+    FrameDecoder    decoder;
+    TelemetryPlot   *plot;
+
+    QLineEdit   *syncEdit;
+    QLineEdit   *fieldsEdit;
+    QCheckBox   *bigEndianBox;
+    QSpinBox    *windowSpin;
+    QPushButton *startBtn;
+    QPushButton *stopBtn;
+};
+
+#endif // TELEMETRYDIALOG_H
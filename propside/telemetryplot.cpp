@@ -0,0 +1,118 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "telemetryplot.h"
+
+#define PLOT_REFRESH_MS 33
+
+static const QColor plotColors[] = {
+    QColor(Qt::yellow), QColor(Qt::cyan), QColor(Qt::magenta), QColor(Qt::green),
+    QColor(255,128,0), QColor(Qt::white), QColor(128,128,255), QColor(Qt::red)
+};
+
+TelemetryPlot::TelemetryPlot(FrameDecoder *decoder, QWidget *parent) :
+    QWidget(parent)
+{
+    this->decoder = decoder;
+    window = 10000;
+    lastFrames = -1;
+    setMinimumSize(320,200);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    connect(&timer, SIGNAL(timeout()), this, SLOT(refresh()));
+    timer.start(PLOT_REFRESH_MS);
+}
+
+/*
+ * Number of most recent frames shown across the width of the plot.
+ */
+void TelemetryPlot::setWindow(int frames)
+{
+    window = (frames > 1) ? frames : 2;
+    update();
+}
+
+void TelemetryPlot::refresh()
+{
+    qint64 frames = decoder->frameCount();
+    if(frames != lastFrames && isVisible()) {
+        lastFrames = frames;
+        update();
+    }
+}
+
+void TelemetryPlot::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+
+    QFontMetrics fm(font());
+    int top = fm.height() + 4;
+    int bottom = height() - fm.height() - 4;
+    int left = 4;
+    int plotWidth = width() - 2*left;
+    int plotHeight = bottom - top;
+    if(plotWidth < 2 || plotHeight < 2)
+        return;
+
+    painter.setPen(QColor(64,64,64));
+    painter.drawRect(left, top, plotWidth, plotHeight);
+
+    double lo, hi;
+    if(!decoder->range(window, &lo, &hi)) {
+        painter.setPen(Qt::gray);
+        painter.drawText(rect(), Qt::AlignCenter, tr("Waiting for frames"));
+        return;
+    }
+    if(hi == lo) {
+        hi += 1;
+        lo -= 1;
+    }
+    double scale = plotHeight / (hi - lo);
+
+    int colorCount = sizeof(plotColors)/sizeof(plotColors[0]);
+    int legend = left;
+    for(int c = 0; c < decoder->channelCount(); c++) {
+        int cols = decoder->decimate(c, window, plotWidth, mins, maxs);
+        QColor color = plotColors[c % colorCount];
+        painter.setPen(color);
+        int lastY = -1;
+        for(int col = 0; col < cols; col++) {
+            int x = left + (cols > 1 ? col * (plotWidth-1) / (cols-1) : 0);
+            int y1 = bottom - int((maxs[col] - lo) * scale);
+            int y2 = bottom - int((mins[col] - lo) * scale);
+            /* join to the previous column so slow signals stay continuous */
+            if(lastY > -1) {
+                if(lastY < y1) y1 = lastY;
+                if(lastY > y2) y2 = lastY;
+            }
+            painter.drawLine(x, y1, x, y2);
+            lastY = bottom - int(((mins[col] + maxs[col]) / 2 - lo) * scale);
+        }
+        QString name = decoder->channelName(c);
+        painter.drawText(legend, fm.ascent() + 2, name);
+        legend += fm.width(name) + fm.width("  ");
+    }
+
+    painter.setPen(Qt::lightGray);
+    painter.drawText(QRect(left, 2, plotWidth, fm.height()), Qt::AlignRight, QString::number(hi, 'g', 6));
+    painter.drawText(QRect(left, bottom + 2, plotWidth, fm.height()), Qt::AlignRight, QString::number(lo, 'g', 6));
+    painter.drawText(left, bottom + 2 + fm.ascent(),
+        tr("%1 frames  %2 sync errors").arg(decoder->frameCount()).arg(decoder->syncErrors()));
+}
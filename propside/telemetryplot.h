@@ -0,0 +1,55 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TELEMETRYPLOT_H
+#define TELEMETRYPLOT_H
+
+#include "qtversion.h"
+#include "framedecoder.h"
+
+/*
+ * Rolling plot of the fields a FrameDecoder has collected.
+ * Each pixel column draws the min/max of the frames that fall in it,
+ * so a window of hundreds of thousands of samples costs one line per
+ * column. Repaints at most 30 times a second and only when new frames
+ * have arrived.
+ */
+class TelemetryPlot : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit TelemetryPlot(FrameDecoder *decoder, QWidget *parent = 0);
+    void setWindow(int frames);
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private slots:
+    void refresh();
+
+private:
+    FrameDecoder    *decoder;
+    int             window;
+    qint64          lastFrames;
+    QTimer          timer;
+    QVector<double> mins;
+    QVector<double> maxs;
+};
+
+#endif // TELEMETRYPLOT_H
@@ -0,0 +1,217 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "termbuffer.h"
+
+TermBuffer::TermBuffer()
+{
+    wrap = 0;
+    tabsize = 8;
+    clear();
+}
+
+ConsoleDecoder &TermBuffer::decoder()
+{
+    return dec;
+}
+
+void TermBuffer::setPlainMode()
+{
+    for(int n = 0; n < ConsoleDecoder::CODE_LAST; n++)
+        dec.setEnable(n, false);
+    dec.setEnable(8, true);
+    dec.setEnable(9, true);
+    dec.setEnable(ConsoleDecoder::CODE_CRETURN, true);
+    dec.setEnable(ConsoleDecoder::CODE_NEWLINE, true);
+    /* LF is the newline, CR goes back to the start of the line */
+    dec.setSwapNLCR(true);
+}
+
+/*
+ * Start a new line before printing past this column, 0 for never.
+ */
+void TermBuffer::setWrap(int columns)
+{
+    wrap = columns > 0 ? columns : 0;
+}
+
+void TermBuffer::setTabSize(int size)
+{
+    tabsize = size > 0 ? size : 1;
+}
+
+void TermBuffer::clear()
+{
+    dec.reset();
+    line.clear();
+    out.clear();
+    col = 0;
+    keep = 0;
+    shown = 0;
+    broke = false;
+    dirty = false;
+    tail = true;
+}
+
+void TermBuffer::write(View *view, const char *data, int length)
+{
+    /* someone else wrote to the view since the last batch */
+    if(tail && view->lastLineLength() != shown)
+        tail = false;
+
+    ConsoleDecoder::Op op;
+    for(int n = 0; n < length; n++) {
+        if(dec.decode((unsigned char) data[n], &op))
+            process(view, op);
+    }
+    flush(view);
+}
+
+/*
+ * The view's last line has changed from pos on.
+ */
+void TermBuffer::changed(int pos)
+{
+    if(!broke && pos < keep)
+        keep = pos;
+    dirty = true;
+}
+
+void TermBuffer::print(unsigned int ch)
+{
+    if(wrap > 0 && col >= wrap)
+        newLine();
+    if(col < (int) line.size()) {
+        line[col] = ch;
+        changed(col);
+    }
+    else {
+        line.push_back(ch);
+        dirty = true;
+    }
+    col++;
+}
+
+/*
+ * The line is finished as it stands, whatever the cursor column.
+ */
+void TermBuffer::newLine()
+{
+    out.insert(out.end(), line.begin() + (broke ? 0 : keep), line.end());
+    out.push_back('\n');
+    broke = true;
+    dirty = true;
+    line.clear();
+    col = 0;
+}
+
+void TermBuffer::process(View *view, ConsoleDecoder::Op &op)
+{
+    if(op.op == ConsoleDecoder::OP_CLEAR) {
+        clear();
+        view->clearAll();
+        return;
+    }
+    if(op.op == ConsoleDecoder::OP_BEEP) {
+        view->apply(op);
+        return;
+    }
+
+    if(!tail) {
+        tail = view->cursorOnLastLine(line, col);
+        keep = line.size();
+        shown = line.size();
+    }
+
+    if(tail) {
+        switch(op.op) {
+            case ConsoleDecoder::OP_PRINT:
+                print(op.ch);
+                return;
+
+            case ConsoleDecoder::OP_TAB: {
+                    if(wrap > 0 && col >= wrap)
+                        newLine();
+                    int spaces = tabsize - col % tabsize;
+                    line.insert(line.begin() + col, spaces, ' ');
+                    changed(col);
+                    col += spaces;
+                }
+                return;
+
+            case ConsoleDecoder::OP_BACKSPACE:
+                /* removes the last character, never the line break before it */
+                if(line.size() > 0) {
+                    line.pop_back();
+                    changed(line.size());
+                    if(col > (int) line.size())
+                        col = line.size();
+                }
+                return;
+
+            case ConsoleDecoder::OP_CRETURN:
+                col = 0;
+                dirty = true;
+                return;
+
+            case ConsoleDecoder::OP_NEWLINE:
+                newLine();
+                return;
+
+            case ConsoleDecoder::OP_LEFT:
+                col = (col > op.count) ? col - op.count : 0;
+                dirty = true;
+                return;
+
+            case ConsoleDecoder::OP_RIGHT:
+                col += op.count;
+                if(col > (int) line.size())
+                    line.resize(col, ' ');
+                dirty = true;
+                return;
+
+            case ConsoleDecoder::OP_CLEAR_EOL:
+                if(col < (int) line.size()) {
+                    line.resize(col);
+                    changed(col);
+                }
+                return;
+
+            default:
+                break;
+        }
+    }
+
+    flush(view);
+    view->apply(op);
+    tail = false;
+}
+
+void TermBuffer::flush(View *view)
+{
+    if(!dirty)
+        return;
+    out.insert(out.end(), line.begin() + (broke ? 0 : keep), line.end());
+    view->replaceTail(shown - keep, out, line.size() - col);
+    out.clear();
+    keep = line.size();
+    shown = line.size();
+    broke = false;
+    dirty = false;
+}
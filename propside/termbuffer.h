@@ -0,0 +1,112 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TERMBUFFER_H
+#define TERMBUFFER_H
+
+#include <vector>
+#include "consoledecoder.h"
+
+/*
+ * Terminal text engine shared by the console and the loader window.
+ *
+ * Received bytes are decoded by ConsoleDecoder. Printing, backspace,
+ * CR, tab and newline only change the last line, so they are applied
+ * to a copy of that line and handed to the view once per write()
+ * instead of once per character. Anything else, such as cursor
+ * positioning, ends the batch and is carried out by the view.
+ *
+ * There is no Qt here so the engine can be tested on its own,
+ * see tools/termbuffertest.cpp. TermView is the QPlainTextEdit side.
+ */
+class TermBuffer
+{
+public:
+    typedef std::vector<unsigned int> Text;
+
+    class View
+    {
+    public:
+        virtual ~View() {}
+
+        /**
+         * Remove characters from the end of the last line, insert text,
+         * which may hold newlines, and leave the cursor back characters
+         * before the end.
+         */
+        virtual void replaceTail(int remove, const Text &text, int back) = 0;
+        virtual void clearAll() = 0;
+
+        /**
+         * Carry out an operation at the view's own cursor.
+         */
+        virtual void apply(ConsoleDecoder::Op &op) = 0;
+
+        /**
+         * @param line - gets the last line's text
+         * @param column - gets the cursor column
+         * @returns false if the cursor is not on the last line
+         */
+        virtual bool cursorOnLastLine(Text &line, int &column) = 0;
+        virtual int  lastLineLength() = 0;
+    };
+
+    TermBuffer();
+
+    ConsoleDecoder &decoder();
+
+    /*
+     * Only backspace, tab, CR and NL do anything, the way
+     * compiler and loader output is written.
+     */
+    void setPlainMode();
+    void setWrap(int columns);
+    void setTabSize(int size);
+
+    /**
+     * Decode data and show it in view.
+     */
+    void write(View *view, const char *data, int length);
+
+    /*
+     * The view was emptied.
+     */
+    void clear();
+
+private:
+    void process(View *view, ConsoleDecoder::Op &op);
+    void changed(int pos);
+    void print(unsigned int ch);
+    void newLine();
+    void flush(View *view);
+
+    ConsoleDecoder dec;
+    Text line;      // the last line as it should be shown
+    Text out;       // what flush() hands the view
+    int  col;       // cursor column in line
+    int  keep;      // leading characters of the view's last line still valid
+    int  shown;     // length of the view's last line
+    bool broke;     // out holds finished lines
+    bool dirty;     // something to flush
+    bool tail;      // line and col match the view
+    int  wrap;
+    int  tabsize;
+};
+
+#endif // TERMBUFFER_H
@@ -23,12 +23,20 @@
 #define TERM_ENABLE_BUTTON
 //#endif
 
-Terminal::Terminal(QWidget *parent) : QDialog(parent), portListener(NULL), lastConnectedPortName("")
+Terminal::Terminal(QWidget *parent) : QDialog(parent), portListener(NULL), search(NULL), plot(NULL), saveGeo(true), lastConnectedPortName(""), sendLineDelay(0)
 {
     termEditor = new Console(parent);
     init();
 }
 
+/*
+ * The history search may still be reading the console's scrollback.
+ */
+Terminal::~Terminal()
+{
+    delete search;
+}
+
 void Terminal::init()
 {
     QVBoxLayout *termLayout = new QVBoxLayout();
@@ -45,12 +53,29 @@ void Terminal::init()
     termEditor->setMaximumBlockCount(512);
     termLayout->addWidget(termEditor);
 
+    /* I/O meters; right click saves the samples */
+    statsLabel = new QLabel(this);
+    statsLabel->setContextMenuPolicy(Qt::ActionsContextMenu);
+    statsLabel->setToolTip(tr("Right click to save statistics"));
+    QAction *csvAction = new QAction(tr("Save Statistics As CSV ..."),this);
+    connect(csvAction,SIGNAL(triggered()),this,SLOT(saveStats()));
+    statsLabel->addAction(csvAction);
+    termLayout->addWidget(statsLabel);
+    stats = new TermStats(termEditor, this);
+    connect(stats,SIGNAL(updated(QString)),statsLabel,SLOT(setText(QString)));
+
     QPushButton *buttonClear = new QPushButton(tr("Clear"),this);
     connect(buttonClear,SIGNAL(clicked()), this, SLOT(clearScreen()));
     buttonClear->setAutoDefault(false);
     buttonClear->setDefault(false);
 
     comboBoxBaud = new QComboBox(this);
+    comboBoxBaud->addItem("3000000", QVariant(3000000));
+    comboBoxBaud->addItem("2000000", QVariant(2000000));
+    comboBoxBaud->addItem("1000000", QVariant(1000000));
+    comboBoxBaud->addItem("921600", QVariant(921600));
+    comboBoxBaud->addItem("460800", QVariant(460800));
+    comboBoxBaud->addItem("230400", QVariant(230400));
     comboBoxBaud->addItem("115200", QVariant(BAUD115200));
     comboBoxBaud->addItem("57600", QVariant(BAUD57600));
     comboBoxBaud->addItem("38400", QVariant(BAUD38400));
@@ -59,6 +84,7 @@ void Terminal::init()
     comboBoxBaud->addItem("4800", QVariant(BAUD4800));
     comboBoxBaud->addItem("2400", QVariant(BAUD2400));
     comboBoxBaud->addItem("1200", QVariant(BAUD1200));
+    comboBoxBaud->setCurrentIndex(comboBoxBaud->findData(BAUD115200));
     connect(comboBoxBaud,SIGNAL(currentIndexChanged(int)),this,SLOT(baudRateChange(int)));
 
     cbEchoOn = new QCheckBox(tr("Echo On"),this);
@@ -72,6 +98,30 @@ void Terminal::init()
     buttonOpt->setAutoDefault(false);
     buttonOpt->setDefault(false);
 
+    QPushButton *buttonSend = new QPushButton(tr("Send File"),this);
+    connect(buttonSend,SIGNAL(clicked()), this, SLOT(sendFile()));
+    buttonSend->setAutoDefault(false);
+    buttonSend->setDefault(false);
+
+    buttonCapture = new QPushButton(tr("Capture"),this);
+    buttonCapture->setCheckable(true);
+    buttonCapture->setToolTip(tr("Save received data to a file"));
+    connect(buttonCapture,SIGNAL(toggled(bool)), this, SLOT(captureToFile(bool)));
+    buttonCapture->setAutoDefault(false);
+    buttonCapture->setDefault(false);
+
+    QPushButton *buttonPlot = new QPushButton(tr("Plot"),this);
+    buttonPlot->setToolTip(tr("Decode binary frames and plot them"));
+    connect(buttonPlot,SIGNAL(clicked()), this, SLOT(showPlot()));
+    buttonPlot->setAutoDefault(false);
+    buttonPlot->setDefault(false);
+
+    QPushButton *buttonFind = new QPushButton(tr("Find"),this);
+    buttonFind->setToolTip(tr("Search everything this terminal has received"));
+    connect(buttonFind,SIGNAL(clicked()), this, SLOT(searchHistory()));
+    buttonFind->setAutoDefault(false);
+    buttonFind->setDefault(false);
+
 #ifdef TERM_ENABLE_BUTTON
     buttonEnable = new QPushButton(tr("Disable"),this);
     connect(buttonEnable,SIGNAL(clicked()), this, SLOT(toggleEnable()));
@@ -90,12 +140,17 @@ void Terminal::init()
     termLayout->addLayout(butLayout);
     butLayout->addWidget(buttonClear);
     butLayout->addWidget(buttonOpt);
+    butLayout->addWidget(buttonSend);
+    butLayout->addWidget(buttonCapture);
+    butLayout->addWidget(buttonFind);
+    butLayout->addWidget(buttonPlot);
 #ifdef TERM_ENABLE_BUTTON
     butLayout->addWidget(buttonEnable);
 #endif
     butLayout->addWidget(comboBoxBaud);
     butLayout->addWidget(&portLabel);
     portLabel.setFont(QFont("System", 14));
+    butLayout->addWidget(&sendLabel);
     butLayout->addWidget(cbEchoOn);
     butLayout->addWidget(buttonBox);
     setLayout(termLayout);
@@ -114,6 +169,11 @@ Console *Terminal::getEditor()
 void Terminal::setPortListener(PortListener *listener)
 {
     portListener = listener;
+    portListener->setSendLineDelay(sendLineDelay);
+    stats->setPortListener(listener);
+    connect(portListener,SIGNAL(sendProgress(qint64,qint64)),this,SLOT(sendProgress(qint64,qint64)));
+    connect(portListener,SIGNAL(sendFinished(qint64,qint64)),this,SLOT(sendFinished(qint64,qint64)));
+    connect(portListener,SIGNAL(sendFailed(qint64,qint64)),this,SLOT(sendFailed(qint64,qint64)));
     if(listener->getPortName().isEmpty() == false)
         portLabel.setText(listener->getPortName());
     else
@@ -142,6 +202,8 @@ void Terminal::baudRateChange(int index)
     QVariant var = comboBoxBaud->itemData(index);
     bool ok;
     int baud = var.toInt(&ok);
+    if(portListener == NULL)
+        return;
     portListener->init(portListener->getPortName(), (BaudRateType) baud);
     // saving the baud rate is not currently working (dbetz)
     //options->saveBaudRate(baud);
@@ -174,6 +236,13 @@ bool Terminal::setBaudRate(int baud)
             return true;
         }
     }
+    /* any other rate (from a board config say) is added to the list;
+       the serial port programs non-standard rates directly */
+    if(baud > 0) {
+        comboBoxBaud->addItem(QString::number(baud), QVariant(baud));
+        comboBoxBaud->setCurrentIndex(comboBoxBaud->count()-1);
+        return true;
+    }
     return false;
 }
 
@@ -189,6 +258,33 @@ void Terminal::setEchoOn(bool echoOn)
     cbEchoOn->setChecked(echoOn);
 }
 
+void Terminal::sendPortMessage(QString s)
+{
+    QByteArray barry = s.toUtf8();
+    if(portListener != NULL)
+        portListener->send(barry);
+}
+
+PortListener *Terminal::getPortListener()
+{
+    return portListener;
+}
+
+/*
+ * Only the main terminal remembers its geometry; sessions live in a tiled area.
+ */
+void Terminal::setSaveGeometry(bool save)
+{
+    saveGeo = save;
+}
+
+void Terminal::setSendLineDelay(int ms)
+{
+    sendLineDelay = ms;
+    if(portListener != NULL)
+        portListener->setSendLineDelay(ms);
+}
+
 void Terminal::accept()
 {
 #ifdef TERM_ENABLE_BUTTON
@@ -196,10 +292,11 @@ void Terminal::accept()
 #endif
     // save terminal geometry
     QSettings *settings = new QSettings(publisherKey, ASideGuiKey, this);
-    if(settings->value(useKeys).toInt() == 1) {
+    if(saveGeo && settings->value(useKeys).toInt() == 1) {
         QByteArray geo = this->saveGeometry();
         settings->setValue(termGeometryKey,geo);
     }
+    buttonCapture->setChecked(false);
     termEditor->setPortEnable(false);
     portLabel.setEnabled(false);
     done(QDialog::Accepted);
@@ -211,9 +308,12 @@ void Terminal::reject()
     buttonEnable->setText("Disable");
 #endif
     // save terminal geometry
-    QSettings *settings = new QSettings(publisherKey, ASideGuiKey, this);
-    QByteArray geo = this->saveGeometry();
-    settings->setValue(termGeometryKey,geo);
+    if(saveGeo) {
+        QSettings *settings = new QSettings(publisherKey, ASideGuiKey, this);
+        QByteArray geo = this->saveGeometry();
+        settings->setValue(termGeometryKey,geo);
+    }
+    buttonCapture->setChecked(false);
     termEditor->setPortEnable(false);
     portLabel.setEnabled(false);
     done(QDialog::Rejected);
@@ -301,3 +401,103 @@ void Terminal::showOptions()
 {
     options->showDialog();
 }
+
+void Terminal::sendFile()
+{
+    if(portListener == NULL || !portListener->isOpen()) {
+        QMessageBox::information(this, tr("Send File"), tr("Please enable the terminal port before sending a file."));
+        return;
+    }
+    if(portListener->isSending()) {
+        portListener->cancelSend();
+        return;
+    }
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Send File"));
+    if(fileName.isEmpty())
+        return;
+    if(!portListener->sendFile(fileName)) {
+        QMessageBox::critical(this, tr("Send File"), tr("Can't open file %1").arg(fileName));
+    }
+    termEditor->setFocus(Qt::OtherFocusReason);
+}
+
+/*
+ * Start or stop saving received data. Each terminal has its own file.
+ */
+void Terminal::captureToFile(bool enable)
+{
+    termEditor->setCapture(NULL);
+    if(captureFile.isOpen())
+        captureFile.close();
+    buttonCapture->setText(tr("Capture"));
+    if(!enable)
+        return;
+
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Capture To File"));
+    if(fileName.isEmpty()) {
+        buttonCapture->setChecked(false);
+        return;
+    }
+    captureFile.setFileName(fileName);
+    if(!captureFile.open(QFile::WriteOnly)) {
+        QMessageBox::critical(this, tr("Capture To File"), tr("Can't open file %1").arg(fileName));
+        buttonCapture->setChecked(false);
+        return;
+    }
+    termEditor->setCapture(&captureFile);
+    buttonCapture->setText(tr("Stop Capture"));
+}
+
+void Terminal::searchHistory()
+{
+    if(search == NULL)
+        search = new TermSearch(termEditor, this);
+    search->show();
+    search->raise();
+    search->activateWindow();
+}
+
+void Terminal::showPlot()
+{
+    if(plot == NULL)
+        plot = new TelemetryDialog(this);
+    plot->setPortListener(portListener);
+    plot->show();
+    plot->raise();
+    plot->activateWindow();
+}
+
+void Terminal::saveStats()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save Statistics"), "", "CSV (*.csv)");
+    if(fileName.isEmpty())
+        return;
+    if(!stats->saveCsv(fileName))
+        QMessageBox::critical(this, tr("Save Statistics"), tr("Can't save file %1").arg(fileName));
+}
+
+void Terminal::sendProgress(qint64 sent, qint64 total)
+{
+    if(total > 0)
+        sendLabel.setText(QString("%1%").arg(sent*100/total));
+}
+
+/*
+ * Only show the rate for pastes and files, not single keystrokes.
+ */
+void Terminal::sendFinished(qint64 sent, qint64 bytesPerSecond)
+{
+    if(sent > 1)
+        sendLabel.setText(tr("%1 bytes %2 B/s").arg(sent).arg(bytesPerSecond));
+}
+
+/*
+ * The port stopped accepting data. Say how far the transfer got.
+ */
+void Terminal::sendFailed(qint64 sent, qint64 total)
+{
+    sendLabel.setText(tr("Send failed"));
+    if(total > 1)
+        QMessageBox::warning(this, tr("Send Failed"),
+            tr("The port stopped accepting data after %1 of %2 bytes.").arg(sent).arg(total));
+}
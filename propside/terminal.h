@@ -28,12 +28,16 @@ class Terminal;
 #include "PortListener.h"
 #include "loader.h"
 #include "termprefs.h"
+#include "termsearch.h"
+#include "termstats.h"
+#include "telemetrydialog.h"
 
 class Terminal : public QDialog
 {
     Q_OBJECT
 public:
     explicit Terminal(QWidget *parent);
+    ~Terminal();
     void setPortListener(PortListener *listener);
     QString getPortName();
     void setPortName(QString name);
@@ -45,6 +49,10 @@ public:
     int  getBaudRate();
     bool setBaudRate(int baud);
     void setEchoOn(bool echoOn);
+    void setSendLineDelay(int ms);
+    void sendPortMessage(QString s);
+    PortListener *getPortListener();
+    void setSaveGeometry(bool save);
 
     QString getLastConnectedPortName();
     void setLastConnectedPortName(QString name);
@@ -66,6 +74,14 @@ public slots:
     void cutFromFile();
     void pasteToFile();
     void showOptions();
+    void sendFile();
+    void captureToFile(bool enable);
+    void searchHistory();
+    void saveStats();
+    void showPlot();
+    void sendProgress(qint64 sent, qint64 total);
+    void sendFinished(qint64 sent, qint64 bytesPerSecond);
+    void sendFailed(qint64 sent, qint64 total);
 
 public:
     Console *getEditor();
@@ -75,12 +91,21 @@ private:
     QComboBox   *comboBoxBaud;
     QCheckBox   *cbEchoOn;
     QLabel      portLabel;
+    QLabel      sendLabel;
 
 private:
     QPushButton     *buttonEnable;
+    QPushButton     *buttonCapture;
     PortListener    *portListener;
+    QFile           captureFile;
+    TermSearch      *search;
+    TermStats       *stats;
+    TelemetryDialog *plot;
+    QLabel          *statsLabel;
+    bool            saveGeo;
 
     QString lastConnectedPortName;
+    int     sendLineDelay;
 };
 
 #endif // TERMINAL_H
@@ -261,6 +261,13 @@ void TermPrefs::saveSettings()
     serialConsole->setEnableSwapNLCR(enableSwap);
     settings->setValue(enableKeySwapNLCR,enableSwap);
 
+    /*
+     * get enable ANSI escape sequences and save.
+     */
+    bool enableANSI = ui->cbANSI->isChecked();
+    serialConsole->setEnableANSI(enableANSI);
+    settings->setValue(enableKeyANSI,enableANSI);
+
 
     /*
      * get foreground and background colors and save.
@@ -344,6 +351,12 @@ void TermPrefs::saveSettings()
     else
         ui->checkBoxHexDump->setEnabled(true);
 
+    /*
+     * save send line delay for devices without flow control
+     */
+    int delay = ui->spinBoxSendLineDelay->value();
+    settings->setValue(termKeySendLineDelay, delay);
+    terminal->setSendLineDelay(delay);
 }
 
 /*
@@ -468,6 +481,14 @@ void TermPrefs::readSettings()
     ui->cbSwapNLCR->setChecked(enableSwap);
     serialConsole->setEnableSwapNLCR(enableSwap);
 
+    /*
+     * read user's ANSI escape sequence preference.
+     */
+    var = settings->value(enableKeyANSI,QVariant(false));
+    bool enableANSI = var.canConvert(QVariant::Bool) ? var.toBool() : false;
+    ui->cbANSI->setChecked(enableANSI);
+    serialConsole->setEnableANSI(enableANSI);
+
 
     /*
      * read users background setting
@@ -630,6 +651,12 @@ void TermPrefs::readSettings()
     else
         ui->checkBoxHexDump->setEnabled(true);
 
+    /*
+     * read send line delay
+     */
+    int delay = getSendLineDelay();
+    ui->spinBoxSendLineDelay->setValue(delay);
+    terminal->setSendLineDelay(delay);
 }
 
 void TermPrefs::hexDump(bool hex)
@@ -681,4 +708,7 @@ void TermPrefs::saveEchoOn(bool echoOn)
     settings->sync();
 }
 
-
+int TermPrefs::getSendLineDelay()
+{
+    return settings->value(termKeySendLineDelay,QVariant(0)).toInt();
+}
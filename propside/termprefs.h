@@ -49,6 +49,7 @@ class TermPrefs;
 #define enableKeyPosCursorX         appNameKey "_enablePosCursorX"
 #define enableKeyPosCursorY         appNameKey "_enablePosCursorY"
 #define enableKeySwapNLCR           appNameKey "_enableSwapNLCR"
+#define enableKeyANSI               appNameKey "_enableANSI"
 #define enableKeyAddNLtoCR          appNameKey "_enableAddNLtoCR"
 #define enableKeyEnterIsNL          appNameKey "_enableEnterIsNL"
 
@@ -64,10 +65,16 @@ class TermPrefs;
 #define termKeyTabSize              appNameKey "_termTabSize"
 #define termKeyHexMode              appNameKey "_termHexMode"
 #define termKeyHexDump              appNameKey "_termHexDumpMode"
+#define termKeySendLineDelay        appNameKey "_termSendLineDelay"
 
 #define termKeyEchoOn               appNameKey "_termEchoOn"
 #define termKeyBaudRate             appNameKey "_termBaudRate"
 
+#define termKeyPlotSync             appNameKey "_termPlotSync"
+#define termKeyPlotFields           appNameKey "_termPlotFields"
+#define termKeyPlotBigEndian        appNameKey "_termPlotBigEndian"
+#define termKeyPlotWindow           appNameKey "_termPlotWindow"
+
 namespace Ui {
     class TermPrefs;
 }
@@ -86,6 +93,7 @@ public:
     void saveBaudRate(int baud);
     bool  getEchoOn();
     void saveEchoOn(bool echoOn);
+    int  getSendLineDelay();
 
     void showDialog();
 
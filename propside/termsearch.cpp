@@ -0,0 +1,230 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "termsearch.h"
+
+/* lines shown either side of a hit */
+#define SEARCH_CONTEXT_LINES 40
+
+/*
+ * Scans the history on a pool thread and hands the hits and their text
+ * back to the dialog.
+ */
+class TermSearchJob : public QRunnable
+{
+public:
+    TermSearchJob(TermSearch *dialog, ScrollBack *history, QAtomicInt *current, int gen,
+                  const QString &pattern, bool regex, bool caseSensitive)
+        : dialog(dialog), history(history), current(current), gen(gen),
+          pattern(pattern), regex(regex), caseSensitive(caseSensitive)
+    {
+    }
+
+    void run()
+    {
+        QElapsedTimer timer;
+        timer.start();
+        QList<int> hits = history->search(pattern, regex, caseSensitive, 10000, current, gen);
+
+        QVariantList lines;
+        QStringList texts;
+        foreach(int n, hits) {
+            if(current->fetchAndAddRelaxed(0) != gen)
+                return;
+            lines.append(n);
+            texts.append(history->line(n));
+        }
+        QMetaObject::invokeMethod(dialog, "searchDone", Qt::QueuedConnection,
+            Q_ARG(int, gen), Q_ARG(QVariantList, lines), Q_ARG(QStringList, texts),
+            Q_ARG(qint64, timer.elapsed()));
+    }
+
+private:
+    TermSearch  *dialog;
+    ScrollBack  *history;
+    QAtomicInt  *current;
+    int         gen;
+    QString     pattern;
+    bool        regex;
+    bool        caseSensitive;
+};
+
+TermSearch::TermSearch(Console *console, QWidget *parent) :
+    QDialog(parent)
+{
+    this->console = console;
+    contextFirst = 0;
+    generation = 0;
+    pool.setMaxThreadCount(1);
+    setWindowTitle(tr("Search Terminal History"));
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    QHBoxLayout *findRow = new QHBoxLayout();
+    patternEdit = new QLineEdit(this);
+    regexBox = new QCheckBox(tr("Regular Expression"), this);
+    caseBox = new QCheckBox(tr("Match Case"), this);
+    QPushButton *findBtn = new QPushButton(tr("Find"), this);
+    connect(patternEdit, SIGNAL(returnPressed()), this, SLOT(find()));
+    connect(findBtn, SIGNAL(clicked()), this, SLOT(find()));
+    findBtn->setAutoDefault(false);
+    findRow->addWidget(patternEdit);
+    findRow->addWidget(regexBox);
+    findRow->addWidget(caseBox);
+    findRow->addWidget(findBtn);
+    layout->addLayout(findRow);
+
+    summary = new QLabel(this);
+    layout->addWidget(summary);
+
+    QSplitter *split = new QSplitter(Qt::Vertical, this);
+    hitList = new QListWidget(split);
+    context = new QPlainTextEdit(split);
+    context->setReadOnly(true);
+    context->setLineWrapMode(QPlainTextEdit::NoWrap);
+    context->setFont(console->font());
+    connect(hitList, SIGNAL(currentRowChanged(int)), this, SLOT(showHit(int)));
+    layout->addWidget(split);
+
+    setLayout(layout);
+    resize(700,500);
+}
+
+/*
+ * The console must outlive its history search, so the owner deletes
+ * this dialog before the console.
+ */
+TermSearch::~TermSearch()
+{
+    current.fetchAndStoreRelaxed(-1);
+    pool.waitForDone();
+}
+
+void TermSearch::find()
+{
+    QString pattern = patternEdit->text();
+    bool regex = regexBox->isChecked();
+    bool cs = caseBox->isChecked();
+
+    generation++;
+    current.fetchAndStoreRelaxed(generation);
+    hits.clear();
+    hitList->clear();
+    context->clear();
+
+    if(regex && !QRegExp(pattern).isValid()) {
+        summary->setText(tr("Invalid regular expression."));
+        return;
+    }
+
+    summary->setText(tr("Searching..."));
+    console->highlightAll(pattern, regex, cs);
+    pool.start(new TermSearchJob(this, console->getScrollBack(), &current, generation,
+            pattern, regex, cs));
+}
+
+/*
+ * Results of the search numbered gen, unless a newer one has started.
+ */
+void TermSearch::searchDone(int gen, QVariantList lines, QStringList texts, qint64 ms)
+{
+    if(gen != generation)
+        return;
+
+    hitList->clear();
+    for(int n = 0; n < lines.count(); n++) {
+        hits.append(lines[n].toInt());
+        hitList->addItem(QString("%1: %2").arg(hits[n]+1).arg(texts[n]));
+    }
+    summary->setText(tr("%1 matching lines of %2 (%3 ms)")
+            .arg(hits.count()).arg(console->getScrollBack()->lineCount()).arg(ms));
+
+    if(hits.count() > 0)
+        hitList->setCurrentRow(hits.count()-1);
+}
+
+/*
+ * Show the lines around a hit and bring the console to it if possible.
+ */
+void TermSearch::showHit(int row)
+{
+    if(row < 0 || row >= hits.count())
+        return;
+
+    ScrollBack *history = console->getScrollBack();
+    int hitLine = hits[row];
+    contextFirst = qMax(0, hitLine - SEARCH_CONTEXT_LINES);
+    int last = qMin(history->lineCount()-1, hitLine + SEARCH_CONTEXT_LINES);
+
+    QStringList lines;
+    for(int n = contextFirst; n <= last; n++)
+        lines.append(history->line(n));
+    context->setPlainText(lines.join("\n"));
+    markContext(hitLine);
+
+    console->scrollToLine(hitLine);
+}
+
+void TermSearch::markContext(int hitLine)
+{
+    QString pattern = patternEdit->text();
+    bool cs = caseBox->isChecked();
+    QTextDocument::FindFlags flags;
+    if(cs)
+        flags |= QTextDocument::FindCaseSensitively;
+    QRegExp rx(pattern, cs ? Qt::CaseSensitive : Qt::CaseInsensitive, QRegExp::RegExp2);
+
+    QList<QTextEdit::ExtraSelection> marks;
+    QTextDocument *doc = context->document();
+
+    /* the hit's own line gets a line highlight */
+    QTextBlock block = doc->findBlockByNumber(hitLine - contextFirst);
+    QTextEdit::ExtraSelection lineSel;
+    lineSel.cursor = QTextCursor(block);
+    lineSel.format.setBackground(QColor(Qt::lightGray).lighter(115));
+    lineSel.format.setProperty(QTextFormat::FullWidthSelection, true);
+    marks.append(lineSel);
+
+    QTextCursor cur(doc);
+    for(;;) {
+        cur = regexBox->isChecked() ? doc->find(rx, cur, flags) : doc->find(pattern, cur, flags);
+        if(cur.isNull() || !cur.hasSelection())
+            break;
+        QTextEdit::ExtraSelection sel;
+        sel.cursor = cur;
+        sel.format.setBackground(QColor(Qt::yellow));
+        marks.append(sel);
+    }
+    context->setExtraSelections(marks);
+
+    QTextCursor at(block);
+    context->setTextCursor(at);
+    context->centerCursor();
+}
+
+/*
+ * Closing the search removes the marks from the console.
+ */
+void TermSearch::reject()
+{
+    generation++;
+    current.fetchAndStoreRelaxed(generation);
+    console->highlightAll(QString(), false, false);
+    QDialog::reject();
+}
@@ -0,0 +1,66 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TERMSEARCH_H
+#define TERMSEARCH_H
+
+#include "qtversion.h"
+#include "console.h"
+
+/*
+ * Search a terminal's whole history, not just what the console holds.
+ * The scan runs on a pool thread so the terminal keeps up with the port
+ * meanwhile; a new search or closing the dialog drops one still running.
+ * Hits are listed by line; picking one shows the lines around it with
+ * every match marked, and scrolls the console to it if it's still there.
+ */
+class TermSearch : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit TermSearch(Console *console, QWidget *parent = 0);
+    ~TermSearch();
+
+public slots:
+    void find();
+    void showHit(int row);
+    void reject();
+
+private slots:
+    void searchDone(int gen, QVariantList lines, QStringList texts, qint64 ms);
+
+private:
+    void markContext(int hitLine);
+
+    Console     *console;
+    QThreadPool pool;
+    QAtomicInt  current;        // generation the running search compares against
+    int         generation;
+    QList<int>  hits;
+    int         contextFirst;   // history line shown at the top of context
+
+    QLineEdit   *patternEdit;
+    QCheckBox   *regexBox;
+    QCheckBox   *caseBox;
+    QLabel      *summary;
+    QListWidget *hitList;
+    QPlainTextEdit *context;
+};
+
+#endif // TERMSEARCH_H
@@ -0,0 +1,256 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "termsessions.h"
+
+TermSessions::TermSessions(QWidget *parent) :
+    QDialog(parent)
+{
+    setWindowTitle(tr("Terminal Sessions"));
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    area = new QMdiArea(this);
+    area->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    area->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    layout->addWidget(area);
+
+    QHBoxLayout *buttons = new QHBoxLayout();
+    QPushButton *newBtn = new QPushButton(tr("New Session"), this);
+    QPushButton *tileBtn = new QPushButton(tr("Tile"), this);
+    QPushButton *cascadeBtn = new QPushButton(tr("Cascade"), this);
+    QPushButton *closeBtn = new QPushButton(tr("Close"), this);
+    tabsBtn = new QPushButton(tr("Tabs"), this);
+    tabsBtn->setCheckable(true);
+    connect(newBtn, SIGNAL(clicked()), this, SLOT(newSession()));
+    connect(tileBtn, SIGNAL(clicked()), this, SLOT(tile()));
+    connect(cascadeBtn, SIGNAL(clicked()), this, SLOT(cascade()));
+    connect(tabsBtn, SIGNAL(toggled(bool)), this, SLOT(setTabbed(bool)));
+    connect(closeBtn, SIGNAL(clicked()), this, SLOT(reject()));
+    buttons->addWidget(newBtn);
+    buttons->addWidget(tileBtn);
+    buttons->addWidget(cascadeBtn);
+    buttons->addWidget(tabsBtn);
+    buttons->addStretch(100);
+    buttons->addWidget(closeBtn);
+    layout->addLayout(buttons);
+
+    /* buttons must not swallow Enter meant for a session */
+    newBtn->setAutoDefault(false);
+    tileBtn->setAutoDefault(false);
+    cascadeBtn->setAutoDefault(false);
+    tabsBtn->setAutoDefault(false);
+    closeBtn->setAutoDefault(false);
+
+    setLayout(layout);
+    resize(900,600);
+}
+
+TermSessions::~TermSessions()
+{
+    closeAll();
+}
+
+/*
+ * Ports offered by New Session.
+ */
+void TermSessions::setPorts(QStringList ports)
+{
+    portList = ports;
+}
+
+bool TermSessions::hasSession(QString port)
+{
+    foreach(Session s, sessions) {
+        if(s.port.compare(port) == 0)
+            return true;
+    }
+    return false;
+}
+
+int TermSessions::sessionCount()
+{
+    return sessions.count();
+}
+
+void TermSessions::newSession()
+{
+    QStringList ports;
+    foreach(QString port, portList) {
+        if(!hasSession(port))
+            ports.append(port);
+    }
+    if(ports.isEmpty()) {
+        QMessageBox::information(this, tr("New Session"), tr("Every port already has a session."));
+        return;
+    }
+
+    bool ok;
+    QString port = QInputDialog::getItem(this, tr("New Session"), tr("Port"), ports, 0, false, &ok);
+    if(ok && port.length() > 0)
+        openSession(port);
+}
+
+/*
+ * Open a terminal on port. If the port is held by a loader or the main
+ * terminal the session starts suspended and connects when it's released.
+ */
+bool TermSessions::openSession(QString port, int baud)
+{
+    if(hasSession(port))
+        return false;
+
+    Session s;
+    s.port = port;
+    s.term = new Terminal(this);
+    s.term->setSaveGeometry(false);
+    s.term->setWindowTitle(port);
+    s.listener = new PortListener(this, s.term->getEditor());
+    s.listener->setTerminalWindow(s.term->getEditor());
+    s.listener->init(port, BAUD115200);
+    s.term->setPortListener(s.listener);
+    s.term->setBaudRate(baud);
+    s.suspended = true;
+
+    connect(s.term, SIGNAL(finished(int)), this, SLOT(sessionClosed()));
+
+    /* Terminal is a dialog on its own; here it's just a child widget */
+    s.term->setWindowFlags(Qt::Widget);
+    s.window = area->addSubWindow(s.term);
+    s.window->setAttribute(Qt::WA_DeleteOnClose, false);
+    s.term->setPortEnabled(false);
+    if(!held.contains(port))
+        openPort(s);
+    sessions.append(s);
+
+    s.window->show();
+    s.term->show();
+    show();
+    raise();
+    return true;
+}
+
+void TermSessions::openPort(Session &s)
+{
+    s.term->getEditor()->setPortEnable(true);
+    s.listener->open();
+    s.term->setPortEnabled(true);
+    s.suspended = false;
+}
+
+int TermSessions::indexOf(QObject *term)
+{
+    for(int n = 0; n < sessions.count(); n++) {
+        if(sessions[n].term == term)
+            return n;
+    }
+    return -1;
+}
+
+void TermSessions::sessionClosed()
+{
+    int n = indexOf(sender());
+    if(n < 0)
+        return;
+    Session s = sessions.takeAt(n);
+    s.listener->close();
+    s.listener->wait(1000);
+    area->removeSubWindow(s.window);
+    s.window->deleteLater();
+    s.listener->deleteLater();
+}
+
+void TermSessions::closeAll()
+{
+    while(sessions.count() > 0) {
+        Session s = sessions.takeLast();
+        s.listener->close();
+        s.listener->wait(1000);
+        area->removeSubWindow(s.window);
+        delete s.window;
+        delete s.listener;
+    }
+}
+
+/*
+ * Take port away from its session, if any.
+ */
+void TermSessions::suspend(QString port)
+{
+    if(port.isEmpty())
+        return;
+    if(held.value(port, 0) > 0) {
+        held[port]++;
+        return;
+    }
+    held[port] = 1;
+    for(int n = 0; n < sessions.count(); n++) {
+        Session &s = sessions[n];
+        if(s.port.compare(port) != 0 || !s.listener->isOpen())
+            continue;
+        s.term->setPortEnabled(false);
+        s.listener->close();
+        s.suspended = true;
+    }
+}
+
+/*
+ * Give port back to its session once the last holder is done.
+ */
+void TermSessions::resume(QString port)
+{
+    if(!held.contains(port))
+        return;
+    if(--held[port] > 0)
+        return;
+    held.remove(port);
+    for(int n = 0; n < sessions.count(); n++) {
+        Session &s = sessions[n];
+        if(s.port.compare(port) == 0 && s.suspended)
+            openPort(s);
+    }
+}
+
+void TermSessions::setTabbed(bool tabbed)
+{
+    area->setViewMode(tabbed ? QMdiArea::TabbedView : QMdiArea::SubWindowView);
+    if(tabsBtn->isChecked() != tabbed)
+        tabsBtn->setChecked(tabbed);
+}
+
+void TermSessions::tile()
+{
+    setTabbed(false);
+    area->tileSubWindows();
+}
+
+void TermSessions::cascade()
+{
+    setTabbed(false);
+    area->cascadeSubWindows();
+}
+
+/*
+ * Closing the window ends every session and frees their ports.
+ */
+void TermSessions::reject()
+{
+    closeAll();
+    QDialog::reject();
+}
@@ -0,0 +1,80 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TERMSESSIONS_H
+#define TERMSESSIONS_H
+
+#include "qtversion.h"
+#include "terminal.h"
+
+/*
+ * Extra terminal sessions, one per port, shown tiled or tabbed.
+ * Each session is a Terminal with its own PortListener thread, console
+ * buffer, capture file and baud rate.
+ *
+ * Anything that needs a port to itself (a loader, or the main terminal)
+ * calls suspend() first and resume() when done. Calls nest per port, and
+ * a session only reopens its port when the last holder lets go.
+ */
+class TermSessions : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit TermSessions(QWidget *parent = 0);
+    ~TermSessions();
+
+    void setPorts(QStringList ports);
+    bool openSession(QString port, int baud = BAUD115200);
+    bool hasSession(QString port);
+    int  sessionCount();
+    void closeAll();
+
+public slots:
+    void newSession();
+    void suspend(QString port);
+    void resume(QString port);
+    void setTabbed(bool tabbed);
+    void tile();
+    void cascade();
+    void reject();
+
+private slots:
+    void sessionClosed();
+
+private:
+    typedef struct {
+        QString       port;
+        Terminal      *term;
+        PortListener  *listener;
+        QMdiSubWindow *window;
+        bool          suspended;
+    } Session;
+
+    int  indexOf(QObject *term);
+    void openPort(Session &s);
+
+    QList<Session>      sessions;
+    QHash<QString,int>  held;
+    QStringList         portList;
+
+    QMdiArea    *area;
+    QPushButton *tabsBtn;
+};
+
+#endif // TERMSESSIONS_H
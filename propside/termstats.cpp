@@ -0,0 +1,136 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "termstats.h"
+
+TermStats::TermStats(Console *console, QObject *parent) :
+    QObject(parent)
+{
+    this->console = console;
+    listener = NULL;
+    connect(&timer, SIGNAL(timeout()), this, SLOT(sample()));
+    reset();
+    timer.start(SAMPLE_MS);
+}
+
+void TermStats::setPortListener(PortListener *listener)
+{
+    this->listener = listener;
+    reset();
+}
+
+/*
+ * Start a new run: forget old samples and take the current counters as zero.
+ */
+void TermStats::reset()
+{
+    samples.clear();
+    clock.start();
+    lastMs = 0;
+    lastConsole = console->takeStats();
+    lastTx = 0;
+    baseOverruns = -1;
+    baseDropped = 0;
+    lastWifi = XEspStats();
+    if(listener != NULL) {
+        lastTx = listener->getTxBytes();
+        lastWifi = listener->getWifiStats();
+        baseOverruns = listener->getOverruns();
+        baseDropped = listener->getTxDropped();
+    }
+}
+
+void TermStats::sample()
+{
+    qint64 ms = clock.elapsed();
+    double secs = (ms - lastMs) / 1000.0;
+    if(secs <= 0)
+        return;
+
+    Console::Stats con = console->takeStats();
+    Sample s;
+    s.msecs = ms;
+    s.rxRate = (con.rxBytes - lastConsole.rxBytes) / secs;
+    qint64 frames = con.frames - lastConsole.frames;
+    s.frameMs = frames ? (con.frameUsTotal - lastConsole.frameUsTotal) / 1000.0 / frames : 0;
+    s.frameMaxMs = con.frameUsMax / 1000.0;
+    s.txRate = 0;
+    s.rxQueued = 0;
+    s.latencyMs = -1;
+    s.overruns = -1;
+    s.dropped = 0;
+
+    if(listener != NULL) {
+        qint64 tx = listener->getTxBytes();
+        s.txRate = (tx - lastTx) / secs;
+        lastTx = tx;
+        s.rxQueued = listener->getRxQueued();
+        s.dropped = listener->getTxDropped() - baseDropped;
+
+        qint64 overruns = listener->getOverruns();
+        if(overruns > -1 && baseOverruns < 0)
+            baseOverruns = overruns;
+        if(overruns > -1)
+            s.overruns = overruns - baseOverruns;
+
+        if(!listener->isSerial()) {
+            XEspStats wifi = listener->getWifiStats();
+            qint64 reads = wifi.rxReads - lastWifi.rxReads;
+            s.latencyMs = reads ? (wifi.rxLatencyTotalUs - lastWifi.rxLatencyTotalUs) / 1000.0 / reads : 0;
+            lastWifi = wifi;
+        }
+    }
+    lastConsole = con;
+    lastMs = ms;
+
+    if(samples.count() >= MAX_SAMPLES)
+        samples.removeFirst();
+    samples.append(s);
+
+    QString text = tr("RX %1 B/s  TX %2 B/s  Queued %3  Frame %4/%5 ms")
+            .arg(s.rxRate, 0, 'f', 0).arg(s.txRate, 0, 'f', 0).arg(s.rxQueued)
+            .arg(s.frameMs, 0, 'f', 2).arg(s.frameMaxMs, 0, 'f', 2);
+    if(s.latencyMs > -1)
+        text += tr("  Latency %1 ms").arg(s.latencyMs, 0, 'f', 1);
+    text += tr("  Overruns %1  Dropped %2")
+            .arg(s.overruns > -1 ? QString::number(s.overruns) : QString("-"))
+            .arg(s.dropped);
+    emit updated(text);
+}
+
+bool TermStats::saveCsv(const QString &fileName)
+{
+    QFile file(fileName);
+    if(!file.open(QFile::WriteOnly | QFile::Text))
+        return false;
+    QTextStream out(&file);
+    out << "time_s,rx_bytes_per_s,tx_bytes_per_s,rx_queued,frame_ms,frame_max_ms,latency_ms,overruns,dropped\n";
+    foreach(Sample s, samples) {
+        out << QString::number(s.msecs / 1000.0, 'f', 3) << ","
+            << QString::number(s.rxRate, 'f', 0) << ","
+            << QString::number(s.txRate, 'f', 0) << ","
+            << s.rxQueued << ","
+            << QString::number(s.frameMs, 'f', 3) << ","
+            << QString::number(s.frameMaxMs, 'f', 3) << ","
+            << (s.latencyMs > -1 ? QString::number(s.latencyMs, 'f', 3) : QString("")) << ","
+            << (s.overruns > -1 ? QString::number(s.overruns) : QString("")) << ","
+            << s.dropped << "\n";
+    }
+    return true;
+}
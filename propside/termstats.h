@@ -0,0 +1,78 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TERMSTATS_H
+#define TERMSTATS_H
+
+#include "qtversion.h"
+#include "PortListener.h"
+
+/*
+ * Terminal I/O meters.
+ * Once a second the counters kept by Console, PortListener and
+ * XEsp8266port are turned into rates for the terminal's status line,
+ * and the sample is kept so the run can be saved as CSV.
+ */
+class TermStats : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TermStats(Console *console, QObject *parent = 0);
+
+    void setPortListener(PortListener *listener);
+    void reset();
+    bool saveCsv(const QString &fileName);
+
+signals:
+    void updated(QString text);
+
+private slots:
+    void sample();
+
+private:
+    enum { SAMPLE_MS = 1000 };
+    enum { MAX_SAMPLES = 86400 };   // a day at one a second
+
+    typedef struct {
+        qint64 msecs;           // since reset
+        double rxRate;          // bytes/second
+        double txRate;
+        qint64 rxQueued;        // bytes waiting in the driver or socket
+        double frameMs;         // average console batch time
+        double frameMaxMs;
+        double latencyMs;       // WiFi socket wait, -1 for serial
+        qint64 overruns;        // since reset, -1 if unknown
+        qint64 dropped;         // since reset
+    } Sample;
+
+    Console         *console;
+    PortListener    *listener;
+    QTimer          timer;
+    QElapsedTimer   clock;
+    QList<Sample>   samples;
+
+    qint64  lastMs;
+    Console::Stats lastConsole;
+    XEspStats lastWifi;
+    qint64  lastTx;
+    qint64  baseOverruns;
+    qint64  baseDropped;
+};
+
+#endif // TERMSTATS_H
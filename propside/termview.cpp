@@ -0,0 +1,69 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "termview.h"
+
+TermView::TermView(QPlainTextEdit *edit)
+{
+    textEdit = edit;
+}
+
+void TermView::replaceTail(int remove, const TermBuffer::Text &text, int back)
+{
+    QTextCursor cur(textEdit->document());
+    cur.beginEditBlock();
+    cur.movePosition(QTextCursor::End);
+    if(remove > 0) {
+        cur.movePosition(QTextCursor::Left, QTextCursor::KeepAnchor, qMin(remove, cur.positionInBlock()));
+        cur.removeSelectedText();
+    }
+    if(text.size() > 0)
+        cur.insertText(QString::fromUcs4(&text[0], text.size()));
+    cur.endEditBlock();
+    if(back > 0)
+        cur.movePosition(QTextCursor::Left, QTextCursor::MoveAnchor, back);
+    textEdit->setTextCursor(cur);
+}
+
+void TermView::clearAll()
+{
+    textEdit->setPlainText("");
+}
+
+void TermView::apply(ConsoleDecoder::Op &op)
+{
+    Q_UNUSED(op);
+}
+
+bool TermView::cursorOnLastLine(TermBuffer::Text &line, int &column)
+{
+    QTextCursor cur = textEdit->textCursor();
+    if(cur.blockNumber() != textEdit->document()->blockCount()-1)
+        return false;
+    QString text = cur.block().text();
+    QVector<uint> ucs = text.toUcs4();
+    line.assign(ucs.constBegin(), ucs.constEnd());
+    column = text.left(cur.positionInBlock()).toUcs4().size();
+    return true;
+}
+
+int TermView::lastLineLength()
+{
+    return textEdit->document()->lastBlock().length()-1;
+}
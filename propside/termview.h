@@ -0,0 +1,46 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TERMVIEW_H
+#define TERMVIEW_H
+
+#include "qtversion.h"
+#include "termbuffer.h"
+
+/*
+ * TermBuffer output for a QPlainTextEdit. Each batch is one edit
+ * through a cursor at the end of the document.
+ * Operations away from the last line are left to subclasses.
+ */
+class TermView : public TermBuffer::View
+{
+public:
+    TermView(QPlainTextEdit *edit);
+
+    void replaceTail(int remove, const TermBuffer::Text &text, int back);
+    void clearAll();
+    void apply(ConsoleDecoder::Op &op);
+    bool cursorOnLastLine(TermBuffer::Text &line, int &column);
+    int  lastLineLength();
+
+private:
+    QPlainTextEdit *textEdit;
+};
+
+#endif // TERMVIEW_H
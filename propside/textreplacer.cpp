@@ -0,0 +1,313 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "textreplacer.h"
+
+/**
+ * @param find text or QRegExp pattern to find.
+ * @param replace replacement text; \0 to \9 expand in regex mode.
+ * @param regex treat find as a regular expression.
+ * @param wholeWord only match whole words.
+ * @param caseSensitive match case.
+ */
+TextReplacer::TextReplacer(const QString &find, const QString &replace,
+                           bool regex, bool wholeWord, bool caseSensitive)
+{
+    this->find = find;
+    this->replace = replace;
+    this->regex = regex;
+    this->wholeWord = wholeWord;
+    cs = caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    if(regex) {
+        QString pattern = find;
+        if(wholeWord)
+            pattern = "\\b(?:"+pattern+")\\b";
+        rx = QRegExp(pattern, cs, QRegExp::RegExp2);
+    }
+}
+
+bool TextReplacer::isValid()
+{
+    if(find.isEmpty())
+        return false;
+    return !regex || rx.isValid();
+}
+
+QString TextReplacer::errorString()
+{
+    if(find.isEmpty())
+        return QObject::tr("Nothing to find.");
+    if(regex && !rx.isValid())
+        return rx.errorString();
+    return QString();
+}
+
+bool TextReplacer::isWordAt(const QString &text, int start, int length)
+{
+    int end = start + length;
+    if(start > 0) {
+        QChar c = text.at(start-1);
+        if(c.isLetterOrNumber() || c == QLatin1Char('_'))
+            return false;
+    }
+    if(end < text.length()) {
+        QChar c = text.at(end);
+        if(c.isLetterOrNumber() || c == QLatin1Char('_'))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Expand \0 to \9 in the replacement from the last match of rx.
+ * \\ is a backslash; other escapes are kept as typed.
+ */
+QString TextReplacer::expand(const QRegExp &rx)
+{
+    if(!replace.contains(QLatin1Char('\\')))
+        return replace;
+
+    QString s;
+    int len = replace.length();
+    for(int n = 0; n < len; n++) {
+        QChar c = replace.at(n);
+        if(c == QLatin1Char('\\') && n+1 < len) {
+            QChar next = replace.at(n+1);
+            if(next.isDigit()) {
+                s += rx.cap(next.digitValue());
+                n++;
+                continue;
+            }
+            if(next == QLatin1Char('\\')) {
+                s += next;
+                n++;
+                continue;
+            }
+        }
+        s += c;
+    }
+    return s;
+}
+
+/*
+ * The line holding position pos, without its newline or a CR before it.
+ * Regular expressions only see one line at a time, as QTextDocument::find
+ * gives them one block, so . stops at the line end and ^ and $ match at
+ * each line.
+ */
+static QString lineAround(const QString &text, int pos, int *start, int *end)
+{
+    *start = pos > 0 ? text.lastIndexOf(QLatin1Char('\n'), pos-1)+1 : 0;
+    *end = text.indexOf(QLatin1Char('\n'), *start);
+    if(*end < 0)
+        *end = text.length();
+    int len = *end - *start;
+    if(len > 0 && text.at(*end-1) == QLatin1Char('\r'))
+        len--;
+    return text.mid(*start, len);
+}
+
+/**
+ * Find all non-overlapping matches from the start of text.
+ * @param maxMatches stop after this many matches; -1 for all.
+ * @returns matches in text order with their replacement text.
+ */
+QList<TextReplacer::Match> TextReplacer::findAll(const QString &text, int maxMatches)
+{
+    QList<Match> list;
+    if(!isValid())
+        return list;
+
+    Match m;
+    int pos = 0;
+    int len = text.length();
+
+    if(regex) {
+        int start;
+        int end;
+        while(pos <= len && (maxMatches < 0 || list.count() < maxMatches)) {
+            QString line = lineAround(text, pos, &start, &end);
+            int at = 0;
+            while(at <= line.length() && (maxMatches < 0 || list.count() < maxMatches)) {
+                int index = rx.indexIn(line, at);
+                if(index < 0)
+                    break;
+                m.start = start + index;
+                m.length = rx.matchedLength();
+                m.text = expand(rx);
+                list.append(m);
+                /* step over empty matches so they don't repeat */
+                at = index + (m.length > 0 ? m.length : 1);
+            }
+            pos = end+1;
+        }
+        return list;
+    }
+
+    while(pos <= len && (maxMatches < 0 || list.count() < maxMatches)) {
+        int index = text.indexOf(find, pos, cs);
+        if(index < 0)
+            break;
+        if(wholeWord && !isWordAt(text, index, find.length())) {
+            pos = index + 1;
+            continue;
+        }
+        m.start = index;
+        m.length = find.length();
+        m.text = replace;
+        list.append(m);
+        pos = index + m.length;
+    }
+    return list;
+}
+
+/**
+ * Find one match next to a position.
+ * @param from forward, the first position a match may start at;
+ *        backward, a match must start before it.
+ * @param backward search toward the start of text.
+ * @param m set to the match and its replacement text.
+ * @returns true if a match was found.
+ */
+bool TextReplacer::findNext(const QString &text, int from, bool backward, Match &m)
+{
+    if(!isValid())
+        return false;
+
+    if(regex) {
+        int pos = backward ? from-1 : from;
+        int start;
+        int end;
+        while(pos >= 0 && pos <= text.length()) {
+            QString line = lineAround(text, pos, &start, &end);
+            int at = qMin(pos - start, line.length());
+            int index = backward ? rx.lastIndexIn(line, at) : rx.indexIn(line, at);
+            if(index >= 0) {
+                m.start = start + index;
+                m.length = rx.matchedLength();
+                m.text = expand(rx);
+                return true;
+            }
+            pos = backward ? start-1 : end+1;
+        }
+        return false;
+    }
+
+    int pos = from;
+    for(;;) {
+        int index;
+        if(backward) {
+            if(pos < 1)
+                return false;
+            index = text.lastIndexOf(find, pos-1, cs);
+        }
+        else {
+            if(pos > text.length())
+                return false;
+            index = text.indexOf(find, pos, cs);
+        }
+        if(index < 0)
+            return false;
+        if(!wholeWord || isWordAt(text, index, find.length())) {
+            m.start = index;
+            m.length = find.length();
+            m.text = replace;
+            return true;
+        }
+        pos = backward ? index : index+1;
+    }
+}
+
+/**
+ * @returns text with all matches replaced.
+ */
+QString TextReplacer::replaceAll(const QString &text, int *count)
+{
+    QList<Match> list = findAll(text);
+    if(count)
+        *count = list.count();
+    if(list.isEmpty())
+        return text;
+
+    QString s;
+    s.reserve(text.length());
+    int from = 0;
+    foreach(const Match &m, list) {
+        s.append(text.midRef(from, m.start-from));
+        s.append(m.text);
+        from = m.start + m.length;
+    }
+    s.append(text.midRef(from));
+    return s;
+}
+
+/**
+ * Replace all matches in a document as one undo step.
+ * Edits run back to front so earlier match positions stay valid.
+ * @returns number of replacements.
+ */
+int TextReplacer::replaceAll(QTextDocument *doc)
+{
+    QList<Match> list = findAll(doc->toPlainText());
+    if(list.isEmpty())
+        return 0;
+
+    QTextCursor cur(doc);
+    cur.beginEditBlock();
+    for(int n = list.count()-1; n >= 0; n--) {
+        const Match &m = list.at(n);
+        cur.setPosition(m.start);
+        cur.setPosition(m.start+m.length, QTextCursor::KeepAnchor);
+        cur.insertText(m.text);
+    }
+    cur.endEditBlock();
+    return list.count();
+}
+
+/**
+ * Time a plain and a regex Replace All over a document with the given
+ * number of matches.
+ * @returns a one line summary.
+ */
+QString TextReplacer::benchmark(int matches)
+{
+    QString text;
+    text.reserve(matches*24);
+    for(int n = 0; n < matches; n++)
+        text += QString("    value%1 = old_name;\n").arg(n % 100);
+
+    QElapsedTimer timer;
+    QTextDocument doc;
+
+    doc.setPlainText(text);
+    TextReplacer plain("old_name", "new_name", false, true, true);
+    timer.start();
+    int plainCount = plain.replaceAll(&doc);
+    qint64 plainMs = timer.elapsed();
+
+    doc.setPlainText(text);
+    TextReplacer rx("(value\\d+) = (\\w+)", "\\2 = \\1", true, false, true);
+    timer.restart();
+    int rxCount = rx.replaceAll(&doc);
+    qint64 rxMs = timer.elapsed();
+
+    QString s = QString("Replace All: plain %1 matches %2 ms, regex %3 matches %4 ms")
+            .arg(plainCount).arg(plainMs).arg(rxCount).arg(rxMs);
+    return s;
+}
@@ -0,0 +1,67 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TEXTREPLACER_H
+#define TEXTREPLACER_H
+
+#include "qtversion.h"
+
+/*
+ * Find and replace engine used by Replace All and by regex Find and
+ * Replace steps, so every path matches and expands the same way.
+ * All matches are found in one pass over the text. Plain text uses
+ * QString::indexOf, regular expressions use QRegExp and the replacement
+ * may use \0 to \9 for the whole match and capture groups. Regular
+ * expressions match within one line at a time.
+ */
+class TextReplacer
+{
+public:
+    TextReplacer(const QString &find, const QString &replace,
+                 bool regex, bool wholeWord, bool caseSensitive);
+
+    typedef struct {
+        int     start;
+        int     length;
+        QString text;       // replacement for this match
+    } Match;
+
+    bool    isValid();
+    QString errorString();
+
+    QList<Match> findAll(const QString &text, int maxMatches = -1);
+    bool    findNext(const QString &text, int from, bool backward, Match &m);
+    QString replaceAll(const QString &text, int *count = 0);
+    int     replaceAll(QTextDocument *doc);
+
+    static QString benchmark(int matches);
+
+private:
+    bool    isWordAt(const QString &text, int start, int length);
+    QString expand(const QRegExp &rx);
+
+    QString find;
+    QString replace;
+    bool    regex;
+    bool    wholeWord;
+    Qt::CaseSensitivity cs;
+    QRegExp rx;
+};
+
+#endif // TEXTREPLACER_H
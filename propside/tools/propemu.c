@@ -0,0 +1,555 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * propemu - Propeller ROM bootloader on a pseudo terminal.
+ *
+ * Creates a pty and answers on it like a Propeller just out of reset,
+ * so the loader, port scan and terminal can be tested without a board.
+ * Add the pty path (or the -l link) to the SimpleIDE_ExtraPorts setting
+ * to have it listed in the port combo.
+ *
+ * The emulator does what the ROM does:
+ *
+ *   - waits for the 0xF9 calibration byte and the 250 byte LFSR
+ *     sequence seeded with 'P'. The match runs all the time, so a
+ *     new handshake restarts the loader from any state like a reset.
+ *   - answers each of the next 258 0xF9 bytes with the next LFSR bit
+ *     (250 of them) and then the chip version, LSB first.
+ *   - decodes the command and long count and then the image, 3 bits
+ *     per byte as PropellerID::makelong() sends them.
+ *   - sums the image with the initial Spin call frame and answers the
+ *     next 0xF9 with 0xFE if the sum is 0, else 0xFF. EEPROM commands
+ *     get two more acks for programming and verify.
+ *   - then runs a program: echo (default) sends back what it gets,
+ *     flood sends numbered lines that wxserver -V can check.
+ *
+ * A pty has no DTR, so the reset pulse itself isn't seen. That's fine
+ * because the handshake restarts the loader anyway.
+ *
+ * Build: cc -o propemu propemu.c   (or make in this directory)
+ *
+ * Usage: propemu [-l link] [-v version] [-r echo|flood] [-R lines_per_second]
+ *                [-F checksum|program|verify] [-w image_file] [-x loads] [-q]
+ *
+ *   -l link    make a symlink to the pty, removed on exit
+ *   -v version chip version to report, default 1
+ *   -r program what runs after a load, echo or flood
+ *   -R rate    flood line rate, 0 for as fast as the pty takes it
+ *   -F step    fail this step of the load
+ *   -w file    save each received image to this file
+ *   -x loads   exit after this many loads, with status 1 if any failed
+ *   -q         only log loads, not each step
+ */
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LFSR_BYTES          250
+#define VERSION_BITS        8
+#define SPIN_FRAME_CHECKSUM 0xEC
+#define MAX_IMAGE           0x8000
+
+#define LOAD_SHUTDOWN       0
+#define LOAD_RUN_RAM        1
+#define LOAD_EEPROM         2
+#define LOAD_RUN_EEPROM     3
+
+enum State {
+    IDLE,       /* waiting for a handshake */
+    VERSION,    /* clocking out LFSR bits and the version */
+    COMMAND,    /* receiving the command long */
+    COUNT,      /* receiving the long count */
+    IMAGE,      /* receiving the image */
+    ACK,        /* answering 0xF9 with acks */
+    RUN         /* running the loaded program */
+};
+
+enum Fail { FAIL_NONE, FAIL_CHECKSUM, FAIL_PROGRAM, FAIL_VERIFY };
+
+static volatile sig_atomic_t quit = 0;
+
+static int master = -1;
+static int quiet = 0;
+static int version = 1;
+static int flood = 0;
+static double floodRate = 0;
+static int failStep = FAIL_NONE;
+static const char *imageFile = NULL;
+
+static unsigned char lfsrHost[LFSR_BYTES];
+static unsigned char lfsrChip[LFSR_BYTES + VERSION_BITS];
+
+static enum State state = IDLE;
+static int replies;
+static int matchPos;
+static int heldLen;
+static unsigned char held[LFSR_BYTES + 1];
+
+static unsigned int word;
+static int wordBits;
+static int wordBytes;
+static unsigned int command;
+static unsigned int longs;
+static unsigned int received;
+static unsigned char image[MAX_IMAGE];
+static int acks;
+
+static int loads;
+static int failures;
+
+static long floodSent;
+static double floodStart;
+static char floodLine[32];
+static int floodLen;
+static int floodPos;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void onSignal(int sig)
+{
+    (void) sig;
+    quit = 1;
+}
+
+static void logStep(const char *fmt, ...)
+{
+    va_list ap;
+    if(quiet)
+        return;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    printf("\n");
+    fflush(stdout);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-l link] [-v version] [-r echo|flood] [-R lines_per_second]\n"
+                    "       [-F checksum|program|verify] [-w image_file] [-x loads] [-q]\n", prog);
+    exit(2);
+}
+
+/*
+ * Same generator as PropellerID::iterate(). The host sends the first
+ * 250 bits and the chip answers with the next 250.
+ */
+static void makeLfsr(void)
+{
+    unsigned char lfsr = 'P';
+    int n;
+    for(n = 0; n < LFSR_BYTES * 2; n++) {
+        int bit = lfsr & 1;
+        lfsr = (unsigned char)((lfsr << 1) | (((lfsr >> 7) ^ (lfsr >> 5) ^ (lfsr >> 4) ^ (lfsr >> 1)) & 1));
+        if(n < LFSR_BYTES)
+            lfsrHost[n] = 0xFE | bit;
+        else
+            lfsrChip[n - LFSR_BYTES] = 0xFE | bit;
+    }
+}
+
+static void put(const unsigned char *buf, int len)
+{
+    while(len > 0) {
+        int rc = write(master, buf, len);
+        if(rc < 0) {
+            if(errno == EINTR || errno == EAGAIN) {
+                usleep(1000);
+                continue;
+            }
+            return;
+        }
+        buf += rc;
+        len -= rc;
+    }
+}
+
+static void putByte(unsigned char ch)
+{
+    put(&ch, 1);
+}
+
+static void endLoad(int ok)
+{
+    loads++;
+    if(!ok)
+        failures++;
+    printf("load %d: command %u, %u longs, %s\n", loads, command, longs, ok ? "ok" : "FAILED");
+    fflush(stdout);
+}
+
+static void startRun(void)
+{
+    state = RUN;
+    floodSent = 0;
+    floodStart = now();
+    floodLen = 0;
+    floodPos = 0;
+    logStep("running %s program", flood ? "flood" : "echo");
+}
+
+static void saveImage(void)
+{
+    if(!imageFile)
+        return;
+    FILE *fp = fopen(imageFile, "wb");
+    if(!fp) {
+        perror(imageFile);
+        return;
+    }
+    fwrite(image, 1, received * 4, fp);
+    fclose(fp);
+}
+
+/*
+ * Collect a long 3 bits per byte. Returns 1 when a long is complete,
+ * -1 if the byte isn't part of a long.
+ */
+static int decodeLong(unsigned char ch)
+{
+    if(wordBytes < 10) {
+        if((ch & ~0x49) != 0x92)
+            return -1;
+        word |= (unsigned int)((ch & 1) | ((ch >> 2) & 2) | ((ch >> 4) & 4)) << wordBits;
+        wordBits += 3;
+    }
+    else {
+        if((ch & ~0x09) != 0xF2)
+            return -1;
+        word |= (unsigned int)((ch & 1) | ((ch >> 2) & 2)) << wordBits;
+    }
+    if(++wordBytes < 11)
+        return 0;
+    return 1;
+}
+
+static void resetLong(void)
+{
+    word = 0;
+    wordBits = 0;
+    wordBytes = 0;
+}
+
+/*
+ * Answer an 0xF9 after the image: checksum, then for EEPROM loads
+ * programming and verify.
+ */
+static void sendAck(void)
+{
+    int ok = 1;
+    if(acks == 0) {
+        unsigned int sum = SPIN_FRAME_CHECKSUM;
+        unsigned int n;
+        for(n = 0; n < received * 4; n++)
+            sum += image[n];
+        ok = (sum & 0xff) == 0 && failStep != FAIL_CHECKSUM;
+        logStep("checksum %s", ok ? "ok" : "error");
+    }
+    else if(acks == 1) {
+        ok = failStep != FAIL_PROGRAM;
+        logStep("EEPROM program %s", ok ? "ok" : "error");
+    }
+    else {
+        ok = failStep != FAIL_VERIFY;
+        logStep("EEPROM verify %s", ok ? "ok" : "error");
+    }
+    putByte(ok ? 0xFE : 0xFF);
+    acks++;
+
+    if(!ok) {
+        endLoad(0);
+        state = IDLE;
+    }
+    else if(command == LOAD_RUN_RAM || acks == 3) {
+        endLoad(1);
+        if(command == LOAD_EEPROM)
+            state = IDLE;
+        else
+            startRun();
+    }
+}
+
+/*
+ * Handle one byte that isn't part of a handshake.
+ */
+static void process(unsigned char ch)
+{
+    int rc;
+
+    switch(state) {
+    case IDLE:
+        break;
+
+    case VERSION:
+        if(ch != 0xF9)
+            break;
+        if(replies < LFSR_BYTES)
+            putByte(lfsrChip[replies]);
+        else
+            putByte(0xFE | ((version >> (replies - LFSR_BYTES)) & 1));
+        if(++replies == LFSR_BYTES + VERSION_BITS) {
+            logStep("version %d sent", version);
+            state = COMMAND;
+            resetLong();
+        }
+        break;
+
+    case COMMAND:
+    case COUNT:
+    case IMAGE:
+        rc = decodeLong(ch);
+        if(rc < 0) {
+            logStep("bad long byte 0x%02x", ch);
+            state = IDLE;
+            break;
+        }
+        if(rc == 0)
+            break;
+        if(state == COMMAND) {
+            command = word;
+            logStep("command %u", command);
+            if(command == LOAD_SHUTDOWN) {
+                state = IDLE;
+                break;
+            }
+            if(command > LOAD_RUN_EEPROM) {
+                logStep("unknown command %u", command);
+                state = IDLE;
+                break;
+            }
+            state = COUNT;
+        }
+        else if(state == COUNT) {
+            longs = word;
+            received = 0;
+            logStep("receiving %u longs", longs);
+            if(longs == 0 || longs * 4 > MAX_IMAGE) {
+                state = IDLE;
+                break;
+            }
+            state = IMAGE;
+        }
+        else {
+            image[received * 4]     = word & 0xff;
+            image[received * 4 + 1] = (word >> 8) & 0xff;
+            image[received * 4 + 2] = (word >> 16) & 0xff;
+            image[received * 4 + 3] = (word >> 24) & 0xff;
+            if(++received == longs) {
+                saveImage();
+                acks = 0;
+                state = ACK;
+            }
+        }
+        resetLong();
+        break;
+
+    case ACK:
+        if(ch == 0xF9)
+            sendAck();
+        break;
+
+    case RUN:
+        if(!flood)
+            putByte(ch);
+        break;
+    }
+}
+
+/*
+ * Look for the handshake in everything received. While the program
+ * runs, bytes that might be the start of a handshake are held back
+ * instead of echoed and released if the match fails.
+ */
+static void input(unsigned char ch)
+{
+    unsigned char expect = matchPos == 0 ? 0xF9 : lfsrHost[matchPos - 1];
+
+    if(ch != expect) {
+        int n;
+        for(n = 0; n < heldLen; n++)
+            process(held[n]);
+        heldLen = 0;
+        matchPos = 0;
+        if(ch != 0xF9) {
+            process(ch);
+            return;
+        }
+    }
+
+    if(++matchPos == LFSR_BYTES + 1) {
+        matchPos = 0;
+        heldLen = 0;
+        logStep("handshake");
+        state = VERSION;
+        replies = 0;
+    }
+    else if(state == RUN) {
+        held[heldLen++] = ch;
+    }
+    else {
+        process(ch);
+    }
+}
+
+/*
+ * Send the next flood line if it's due. Returns the ms until the
+ * next one, or -1 if nothing is waiting.
+ */
+static int floodNext(void)
+{
+    if(state != RUN || !flood)
+        return -1;
+    if(floodPos >= floodLen) {
+        if(floodRate > 0) {
+            double due = floodStart + floodSent / floodRate;
+            double wait = due - now();
+            if(wait > 0)
+                return (int)(wait * 1000) + 1;
+        }
+        floodLen = snprintf(floodLine, sizeof(floodLine), "line %ld\r\n", floodSent++);
+        floodPos = 0;
+    }
+    int rc = write(master, floodLine + floodPos, floodLen - floodPos);
+    if(rc > 0)
+        floodPos += rc;
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *link = NULL;
+    int maxLoads = 0;
+    int opt;
+
+    while((opt = getopt(argc, argv, "l:v:r:R:F:w:x:q")) != -1) {
+        switch(opt) {
+        case 'l': link = optarg; break;
+        case 'v': version = atoi(optarg); break;
+        case 'r':
+            if(!strcmp(optarg, "flood")) flood = 1;
+            else if(strcmp(optarg, "echo")) usage(argv[0]);
+            break;
+        case 'R': floodRate = atof(optarg); break;
+        case 'F':
+            if(!strcmp(optarg, "checksum")) failStep = FAIL_CHECKSUM;
+            else if(!strcmp(optarg, "program")) failStep = FAIL_PROGRAM;
+            else if(!strcmp(optarg, "verify")) failStep = FAIL_VERIFY;
+            else usage(argv[0]);
+            break;
+        case 'w': imageFile = optarg; break;
+        case 'x': maxLoads = atoi(optarg); break;
+        case 'q': quiet = 1; break;
+        default: usage(argv[0]);
+        }
+    }
+
+    makeLfsr();
+
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if(master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) {
+        perror("posix_openpt");
+        return 1;
+    }
+    const char *name = ptsname(master);
+    if(!name) {
+        perror("ptsname");
+        return 1;
+    }
+
+    /* Hold the slave open so the pty stays put between host opens,
+     * and make it raw like a serial port would be.
+     */
+    int slave = open(name, O_RDWR | O_NOCTTY);
+    if(slave < 0) {
+        perror(name);
+        return 1;
+    }
+    struct termios tio;
+    if(tcgetattr(slave, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(slave, TCSANOW, &tio);
+    }
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+    if(link) {
+        unlink(link);
+        if(symlink(name, link) < 0) {
+            perror(link);
+            return 1;
+        }
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGHUP, onSignal);
+
+    printf("propemu: version %d on %s%s%s\n", version, name, link ? " linked as " : "", link ? link : "");
+    fflush(stdout);
+
+    while(!quit) {
+        struct pollfd pfd;
+        int timeout = floodNext();
+        pfd.fd = master;
+        pfd.events = POLLIN;
+        if(timeout == 0) {
+            pfd.events |= POLLOUT;
+            timeout = -1;
+        }
+        int rc = poll(&pfd, 1, timeout);
+        if(rc < 0) {
+            if(errno == EINTR)
+                continue;
+            perror("poll");
+            break;
+        }
+        if(pfd.revents & POLLIN) {
+            unsigned char buf[4096];
+            int len = read(master, buf, sizeof(buf));
+            int n;
+            for(n = 0; n < len; n++)
+                input(buf[n]);
+        }
+        if(maxLoads > 0 && loads >= maxLoads && state != ACK)
+            break;
+    }
+
+    if(link)
+        unlink(link);
+    close(slave);
+    close(master);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,221 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * termbuffertest - checks the terminal engine shared by the console
+ * and the loader window without Qt.
+ *
+ * A 1 MB stream with 100k backspaces is written in 200 byte reads,
+ * the way Console::updateReady() hands them over, to a simple line
+ * view. The result must match a plain model of the same stream and
+ * each run must finish within the time limit. Per character document
+ * edits or rewriting the line on every backspace would not.
+ *
+ * Build and run: make check   (in this directory)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include "../termbuffer.h"
+
+#define STREAM_SIZE     (1024*1024)
+#define BACKSPACES      100000
+#define READ_SIZE       200
+#define TAB_SIZE        8
+#define TIME_LIMIT_MS   2000
+
+typedef TermBuffer::Text Text;
+
+/*
+ * The document as a list of lines with the cursor on the last one.
+ */
+class LineView : public TermBuffer::View
+{
+public:
+    LineView() : lines(1), column(0), applied(0) {}
+
+    void replaceTail(int remove, const Text &text, int back) {
+        Text *last = &lines.back();
+        if(remove > (int) last->size())
+            remove = last->size();
+        last->resize(last->size() - remove);
+        for(size_t n = 0; n < text.size(); n++) {
+            if(text[n] == '\n') {
+                lines.push_back(Text());
+                last = &lines.back();
+            }
+            else {
+                last->push_back(text[n]);
+            }
+        }
+        column = last->size() - back;
+    }
+    void clearAll() {
+        lines.assign(1, Text());
+        column = 0;
+    }
+    void apply(ConsoleDecoder::Op &op) {
+        (void) op;
+        applied++;
+    }
+    bool cursorOnLastLine(Text &line, int &col) {
+        line = lines.back();
+        col = column;
+        return true;
+    }
+    int lastLineLength() {
+        return lines.back().size();
+    }
+
+    std::vector<Text> lines;
+    int column;
+    int applied;
+};
+
+/*
+ * What the stream should look like: printing overwrites at the cursor,
+ * backspace removes the last character of the line, CR goes to the
+ * start of the line, LF ends it and a tab inserts spaces.
+ */
+static std::vector<Text> model(const std::string &data)
+{
+    std::vector<Text> lines(1);
+    size_t col = 0;
+    for(size_t n = 0; n < data.size(); n++) {
+        unsigned char ch = data[n];
+        Text &line = lines.back();
+        switch(ch) {
+            case '\b':
+                if(line.size() > 0)
+                    line.pop_back();
+                if(col > line.size())
+                    col = line.size();
+                break;
+            case '\r':
+                col = 0;
+                break;
+            case '\n':
+                lines.push_back(Text());
+                col = 0;
+                break;
+            case '\t': {
+                    size_t spaces = TAB_SIZE - col % TAB_SIZE;
+                    line.insert(line.begin() + col, spaces, ' ');
+                    col += spaces;
+                }
+                break;
+            default:
+                if(col < line.size())
+                    line[col] = ch;
+                else
+                    line.push_back(ch);
+                col++;
+                break;
+        }
+    }
+    return lines;
+}
+
+/*
+ * Printable text with newlines about every lineLength characters,
+ * some CRs and tabs, and the backspaces spread through it.
+ * A lineLength of 0 makes one long line ending in the backspaces.
+ */
+static std::string makeStream(int lineLength)
+{
+    std::string data;
+    data.reserve(STREAM_SIZE);
+    srand(1);
+    int backspaces = BACKSPACES;
+    while((int) data.size() < STREAM_SIZE) {
+        int left = STREAM_SIZE - data.size();
+        if(lineLength == 0) {
+            data += (left > backspaces) ? (char)(' ' + rand() % 95) : '\b';
+            continue;
+        }
+        if(backspaces > 0 && rand() % left < backspaces) {
+            /* runs of backspaces, sometimes longer than the line */
+            int run = 1 + rand() % (lineLength / 2);
+            for(; run > 0 && backspaces > 0; run--, backspaces--)
+                data += '\b';
+            continue;
+        }
+        int r = rand() % (lineLength + 10);
+        if(r == 0)
+            data += '\r';
+        else if(r == 1)
+            data += '\t';
+        else if(r == 2 || r == 3)
+            data += "\r\n";
+        else if(r < lineLength)
+            data += (char)(' ' + rand() % 95);
+        else
+            data += '\n';
+    }
+    return data;
+}
+
+static int run(const char *name, int lineLength)
+{
+    std::string data = makeStream(lineLength);
+    TermBuffer buffer;
+    LineView view;
+    buffer.setPlainMode();
+    buffer.setTabSize(TAB_SIZE);
+
+    clock_t start = clock();
+    for(size_t pos = 0; pos < data.size(); pos += READ_SIZE) {
+        int len = (data.size() - pos > READ_SIZE) ? READ_SIZE : data.size() - pos;
+        buffer.write(&view, data.data() + pos, len);
+    }
+    long ms = (clock() - start) * 1000 / CLOCKS_PER_SEC;
+
+    int errors = 0;
+    std::vector<Text> expect = model(data);
+    if(expect != view.lines) {
+        printf("%s: document doesn't match, %d lines expected, %d shown\n",
+               name, (int) expect.size(), (int) view.lines.size());
+        errors++;
+    }
+    if(view.applied > 0) {
+        printf("%s: %d operations left to the view\n", name, view.applied);
+        errors++;
+    }
+    if(ms > TIME_LIMIT_MS) {
+        printf("%s: took %ld ms, limit %d ms\n", name, ms, TIME_LIMIT_MS);
+        errors++;
+    }
+    int backspaces = 0;
+    for(size_t n = 0; n < data.size(); n++)
+        backspaces += data[n] == '\b';
+    printf("%s: %s, %d bytes, %d backspaces, %d lines, %ld ms\n", name, errors ? "FAILED" : "ok",
+           (int) data.size(), backspaces, (int) view.lines.size(), ms);
+    return errors;
+}
+
+int main()
+{
+    int errors = 0;
+    errors += run("short lines", 60);
+    errors += run("one line", 0);
+    return errors ? 1 : 0;
+}
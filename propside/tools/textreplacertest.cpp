@@ -0,0 +1,90 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * textreplacertest - checks that regular expressions in Replace All and
+ * the Find/Replace steps match one line at a time, the way
+ * QTextDocument::find matched one block, so a greedy pattern can't
+ * swallow the lines after it and ^ and $ anchor at every line.
+ *
+ * Build and run: make check-qt   (in this directory, needs Qt 5)
+ */
+
+#include <stdio.h>
+#include "../textreplacer.h"
+
+static int errors = 0;
+
+static void expect(const char *name, const QString &got, const QString &want)
+{
+    bool ok = got == want;
+    if(!ok)
+        errors++;
+    printf("%s: %s\n", name, ok ? "ok" : "FAILED");
+    if(!ok) {
+        printf("  expected \"%s\"\n", want.toUtf8().constData());
+        printf("  got      \"%s\"\n", got.toUtf8().constData());
+    }
+}
+
+static QString replaceAll(const QString &text, const QString &find, const QString &with, int *count = 0)
+{
+    TextReplacer replacer(find, with, true, false, true);
+    return replacer.replaceAll(text, count);
+}
+
+/*
+ * Start+length of the match findNext gives, or "none".
+ */
+static QString next(const QString &text, const QString &find, int from, bool backward)
+{
+    TextReplacer finder(find, QString(), true, false, true);
+    TextReplacer::Match m;
+    if(!finder.findNext(text, from, backward, m))
+        return "none";
+    return QString("%1+%2").arg(m.start).arg(m.length);
+}
+
+int main()
+{
+    int count = 0;
+    QString lines = "foo one\nfoo two\nbar\nfoo three\n";
+
+    expect("greedy .* stays on its line",
+           replaceAll(lines, "foo.*", "X", &count), "X\nX\nbar\nX\n");
+    expect("greedy .* count", QString::number(count), "3");
+    expect("^ at each line",
+           replaceAll("ab\nbc\nb", "^b", "B"), "ab\nBc\nB");
+    expect("$ at each line",
+           replaceAll("one\ntwo\n", "$", ";"), "one;\ntwo;\n;");
+    expect("$ before CR LF",
+           replaceAll("foo\r\nbo\r\n", "o$", "X"), "foX\r\nbX\r\n");
+    expect("captures",
+           replaceAll("a=1\nb=2", "(\\w+)=(\\w+)", "\\2=\\1"), "1=a\n2=b");
+    expect("no match across lines",
+           replaceAll("foo\nbar", "foo.bar", "X"), "foo\nbar");
+
+    expect("find next on a later line", next(lines, "^foo t", 1, false), "8+6");
+    expect("find previous on an earlier line", next(lines, "o.e$", 28, true), "4+3");
+    expect("find previous stops before from", next("foo\nfoo", "foo", 4, true), "0+3");
+    expect("find next past the end", next(lines, "bar", 20, false), "none");
+
+    printf("%s\n", errors ? "FAILED" : "all ok");
+    return errors ? 1 : 0;
+}
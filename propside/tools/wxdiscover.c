@@ -0,0 +1,181 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * wxdiscover - stand in for a Parallax WX module on the discovery port.
+ *
+ * The loader finds WX modules by broadcasting a UDP packet to port
+ * 32420. The packet is a 32 bit word followed by the IPv4 addresses
+ * of modules that already answered. A module not in that list replies
+ * with a small JSON description of itself.
+ *
+ * Every query is logged with the time since the previous one, so a
+ * test can check that SimpleIDE only runs discovery once per cache
+ * period (WX_DISCOVERY_TTL) however often the port list is refreshed.
+ *
+ * Build: cc -o wxdiscover wxdiscover.c   (or make in this directory)
+ *
+ * Usage: wxdiscover [-a addr] [-p port] [-n name] [-m mac]
+ *                   [-d delay_ms] [-s skip] [-x count]
+ *
+ *   -a addr    address to bind, default any
+ *   -p port    discovery port, default 32420
+ *   -n name    module name, default wx-sim
+ *   -m mac     module MAC address, default 18:fe:34:00:00:01
+ *   -d ms      wait this long before replying (slow module)
+ *   -s skip    ignore the first skip queries (lost replies)
+ *   -x count   exit after count queries
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DISCOVER_PORT   32420
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-a addr] [-p port] [-n name] [-m mac] "
+                    "[-d delay_ms] [-s skip] [-x count]\n", prog);
+    exit(2);
+}
+
+/*
+ * Returns 1 if addr is in the list of modules that already answered.
+ */
+static int alreadyFound(const unsigned char *buf, int len, struct in_addr addr)
+{
+    int n;
+    for(n = 4; n + 4 <= len; n += 4) {
+        if(!memcmp(buf + n, &addr.s_addr, 4))
+            return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *bindAddr = NULL;
+    const char *name = "wx-sim";
+    const char *mac = "18:fe:34:00:00:01";
+    int port = DISCOVER_PORT;
+    int delay = 0;
+    int skip = 0;
+    int count = 0;
+    int queries = 0;
+    double last = 0;
+    int opt;
+
+    while((opt = getopt(argc, argv, "a:p:n:m:d:s:x:")) != -1) {
+        switch(opt) {
+        case 'a': bindAddr = optarg; break;
+        case 'p': port = atoi(optarg); break;
+        case 'n': name = optarg; break;
+        case 'm': mac = optarg; break;
+        case 'd': delay = atoi(optarg); break;
+        case 's': skip = atoi(optarg); break;
+        case 'x': count = atoi(optarg); break;
+        default: usage(argv[0]);
+        }
+    }
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if(fd < 0) {
+        perror("socket");
+        return 1;
+    }
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+
+    struct sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port = htons(port);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    if(bindAddr && !inet_aton(bindAddr, &local.sin_addr)) {
+        fprintf(stderr, "bad address %s\n", bindAddr);
+        return 2;
+    }
+    if(bind(fd, (struct sockaddr *) &local, sizeof(local)) < 0) {
+        perror("bind");
+        return 1;
+    }
+
+    printf("wxdiscover: %s (%s) listening on port %d\n", name, mac, port);
+    fflush(stdout);
+
+    for(;;) {
+        unsigned char buf[1500];
+        struct sockaddr_in peer;
+        socklen_t plen = sizeof(peer);
+        int len = recvfrom(fd, buf, sizeof(buf), 0, (struct sockaddr *) &peer, &plen);
+        if(len < 0) {
+            perror("recvfrom");
+            return 1;
+        }
+
+        double t = now();
+        queries++;
+        printf("query %d from %s:%d len %d", queries,
+               inet_ntoa(peer.sin_addr), ntohs(peer.sin_port), len);
+        if(last > 0)
+            printf(" after %.3f s", t - last);
+        last = t;
+
+        if(queries <= skip) {
+            printf(" skipped\n");
+        }
+        else if(bindAddr && alreadyFound(buf, len, local.sin_addr)) {
+            printf(" already found\n");
+        }
+        else {
+            char reply[512];
+            int rlen;
+            if(delay > 0)
+                usleep(delay * 1000);
+            rlen = snprintf(reply, sizeof(reply),
+                "{\"name\": \"%s\", \"description\": \"SimpleIDE test module\", "
+                "\"reset pin\": \"12\", \"rx pullup\": \"disabled\", "
+                "\"mac address\": \"%s\"}", name, mac);
+            if(sendto(fd, reply, rlen, 0, (struct sockaddr *) &peer, plen) < 0)
+                perror("sendto");
+            printf(" replied\n");
+        }
+        fflush(stdout);
+
+        if(count > 0 && queries >= count)
+            break;
+    }
+
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,277 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * wxserver - stand in for the serial bridge of a Parallax WX module.
+ *
+ * SimpleIDE's terminal talks to a WX module over a plain TCP connection
+ * to port 23. This server accepts that connection and does two things:
+ *
+ * It logs every read from the socket with its size and the time since
+ * the previous read. XEsp8266port coalesces writes for 2 ms or until
+ * 1 KB is queued, so typing should arrive as small reads at least 2 ms
+ * apart and a paste or Send File as reads of about 1 KB. A summary
+ * with the read count, size range and smallest gap is printed when the
+ * connection closes.
+ *
+ * With -f it floods the terminal with numbered lines while echoing.
+ * That keeps Console::updateReady() busy in processEvents() so new
+ * data arrives while it is running. Save the terminal text and check
+ * it with -V: every line must be there exactly once and in order, which
+ * fails if the wifiUpdating re-entry guard lets a nested call consume
+ * the receive buffer.
+ *
+ * Build: cc -o wxserver wxserver.c   (or make in this directory)
+ *
+ * Usage: wxserver [-p port] [-f lines_per_second] [-n lines] [-q]
+ *        wxserver -V saved_terminal_text
+ *
+ *   -p port    listen port, default 23 (needs privileges)
+ *   -f rate    send numbered lines at this rate, 0 for as fast as possible
+ *   -n lines   stop flooding after this many lines, default 100000
+ *   -q         don't log each read, only the summary
+ *   -V file    check a saved flood for missing or repeated lines
+ */
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SER_PORT        23
+#define COALESCE_MS     2
+#define COALESCE_SIZE   1024
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-p port] [-f lines_per_second] [-n lines] [-q]\n"
+                    "       %s -V saved_terminal_text\n", prog, prog);
+    exit(2);
+}
+
+/*
+ * Check that a saved flood has lines 0 to N in order with no repeats.
+ * propemu -r flood sends the same lines.
+ * Text before the first numbered line, such as typed echo, is ignored.
+ */
+static int verify(const char *fileName)
+{
+    FILE *fp = fopen(fileName, "r");
+    if(!fp) {
+        perror(fileName);
+        return 2;
+    }
+    char line[256];
+    long expect = -1;
+    long lineNum = 0;
+    int errors = 0;
+    while(fgets(line, sizeof(line), fp)) {
+        char *end;
+        lineNum++;
+        if(strncmp(line, "line ", 5))
+            continue;
+        long n = strtol(line + 5, &end, 10);
+        if(end == line + 5)
+            continue;
+        if(expect < 0)
+            expect = n;
+        if(n != expect) {
+            printf("line %ld: expected %ld got %ld\n", lineNum, expect, n);
+            if(++errors > 20)
+                break;
+        }
+        expect = n + 1;
+    }
+    fclose(fp);
+    if(expect < 0) {
+        printf("%s: no flood lines found\n", fileName);
+        return 1;
+    }
+    printf("%s: %s, last line %ld\n", fileName, errors ? "FAILED" : "ok", expect - 1);
+    return errors ? 1 : 0;
+}
+
+/*
+ * Serve one connection until the client closes it.
+ */
+static void serve(int fd, double rate, long lines, int quiet)
+{
+    long reads = 0;
+    long bytes = 0;
+    long smallest = -1;
+    long largest = 0;
+    long full = 0;
+    double minGap = -1;
+    double last = 0;
+    long sent = 0;
+    double start = now();
+    char out[64];
+    int outlen = 0;
+    int outpos = 0;
+
+    for(;;) {
+        struct pollfd pfd;
+        int timeout = -1;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+
+        if(rate >= 0 && sent < lines) {
+            double due = (rate > 0) ? start + sent / rate : 0;
+            double wait = due - now();
+            if(outpos < outlen || wait <= 0)
+                pfd.events |= POLLOUT;
+            else
+                timeout = (int)(wait * 1000) + 1;
+        }
+
+        if(poll(&pfd, 1, timeout) < 0) {
+            if(errno == EINTR)
+                continue;
+            perror("poll");
+            break;
+        }
+
+        if(pfd.revents & (POLLIN | POLLHUP | POLLERR)) {
+            char buf[8192];
+            int len = recv(fd, buf, sizeof(buf), 0);
+            if(len <= 0)
+                break;
+            double t = now();
+            reads++;
+            bytes += len;
+            if(smallest < 0 || len < smallest)
+                smallest = len;
+            if(len > largest)
+                largest = len;
+            if(len >= COALESCE_SIZE)
+                full++;
+            if(!quiet) {
+                printf("read %5d bytes", len);
+                if(last > 0)
+                    printf(" after %8.3f ms", (t - last) * 1000);
+                printf("\n");
+            }
+            if(last > 0 && (minGap < 0 || t - last < minGap))
+                minGap = t - last;
+            last = t;
+            /* echo like a terminal program on the Propeller would */
+            if(send(fd, buf, len, MSG_NOSIGNAL) < 0)
+                break;
+        }
+
+        if(pfd.revents & POLLOUT) {
+            if(outpos >= outlen) {
+                outlen = snprintf(out, sizeof(out), "line %ld\r\n", sent);
+                outpos = 0;
+                sent++;
+            }
+            int rc = send(fd, out + outpos, outlen - outpos, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if(rc < 0 && errno != EAGAIN)
+                break;
+            if(rc > 0)
+                outpos += rc;
+        }
+    }
+
+    printf("closed: %ld reads, %ld bytes", reads, bytes);
+    if(reads > 0)
+        printf(", size %ld to %ld, %ld of %d or more", smallest, largest, full, COALESCE_SIZE);
+    if(minGap >= 0)
+        printf(", smallest gap %.3f ms", minGap * 1000);
+    if(sent > 0)
+        printf(", %ld lines sent", sent);
+    printf("\n");
+    if(minGap >= 0 && minGap * 1000 < COALESCE_MS && largest < COALESCE_SIZE)
+        printf("note: reads closer than %d ms that aren't full, writes may not be coalesced\n", COALESCE_MS);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    int port = SER_PORT;
+    double rate = -1;
+    long lines = 100000;
+    int quiet = 0;
+    int opt;
+
+    while((opt = getopt(argc, argv, "p:f:n:qV:")) != -1) {
+        switch(opt) {
+        case 'p': port = atoi(optarg); break;
+        case 'f': rate = atof(optarg); break;
+        case 'n': lines = atol(optarg); break;
+        case 'q': quiet = 1; break;
+        case 'V': return verify(optarg);
+        default: usage(argv[0]);
+        }
+    }
+
+    int lfd = socket(AF_INET, SOCK_STREAM, 0);
+    if(lfd < 0) {
+        perror("socket");
+        return 1;
+    }
+    int on = 1;
+    setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    struct sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port = htons(port);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    if(bind(lfd, (struct sockaddr *) &local, sizeof(local)) < 0) {
+        perror("bind");
+        return 1;
+    }
+    if(listen(lfd, 1) < 0) {
+        perror("listen");
+        return 1;
+    }
+
+    printf("wxserver: listening on port %d\n", port);
+    fflush(stdout);
+
+    for(;;) {
+        int fd = accept(lfd, NULL, NULL);
+        if(fd < 0) {
+            if(errno == EINTR)
+                continue;
+            perror("accept");
+            return 1;
+        }
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        printf("connected\n");
+        fflush(stdout);
+        serve(fd, rate, lines, quiet);
+        close(fd);
+    }
+    return 0;
+}
@@ -0,0 +1,617 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "trigramindex.h"
+#include "projectsearch.h"
+
+#define INDEX_MAGIC     0x54524947  // "TRIG"
+#define INDEX_VERSION   1
+#define INDEX_FILE      "codeindex.dat"
+
+#define TRIGRAM(a,b,c)  (((a) << 16) | ((b) << 8) | (c))
+
+/*
+ * Case fold a character to 8 bits. Different characters may share a
+ * value; that only adds candidates, it never loses one.
+ */
+static inline quint32 foldChar(ushort u)
+{
+    if(u < 128) {
+        if(u >= 'A' && u <= 'Z')
+            u += 'a'-'A';
+        return u;
+    }
+    u = QChar(u).toCaseFolded().unicode();
+    return u < 128 ? u : 0x80 | (u & 0x7f);
+}
+
+static void addTrigrams(const QString &text, QSet<quint32> *grams)
+{
+    const QChar *s = text.constData();
+    int len = text.length();
+    if(len < 3)
+        return;
+    quint32 a = foldChar(s[0].unicode());
+    quint32 b = foldChar(s[1].unicode());
+    for(int n = 2; n < len; n++) {
+        quint32 c = foldChar(s[n].unicode());
+        grams->insert(TRIGRAM(a,b,c));
+        a = b;
+        b = c;
+    }
+}
+
+static qint64 modifiedTime(const QString &path)
+{
+    QFileInfo info(path);
+    if(!info.exists())
+        return -1;
+    return info.lastModified().toMSecsSinceEpoch();
+}
+
+TrigramIndex::TrigramIndex(QObject *parent) :
+    QThread(parent)
+{
+    stopping = false;
+    ready = false;
+    dirty = false;
+    dead = 0;
+    connect(this, SIGNAL(watchDirs(QStringList)), this, SLOT(addWatches(QStringList)));
+    connect(&watcher, SIGNAL(directoryChanged(QString)), this, SLOT(dirChanged(QString)));
+}
+
+TrigramIndex::~TrigramIndex()
+{
+    mutex.lock();
+    stopping = true;
+    wake.wakeAll();
+    mutex.unlock();
+    wait();
+}
+
+/**
+ * Index the sources under the given folders. The saved index is loaded
+ * first if it was made for the same folders.
+ * @param list folders to index, searched recursively.
+ */
+void TrigramIndex::setRoots(const QStringList &list)
+{
+    if(isRunning()) {
+        mutex.lock();
+        stopping = true;
+        wake.wakeAll();
+        mutex.unlock();
+        wait();
+    }
+    if(watcher.directories().count() > 0)
+        watcher.removePaths(watcher.directories());
+
+    mutex.lock();
+    roots.clear();
+    foreach(QString s, list) {
+        s = QDir::cleanPath(QDir::fromNativeSeparators(s));
+        if(s.length() > 0 && QDir(s).exists() && !roots.contains(s))
+            roots.append(s);
+    }
+    stopping = false;
+    ready = false;
+    dirty = false;
+    dirQueue.clear();
+    fileQueue.clear();
+    knownDirs.clear();
+    entries.clear();
+    ids.clear();
+    postings.clear();
+    dead = 0;
+    mutex.unlock();
+
+#ifdef QT5
+    QString data = QStandardPaths::writableLocation(QStandardPaths::DataLocation);
+#else
+    QString data = QDesktopServices::storageLocation(QDesktopServices::DataLocation);
+#endif
+    if(data.isEmpty())
+        data = QDir::homePath()+"/.simpleide";
+    QDir().mkpath(data);
+    indexFileName = data+"/"+INDEX_FILE;
+
+    if(roots.count() > 0)
+        start(QThread::LowestPriority);
+}
+
+/**
+ * @returns true once a saved or freshly built index can answer queries.
+ */
+bool TrigramIndex::isReady()
+{
+    QMutexLocker lock(&mutex);
+    return ready;
+}
+
+/**
+ * @returns full path of every indexed file.
+ */
+QStringList TrigramIndex::files()
+{
+    QMutexLocker lock(&mutex);
+    return ids.keys();
+}
+
+/**
+ * Drop the files that can't contain the pattern.
+ * Files not indexed, waiting to be read again, or changed since they
+ * were indexed are kept, and the changed ones are queued.
+ * @param files full paths to filter.
+ * @param pattern text or regular expression searched for.
+ * @returns the files that may hold a match, in their original order.
+ */
+QStringList TrigramIndex::narrow(const QStringList &files, const QString &pattern, bool regex)
+{
+    QStringList list;
+    QStringList stale;
+
+    mutex.lock();
+    QSet<int> hits;
+    if(!ready || !candidateIds(pattern, regex, &hits)) {
+        mutex.unlock();
+        return files;
+    }
+    foreach(const QString &file, files) {
+        QString path = QDir::cleanPath(file);
+        int id = ids.value(path, -1);
+        if(id < 0 || fileQueue.contains(path)) {
+            list.append(file);
+        }
+        else if(modifiedTime(file) != entries[id].mtime) {
+            list.append(file);
+            stale.append(file);
+        }
+        else if(hits.contains(id)) {
+            list.append(file);
+        }
+    }
+    mutex.unlock();
+
+    foreach(const QString &file, stale)
+        fileChanged(file);
+    return list;
+}
+
+/**
+ * Runs of text every match of the pattern must contain.
+ * For a regular expression only literal text outside of groups,
+ * character classes and optional items is used, and an alternative
+ * at the top level gives nothing.
+ * @returns empty if the pattern gives nothing to narrow by.
+ */
+QStringList TrigramIndex::literals(const QString &pattern, bool regex)
+{
+    QStringList list;
+    if(!regex) {
+        if(pattern.length() >= 3)
+            list.append(pattern);
+        return list;
+    }
+
+    QString run;
+    int depth = 0;
+    int len = pattern.length();
+    for(int n = 0; n < len; n++) {
+        QChar c = pattern.at(n);
+        if(c == '\\' && n+1 < len) {
+            c = pattern.at(++n);
+            if(c.isLetterOrNumber()) {
+                /* \d \w \b \x41 and such */
+                if(run.length() >= 3)
+                    list.append(run);
+                run.clear();
+                continue;
+            }
+        }
+        else if(c == '[') {
+            n++;
+            if(n < len && pattern.at(n) == '^')
+                n++;
+            if(n < len && pattern.at(n) == ']')
+                n++;
+            for(; n < len && pattern.at(n) != ']'; n++) {
+                if(pattern.at(n) == '\\')
+                    n++;
+            }
+            if(run.length() >= 3)
+                list.append(run);
+            run.clear();
+            continue;
+        }
+        else if(c == '|' && depth == 0) {
+            return QStringList();
+        }
+        else if(QString("()|.^$+*?{").contains(c)) {
+            if(c == '(')
+                depth++;
+            if(c == ')' && depth > 0)
+                depth--;
+            /* the item before these may be left out */
+            if(c == '*' || c == '?' || c == '{')
+                run.chop(1);
+            if(c == '{') {
+                while(n < len && pattern.at(n) != '}')
+                    n++;
+            }
+            if(run.length() >= 3)
+                list.append(run);
+            run.clear();
+            continue;
+        }
+        if(depth == 0)
+            run.append(c);
+    }
+    if(run.length() >= 3)
+        list.append(run);
+    return list;
+}
+
+/*
+ * Ids of indexed files holding every trigram of the pattern.
+ * Returns false if the pattern has no trigrams. Called with the lock held.
+ */
+bool TrigramIndex::candidateIds(const QString &pattern, bool regex, QSet<int> *result)
+{
+    QStringList runs = literals(pattern, regex);
+    if(runs.isEmpty())
+        return false;
+
+    QSet<quint32> grams;
+    foreach(const QString &s, runs)
+        addTrigrams(s, &grams);
+
+    /* intersect starting from the shortest list */
+    QList<const QVector<int> *> lists;
+    foreach(quint32 g, grams) {
+        QHash<quint32, QVector<int> >::const_iterator it = postings.constFind(g);
+        if(it == postings.constEnd())
+            return true;
+        const QVector<int> *v = &it.value();
+        int n = 0;
+        while(n < lists.count() && lists[n]->count() < v->count())
+            n++;
+        lists.insert(n, v);
+    }
+
+    QVector<int> found = *lists[0];
+    for(int n = 1; n < lists.count() && found.count() > 0; n++) {
+        const QVector<int> &v = *lists[n];
+        QVector<int> both;
+        int a = 0;
+        int b = 0;
+        while(a < found.count() && b < v.count()) {
+            if(found[a] < v[b])
+                a++;
+            else if(found[a] > v[b])
+                b++;
+            else {
+                both.append(found[a]);
+                a++;
+                b++;
+            }
+        }
+        found = both;
+    }
+    foreach(int id, found) {
+        if(entries[id].live)
+            result->insert(id);
+    }
+    return true;
+}
+
+/**
+ * Queue a saved or changed file to be read again.
+ */
+void TrigramIndex::fileChanged(const QString &fileName)
+{
+    if(!isSource(fileName))
+        return;
+    QString path = QDir::cleanPath(QDir::fromNativeSeparators(fileName));
+    QMutexLocker lock(&mutex);
+    bool inside = false;
+    foreach(const QString &root, roots) {
+        if(path.startsWith(root+"/"))
+            inside = true;
+    }
+    if(inside && !fileQueue.contains(path)) {
+        fileQueue.append(path);
+        wake.wakeAll();
+    }
+}
+
+void TrigramIndex::addWatches(QStringList dirs)
+{
+    if(dirs.count() > 0)
+        watcher.addPaths(dirs);
+}
+
+void TrigramIndex::dirChanged(const QString &dir)
+{
+    QMutexLocker lock(&mutex);
+    if(!dirQueue.contains(dir)) {
+        dirQueue.append(dir);
+        wake.wakeAll();
+    }
+}
+
+void TrigramIndex::run()
+{
+    load();
+
+    /* bring the index up to date with the disk */
+    QStringList dirs;
+    foreach(const QString &root, roots) {
+        prune(root);
+        dirs.append(root);
+        knownDirs.insert(root);
+        crawl(root, &dirs);
+    }
+    emit watchDirs(dirs);
+
+    mutex.lock();
+    ready = true;
+    while(!stopping) {
+        if(fileQueue.count() > 0) {
+            QString path = fileQueue.takeFirst();
+            mutex.unlock();
+            /* time stamps may only have second resolution, so a file saved
+             * twice in one second looks unchanged; queued files are read
+             * whatever their time stamp says */
+            qint64 mtime = modifiedTime(path);
+            if(mtime < 0)
+                removeFile(path);
+            else
+                indexFile(path, mtime);
+            mutex.lock();
+        }
+        else if(dirQueue.count() > 0) {
+            QString dir = dirQueue.takeFirst();
+            mutex.unlock();
+            dirs.clear();
+            prune(dir);
+            if(QDir(dir).exists())
+                crawl(dir, &dirs);
+            else
+                knownDirs.remove(dir);
+            if(dirs.count() > 0)
+                emit watchDirs(dirs);
+            mutex.lock();
+        }
+        else if(dirty) {
+            mutex.unlock();
+            save();
+            mutex.lock();
+        }
+        else {
+            wake.wait(&mutex);
+        }
+    }
+    mutex.unlock();
+}
+
+/*
+ * Index new and changed sources in a folder. Folders not seen before
+ * are searched too and added to the list to watch.
+ */
+void TrigramIndex::crawl(const QString &dir, QStringList *dirs)
+{
+    QDir d(dir);
+    QFileInfoList list = d.entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+    foreach(const QFileInfo &info, list) {
+        if(stopping)
+            return;
+        QString path = info.absoluteFilePath();
+        if(info.isDir()) {
+            if(info.fileName().startsWith(".") || knownDirs.contains(path))
+                continue;
+            knownDirs.insert(path);
+            dirs->append(path);
+            crawl(path, dirs);
+        }
+        else if(isSource(path)) {
+            qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+            if(mtime != indexedTime(path))
+                indexFile(path, mtime);
+        }
+    }
+}
+
+/*
+ * Remove indexed files under a folder that no longer exist.
+ */
+void TrigramIndex::prune(const QString &dir)
+{
+    QStringList list;
+    mutex.lock();
+    QHash<QString,int>::const_iterator it;
+    for(it = ids.constBegin(); it != ids.constEnd(); ++it) {
+        if(it.key().startsWith(dir+"/"))
+            list.append(it.key());
+    }
+    mutex.unlock();
+
+    foreach(const QString &path, list) {
+        if(!QFile::exists(path))
+            removeFile(path);
+    }
+}
+
+/*
+ * Files get a new id each time they are indexed. The old id is marked
+ * dead and left in the lists until the index is saved, so lists stay
+ * sorted and nothing has to be searched to remove it.
+ */
+void TrigramIndex::indexFile(const QString &path, qint64 mtime)
+{
+    QSet<quint32> grams;
+    addTrigrams(ProjectSearch::readFile(path), &grams);
+
+    QMutexLocker lock(&mutex);
+    int old = ids.value(path, -1);
+    if(old >= 0) {
+        entries[old].live = false;
+        dead++;
+    }
+    Entry e;
+    e.path = path;
+    e.mtime = mtime;
+    e.live = true;
+    int id = entries.count();
+    entries.append(e);
+    ids.insert(path, id);
+    foreach(quint32 g, grams)
+        postings[g].append(id);
+    dirty = true;
+}
+
+void TrigramIndex::removeFile(const QString &path)
+{
+    QMutexLocker lock(&mutex);
+    int id = ids.value(path, -1);
+    if(id < 0)
+        return;
+    ids.remove(path);
+    entries[id].live = false;
+    dead++;
+    dirty = true;
+}
+
+qint64 TrigramIndex::indexedTime(const QString &path)
+{
+    QMutexLocker lock(&mutex);
+    int id = ids.value(path, -1);
+    return id < 0 ? -1 : entries[id].mtime;
+}
+
+bool TrigramIndex::isSource(const QString &fileName)
+{
+    QString ext = fileName.mid(fileName.lastIndexOf(".")+1).toLower();
+    return ext == "c" || ext == "cpp" || ext == "h" || ext == "s" || ext == "spin";
+}
+
+/*
+ * Dead ids are dropped and the rest numbered again in order before
+ * writing. The lists are copied under the lock and written without it.
+ */
+void TrigramIndex::save()
+{
+    mutex.lock();
+    if(dead > 0) {
+        QVector<int> map(entries.count(), -1);
+        QVector<Entry> live;
+        for(int n = 0; n < entries.count(); n++) {
+            if(entries[n].live) {
+                map[n] = live.count();
+                live.append(entries[n]);
+            }
+        }
+        QHash<quint32, QVector<int> >::iterator it = postings.begin();
+        while(it != postings.end()) {
+            QVector<int> &v = it.value();
+            int out = 0;
+            for(int n = 0; n < v.count(); n++) {
+                if(map[v[n]] >= 0)
+                    v[out++] = map[v[n]];
+            }
+            v.resize(out);
+            if(out == 0)
+                it = postings.erase(it);
+            else
+                ++it;
+        }
+        entries = live;
+        ids.clear();
+        for(int n = 0; n < entries.count(); n++)
+            ids.insert(entries[n].path, n);
+        dead = 0;
+    }
+    QStringList rootList = roots;
+    QVector<Entry> list = entries;
+    QHash<quint32, QVector<int> > lists = postings;
+    dirty = false;
+    mutex.unlock();
+
+    QString tmp = indexFileName+".tmp";
+    QFile file(tmp);
+    if(!file.open(QFile::WriteOnly | QFile::Truncate))
+        return;
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << (quint32) INDEX_MAGIC << (qint32) INDEX_VERSION << rootList;
+    out << (qint32) list.count();
+    foreach(const Entry &e, list)
+        out << e.path << e.mtime;
+    out << lists;
+    file.close();
+
+    QFile::remove(indexFileName);
+    QFile::rename(tmp, indexFileName);
+}
+
+/*
+ * Load the saved index if it was made for the same folders.
+ * Queries can use it right away; the crawl that follows reads
+ * only the files that changed since.
+ */
+void TrigramIndex::load()
+{
+    QFile file(indexFileName);
+    if(!file.open(QFile::ReadOnly))
+        return;
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic = 0;
+    qint32 version = 0;
+    QStringList rootList;
+    in >> magic >> version;
+    if(magic != INDEX_MAGIC || version != INDEX_VERSION)
+        return;
+    in >> rootList;
+    if(rootList != roots)
+        return;
+
+    qint32 count = 0;
+    in >> count;
+    QVector<Entry> list;
+    for(int n = 0; n < count && in.status() == QDataStream::Ok; n++) {
+        Entry e;
+        in >> e.path >> e.mtime;
+        e.live = true;
+        list.append(e);
+    }
+    QHash<quint32, QVector<int> > lists;
+    in >> lists;
+    file.close();
+    if(in.status() != QDataStream::Ok)
+        return;
+
+    QMutexLocker lock(&mutex);
+    entries = list;
+    postings = lists;
+    ids.clear();
+    for(int n = 0; n < entries.count(); n++)
+        ids.insert(entries[n].path, n);
+    ready = true;
+}
@@ -0,0 +1,98 @@
+/*
+ * This file is part of the Parallax Propeller SimpleIDE development environment.
+ *
+ * Copyright (C) 2014 Parallax Incorporated
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include "qtversion.h"
+
+/*
+ * Trigram index of the source files under a set of folders.
+ * Every case folded run of three characters maps to the files holding
+ * it, so a search only has to scan files that contain every trigram of
+ * the text it looks for. The index is built on this thread, saved to the
+ * application data folder and reloaded at start, so only files whose
+ * time stamp changed are read again. Folder watches and fileChanged()
+ * keep it current; files changed on disk since they were indexed are
+ * always treated as candidates until they are read again.
+ */
+class TrigramIndex : public QThread
+{
+    Q_OBJECT
+public:
+    explicit TrigramIndex(QObject *parent = 0);
+    ~TrigramIndex();
+
+    void setRoots(const QStringList &roots);
+    bool isReady();
+    QStringList files();
+
+    QStringList narrow(const QStringList &files, const QString &pattern, bool regex);
+    static QStringList literals(const QString &pattern, bool regex);
+
+public slots:
+    void fileChanged(const QString &fileName);
+
+signals:
+    void watchDirs(QStringList dirs);
+
+private slots:
+    void addWatches(QStringList dirs);
+    void dirChanged(const QString &dir);
+
+protected:
+    void run();
+
+private:
+    typedef struct {
+        QString path;
+        qint64  mtime;
+        bool    live;
+    } Entry;
+
+    void    load();
+    void    save();
+    void    crawl(const QString &dir, QStringList *dirs);
+    void    prune(const QString &dir);
+    void    indexFile(const QString &path, qint64 mtime);
+    void    removeFile(const QString &path);
+    qint64  indexedTime(const QString &path);
+    bool    candidateIds(const QString &pattern, bool regex, QSet<int> *ids);
+    static bool isSource(const QString &fileName);
+
+    QMutex          mutex;
+    QWaitCondition  wake;
+    bool            stopping;
+    bool            ready;
+    bool            dirty;
+    QStringList     roots;
+    QString         indexFileName;
+    QStringList     dirQueue;
+    QStringList     fileQueue;
+    QSet<QString>   knownDirs;      // worker thread only
+
+    QVector<Entry>  entries;
+    QHash<QString,int> ids;         // path to live entry
+    QHash<quint32, QVector<int> > postings;
+    int             dead;
+
+    QFileSystemWatcher watcher;
+};
+
+#endif // TRIGRAMINDEX_H
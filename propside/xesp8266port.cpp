@@ -4,6 +4,12 @@
 XEsp8266port::XEsp8266port(QObject *parent) : QObject(parent), socket(0), notifier(0), connected(false), signalsConnected(false)
 {
     isopen = false;
+    rxbuff.reserve(RX_BUFSIZE);
+    txbuff.reserve(TX_COALESCE_SIZE);
+    txTimer.setSingleShot(true);
+    txTimer.setInterval(TX_COALESCE_MS);
+    connect(&txTimer, SIGNAL(timeout()), this, SLOT(flushWrite()));
+    resetStats();
 }
 
 bool XEsp8266port::open(QHostAddress addr, qint64 baudrate)
@@ -42,24 +48,30 @@ bool XEsp8266port::isSequential() const
 void XEsp8266port::close()
 {
     if (isopen || socket.isOpen()) {
+        flushWrite();
         socket.close();
     }
+    txTimer.stop();
+    txbuff.clear();
     isopen = false;
 }
 
+/*
+ * Discard received data. Reads straight into the receive buffer
+ * instead of line by line.
+ */
 void XEsp8266port::flush()
 {
-    char buf[BUFSIZ];
-    int rc = 0;
-
     qDebug() << "flush Socket.State" << socket.state();
 
     if (socket.state() != QTcpSocket::ConnectedState) return;
-    while (socket.bytesAvailable()) {
-        rc = socket.bytesAvailable();
-        rc = (rc < BUFSIZ) ? rc : BUFSIZ-1;
-        socket.readLine(buf, rc);
+    rxbuff.resize(RX_BUFSIZE);
+    while (socket.bytesAvailable() > 0) {
+        if (socket.read(rxbuff.data(), RX_BUFSIZE) < 1)
+            break;
     }
+    rxbuff.resize(0);
+    rxWaiting.invalidate();
 }
 
 /*
@@ -88,6 +100,39 @@ QByteArray XEsp8266port::readAll()
     return ba;
 }
 
+/*
+ * Read up to RX_BUFSIZE bytes into the reusable receive buffer and
+ * return it. The buffer is only valid until the next call, so the
+ * caller should consume it in place rather than keep it.
+ */
+const QByteArray &XEsp8266port::readBuffer()
+{
+    rxbuff.resize(RX_BUFSIZE);
+    qint64 rlen = 0;
+    if (socket.state() == QTcpSocket::ConnectedState)
+        rlen = socket.read(rxbuff.data(), RX_BUFSIZE);
+    if (rlen < 0)
+        rlen = 0;
+    rxbuff.resize(rlen);
+
+    if (rlen > 0) {
+        stats.rxBytes += rlen;
+        stats.rxReads++;
+        if (rxWaiting.isValid()) {
+            qint64 us = rxWaiting.nsecsElapsed()/1000;
+            stats.rxLatencyTotalUs += us;
+            if (us > stats.rxLatencyMaxUs)
+                stats.rxLatencyMaxUs = us;
+        }
+    }
+    if (socket.bytesAvailable() > 0)
+        rxWaiting.start();
+    else
+        rxWaiting.invalidate();
+
+    return rxbuff;
+}
+
 int XEsp8266port::read(char *buf, qint64 len)
 {
     //char *buffer = new char[len+1];
@@ -96,16 +141,68 @@ int XEsp8266port::read(char *buf, qint64 len)
     return rlen;
 }
 
-int XEsp8266port::write(QByteArray barry, int len)
+/*
+ * Writes are coalesced for TX_COALESCE_MS so that typing and small
+ * terminal sends go out in one packet now that Nagle is disabled.
+ * tools/wxserver logs the reads a module would see.
+ */
+int XEsp8266port::write(const char *data, qint64 len)
 {
-    qint64 rc = 0;
+    if(socket.state() != QTcpSocket::ConnectedState)
+        return 0;
+
+    txbuff.append(data, len);
+    if (txbuff.length() >= TX_COALESCE_SIZE)
+        flushWrite();
+    else if (!txTimer.isActive())
+        txTimer.start();
+    return len;
+}
 
-    qDebug() << "write Socket.State" << socket.state();
+void XEsp8266port::flushWrite()
+{
+    txTimer.stop();
+    if (txbuff.isEmpty())
+        return;
+    if (socket.state() == QTcpSocket::ConnectedState) {
+        qint64 rc = socket.write(txbuff.constData(), txbuff.length());
+        if (rc > 0) {
+            stats.txBytes += rc;
+            stats.txPackets++;
+        }
+        else {
+            qDebug() << "flushWrite failed" << socket.errorString();
+            stats.txDropped += txbuff.length();
+        }
+    }
+    else {
+        stats.txDropped += txbuff.length();
+    }
+    txbuff.resize(0);
+}
 
-    if(socket.state() != QTcpSocket::ConnectedState)
-        return rc;
-    rc = socket.write(barry.constData(), (qint64)len);
-    return rc;
+XEspStats XEsp8266port::getStats() const
+{
+    return stats;
+}
+
+void XEsp8266port::resetStats()
+{
+    stats.rxBytes = 0;
+    stats.txBytes = 0;
+    stats.rxReads = 0;
+    stats.txPackets = 0;
+    stats.rxLatencyTotalUs = 0;
+    stats.rxLatencyMaxUs = 0;
+    stats.txDropped = 0;
+}
+
+/*
+ * Received bytes still waiting in the socket.
+ */
+qint64 XEsp8266port::rxQueued() const
+{
+    return socket.bytesAvailable();
 }
 
 void XEsp8266port::setBaudRate(qint64 baudrate)
@@ -146,6 +243,8 @@ void XEsp8266port::socketConnected()
     qDebug() << "socketConnected";
 
     connected = true;
+    // terminal traffic is interactive, don't let Nagle hold small packets
+    socket.setSocketOption(QAbstractSocket::LowDelayOption, 1);
 #ifndef Q_OS_MAC
     notifier = new QSocketNotifier(socket.socketDescriptor(), QSocketNotifier::Exception, this);
     connect(notifier, SIGNAL(activated(int)), this, SLOT(socketException(int)));
@@ -167,6 +266,8 @@ void XEsp8266port::socketConnectionClosed()
 void XEsp8266port::socketReadyRead()
 {
     //qDebug() << "socketReadyRead" << socket.readAll();
+    if (!rxWaiting.isValid())
+        rxWaiting.start();
     emit updateEvent(this);
 }
 
@@ -183,10 +284,11 @@ void XEsp8266port::socketException(int)
 
 bool XEsp8266port::waitForReadyRead(int ms)
 {
-    socket.waitForReadyRead(ms);
+    return socket.waitForReadyRead(ms);
 }
 
 bool XEsp8266port::waitForBytesWritten(int ms)
 {
-    socket.waitForBytesWritten(ms);
+    flushWrite();
+    return socket.waitForBytesWritten(ms);
 }
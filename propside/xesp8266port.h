@@ -5,6 +5,8 @@
 #include <QHostAddress>
 #include <QTcpSocket>
 #include <QSocketNotifier>
+#include <QTimer>
+#include <QElapsedTimer>
 
 struct XEspInfo {
     qint32 ipAddr;
@@ -15,6 +17,21 @@ struct XEspInfo {
     QString nodeID;
 };
 
+/*
+ * Transfer counters for the WiFi serial bridge.
+ * Latency is the time received data waits in the socket before
+ * the terminal reads it.
+ */
+struct XEspStats {
+    qint64 rxBytes;
+    qint64 txBytes;
+    qint64 rxReads;
+    qint64 txPackets;
+    qint64 rxLatencyTotalUs;
+    qint64 rxLatencyMaxUs;
+    qint64 txDropped;
+};
+
 class XEsp8266port : public QObject
 {
     Q_OBJECT
@@ -29,8 +46,13 @@ public:
 
     qint64 bytesAvailable() const;
     QByteArray readAll();
+    const QByteArray &readBuffer();
     int read(char *buf, qint64 len);
-    int write(QByteArray barry, int len);
+    int write(const char *data, qint64 len);
+
+    XEspStats getStats() const;
+    void resetStats();
+    qint64 rxQueued() const;
 
     void setBaudRate(qint64 baudrate);
     qint64 getBaudRate() const;
@@ -44,6 +66,9 @@ public:
 
 private:
     enum { SER_PORT = 23 };
+    enum { RX_BUFSIZE = 8192 };
+    enum { TX_COALESCE_SIZE = 1024 };
+    enum { TX_COALESCE_MS = 2 };
 
 private slots:
 
@@ -60,6 +85,7 @@ signals:
 
 public slots:
     void readyRead();
+    void flushWrite();
 
 private:
     QString port;
@@ -70,6 +96,12 @@ private:
     bool signalsConnected;
 
     QByteArray rxdata;
+    QByteArray rxbuff;
+    QByteArray txbuff;
+    QTimer     txTimer;
+
+    XEspStats     stats;
+    QElapsedTimer rxWaiting;
 
     QTcpSocket socket;
     QSocketNotifier *notifier;